@@ -15,6 +15,15 @@ uint8_t = ctypes.c_uint8
 uint16_t = ctypes.c_uint16
 uint32_t = ctypes.c_uint32
 
+# set in kowhai_version() when the library is built with KOWHAI_WIDE_NODES
+KOWHAI_VERSION_WIDE_NODES = 0x00010000
+
+# node array counts are 32 bit in libraries built with wide nodes
+if kowhai_lib.kowhai_version() & KOWHAI_VERSION_WIDE_NODES:
+    kowhai_count_t = ctypes.c_int32
+else:
+    kowhai_count_t = uint16_t
+
 # kowhai node types
 KOW_BRANCH_START = 0x00
 KOW_BRANCH_END = 0x01
@@ -33,16 +42,18 @@ class kowhai_node_t(ctypes.Structure):
     _pack_ = 1
     _fields_ = [('type_', uint16_t),
                 ('symbol', uint16_t),
-                ('count', uint16_t),
+                ('count', kowhai_count_t),
                 ('tag', uint16_t)]
     def __str__(self):
         return "kowhai_node_t(%d, %d, %d, %d)" % (self.type_, self.symbol, self.count, self.tag)
 
-# kowhai tree structure
+# kowhai tree structure (dirty and snapshot are left as None unless the tree is tracked)
 class kowhai_tree_t(ctypes.Structure):
     _pack_ = 1
     _fields_ = [('desc', ctypes.POINTER(kowhai_node_t)),
-                ('data', ctypes.c_void_p)]
+                ('data', ctypes.c_void_p),
+                ('dirty', ctypes.c_void_p),
+                ('snapshot', ctypes.c_void_p)]
 
 class kowhai_symbol_parts_t(ctypes.Structure):
     _pack_ = 1
@@ -74,6 +85,13 @@ KOW_STATUS_SCRATCH_TOO_SMALL        = 11
 KOW_STATUS_NOT_FOUND                = 12
 KOW_STATUS_INVALID_SEQUENCE         = 13
 KOW_STATUS_NO_DATA                  = 14
+KOW_STATUS_PATH_TOO_SMALL           = 15
+KOW_STATUS_UNKNOWN_ERROR            = 16
+KOW_STATUS_STALE_HANDLE             = 17
+KOW_STATUS_STACK_TOO_SMALL          = 18
+KOW_STATUS_MISALIGNED               = 19
+KOW_STATUS_OUT_OF_RANGE             = 20
+KOW_STATUS_CHECKSUM_MISMATCH        = 21
 
 #uint32_t kowhai_version(void);
 def version():
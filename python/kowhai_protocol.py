@@ -34,6 +34,19 @@ KOW_CMD_EVENT_END = 0x8F
 KOW_CMD_GET_SYMBOL_LIST = 0x90
 KOW_CMD_GET_SYMBOL_LIST_ACK = 0x9F
 KOW_CMD_GET_SYMBOL_LIST_ACK_END = 0x9E
+KOW_CMD_WRITE_DATA32 = 0xA0
+KOW_CMD_WRITE_DATA32_END = 0xA1
+KOW_CMD_WRITE_DATA32_ACK = 0xAF
+KOW_CMD_READ_DATA32 = 0xB0
+KOW_CMD_READ_DATA32_ACK = 0xBF
+KOW_CMD_READ_DATA32_ACK_END = 0xBE
+KOW_CMD_READ_DESCRIPTOR32 = 0xC0
+KOW_CMD_READ_DESCRIPTOR32_ACK = 0xCF
+KOW_CMD_READ_DESCRIPTOR32_ACK_END = 0xCE
+KOW_CMD_CALL_FUNCTION32 = 0xD0
+KOW_CMD_CALL_FUNCTION32_ACK = 0xDF
+KOW_CMD_CALL_FUNCTION32_RESULT = 0xDE
+KOW_CMD_CALL_FUNCTION32_RESULT_END = 0xDD
 
 # protocol error codes
 KOW_CMD_ERROR_INVALID_COMMAND = 0xF0
@@ -56,22 +69,24 @@ class kowhai_protocol_symbol_spec_t(ctypes.Structure):
     _fields_ = [('count', uint8_t),
                 ('array_', ctypes.POINTER(kowhai_symbol_t))]
 
+# offset and size are sent as 16 bit values except by the 32 bit commands (eg KOW_CMD_WRITE_DATA32)
 class kowhai_protocol_data_payload_memory_spec_t(ctypes.Structure):
     _pack_ = 1
     _fields_ = [('type_', uint16_t),
-                ('offset', uint16_t),
-                ('size', uint16_t)]
+                ('offset', uint32_t),
+                ('size', uint32_t)]
 
 class kowhai_protocol_data_payload_spec_t(ctypes.Structure):
     _pack_ = 1
     _fields_ = [('symbols', kowhai_protocol_symbol_spec_t),
                 ('memory', kowhai_protocol_data_payload_memory_spec_t)]
 
+# fields are sent as 16 bit values except by the 32 bit commands (eg KOW_CMD_READ_DESCRIPTOR32_ACK)
 class kowhai_protocol_descriptor_payload_spec_t(ctypes.Structure):
     _pack_ = 1
-    _fields_ = [('node_count', uint16_t),
-                ('offset', uint16_t),
-                ('size', uint16_t)]
+    _fields_ = [('node_count', uint32_t),
+                ('offset', uint32_t),
+                ('size', uint32_t)]
 
 class kowhai_protocol_id_list_t(ctypes.Structure):
     _pack_ = 1
@@ -96,10 +111,11 @@ class kowhai_protocol_function_details_t(ctypes.Structure):
     _fields_ = [('tree_in_id', uint16_t),
                 ('tree_out_id', uint16_t)]
 
+# offset and size are sent as 16 bit values except by the 32 bit commands (eg KOW_CMD_CALL_FUNCTION32)
 class kowhai_protocol_function_call_t(ctypes.Structure):
     _pack_ = 1
-    _fields_ = [('offset', uint16_t),
-                ('size', uint16_t)]
+    _fields_ = [('offset', uint32_t),
+                ('size', uint32_t)]
 
 class kowhai_protocol_event_t(ctypes.Structure):
     _pack_ = 1
@@ -1,12 +1,26 @@
 #include "kowhai.h"
+#include "kowhai_snapshot.h"
 
 #include <string.h>
+#include <stdlib.h>
 
-#define VERSION 6
+#define VERSION 7
 
 uint32_t kowhai_version(void)
 {
+#ifdef KOWHAI_WIDE_NODES
+    return VERSION | KOWHAI_VERSION_WIDE_NODES;
+#else
     return VERSION;
+#endif
+}
+
+void kowhai_tree_init(struct kowhai_tree_t *tree, struct kowhai_node_t *desc, void *data)
+{
+    tree->desc = desc;
+    tree->data = data;
+    tree->dirty = NULL;
+    tree->snapshot = NULL;
 }
 
 int kowhai_get_node_type_size(uint16_t type)
@@ -41,9 +55,97 @@ int kowhai_get_node_type_size(uint16_t type)
     }
 }
 
+void kowhai_walk_stack_init(struct kowhai_walk_stack_t *stack, struct kowhai_walk_frame_t *frames, int size)
+{
+    stack->frames = frames;
+    stack->size = size;
+    stack->depth = 0;
+    stack->max_depth = 0;
+    stack->next = NULL;
+}
+
+struct kowhai_walk_frame_t *kowhai_walk_stack_push(struct kowhai_walk_stack_t *stack, int depth)
+{
+    struct kowhai_walk_frame_t *frame = kowhai_walk_stack_frame(stack, depth);
+    if (frame != NULL && depth + 1 > stack->max_depth)
+        stack->max_depth = depth + 1;
+    return frame;
+}
+
+struct kowhai_walk_frame_t *kowhai_walk_stack_frame(struct kowhai_walk_stack_t *stack, int depth)
+{
+    if (depth < 0)
+        return NULL;
+    while (depth >= stack->size)
+    {
+        if (stack->next == NULL)
+            return NULL;
+        depth -= stack->size;
+        stack = stack->next;
+    }
+    return &stack->frames[depth];
+}
+
+// add a block of frames to the end of stack (or start it) until it has depth frames then run the walk
+static int walk_default(int depth, kowhai_walk_t walk, void *param, struct kowhai_walk_stack_t *stack, struct kowhai_walk_stack_t *last)
+{
+    struct kowhai_walk_frame_t frames[KOWHAI_WALK_STACK_DEPTH];
+    struct kowhai_walk_stack_t block;
+    int ret;
+
+    kowhai_walk_stack_init(&block, frames, KOWHAI_WALK_STACK_DEPTH);
+    if (stack == NULL)
+        stack = &block;
+    else
+        last->next = &block;
+    if (depth > KOWHAI_WALK_STACK_DEPTH)
+        ret = walk_default(depth - KOWHAI_WALK_STACK_DEPTH, walk, param, stack, &block);
+    else
+        ret = walk(param, stack);
+    if (last != NULL)
+        last->next = NULL;
+    return ret;
+}
+
+int kowhai_walk_default(int depth, kowhai_walk_t walk, void *param)
+{
+    return walk_default(depth, walk, param, NULL, NULL);
+}
+
+int kowhai_get_node_depth(const struct kowhai_node_t *node)
+{
+    int depth = 0, max_depth = 0;
+    int i = 0;
+
+    if (node->type != KOW_BRANCH_START && node->type != KOW_BRANCH_U_START)
+        return 0;
+    do
+    {
+        switch (node[i].type)
+        {
+            case KOW_BRANCH_START:
+            case KOW_BRANCH_U_START:
+                depth++;
+                if (depth > max_depth)
+                    max_depth = depth;
+                break;
+            case KOW_BRANCH_END:
+                depth--;
+                break;
+        }
+        i++;
+    }
+    while (depth > 0);
+    return max_depth;
+}
+
 // calculate the complete size of a node including all the sub-elements and array items.
-static int get_node_size(const struct kowhai_node_t *node, int *size, int *num_nodes_processed)
+// child branches are walked using the stack frames from stack->depth up
+static int get_node_size(const struct kowhai_node_t *node, int *size, int *num_nodes_processed, struct kowhai_walk_stack_t *stack)
 {
+    const struct kowhai_node_t *branch = node;
+    struct kowhai_walk_frame_t *frame;
+    int depth = stack->depth;
     int _size = 0;
     int i = 0;
 
@@ -57,38 +159,50 @@ static int get_node_size(const struct kowhai_node_t *node, int *size, int *num_n
             while (1)
             {
                 i++;
-                *num_nodes_processed = i;
                 switch ((enum kowhai_node_type)node[i].type)
                 {
                     // navigate the hierarchy info
                     case KOW_BRANCH_START:
                     case KOW_BRANCH_U_START:
+                        // save the size of this branch so far and start on the child branch
+                        frame = kowhai_walk_stack_push(stack, depth);
+                        if (frame == NULL)
+                            return KOW_STATUS_STACK_TOO_SMALL;
+                        frame->node = branch;
+                        frame->value[0] = _size;
+                        depth++;
+                        branch = &node[i];
+                        _size = 0;
+                        break;
+                    case KOW_BRANCH_END:
                     {
-                        int child_branch_size = 0;
-                        int _num_child_nodes_processed;
-                        int ret;
-                        ret = get_node_size(node + i, &child_branch_size, &_num_child_nodes_processed);
-                        if (ret != KOW_STATUS_OK)
-                            return ret;
+                        int child_branch_size;
+                        // accumulate the whole array
+                        _size *= branch->count;
+                        if (depth == stack->depth)
+                        {
+                            *num_nodes_processed = i;
+                            goto done;
+                        }
+                        // back to the parent branch
+                        child_branch_size = _size;
+                        depth--;
+                        frame = kowhai_walk_stack_frame(stack, depth);
+                        branch = frame->node;
+                        _size = frame->value[0];
                         // accumulate the branches size
-                        if (node->type == KOW_BRANCH_START)
+                        if (branch->type == KOW_BRANCH_START)
                             _size += child_branch_size;
                         else if (child_branch_size > _size)
                             _size = child_branch_size;
-                        // skip the already processed nodes
-                        i += _num_child_nodes_processed;
                         break;
                     }
-                    case KOW_BRANCH_END:
-                        // accumulate the whole array
-                        _size *= node->count;
-                        goto done;
 
                     // accumulate the size of all the other node_count
                     default:
                     {
                         int child_node_size = kowhai_get_node_type_size(node[i].type) * node[i].count;
-                        if (node->type == KOW_BRANCH_START)
+                        if (branch->type == KOW_BRANCH_START)
                             _size += child_node_size;
                         else if (child_node_size > _size)
                             _size = child_node_size;
@@ -112,20 +226,260 @@ done:
     return KOW_STATUS_OK;
 }
 
+// the parameters of a get_node_size walk run by kowhai_walk_default
+struct node_size_walk_t
+{
+    const struct kowhai_node_t *node;
+    int *size;
+    int *num_nodes_processed;
+};
+
+static int node_size_walk(void *param, struct kowhai_walk_stack_t *stack)
+{
+    struct node_size_walk_t *walk = (struct node_size_walk_t*)param;
+    return get_node_size(walk->node, walk->size, walk->num_nodes_processed, stack);
+}
+
+// get_node_size using a default sized stack, or one deep enough for the node if that is too small
+static int get_node_size_default(const struct kowhai_node_t *node, int *size, int *num_nodes_processed)
+{
+    struct kowhai_walk_frame_t frames[KOWHAI_WALK_STACK_DEPTH];
+    struct kowhai_walk_stack_t stack;
+    struct node_size_walk_t walk;
+    int ret;
+
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    ret = get_node_size(node, size, num_nodes_processed, &stack);
+    if (ret != KOW_STATUS_STACK_TOO_SMALL)
+        return ret;
+    walk.node = node;
+    walk.size = size;
+    walk.num_nodes_processed = num_nodes_processed;
+    return kowhai_walk_default(kowhai_get_node_depth(node), node_size_walk, &walk);
+}
+
 int kowhai_get_node_size(const struct kowhai_node_t *node, int *size)
 {
     int num_nodes_processed;
-    return get_node_size(node, size, &num_nodes_processed);
+    return get_node_size_default(node, size, &num_nodes_processed);
+}
+
+int kowhai_get_node_size_ex(const struct kowhai_node_t *node, int *size, struct kowhai_walk_stack_t *stack)
+{
+    int num_nodes_processed;
+    return get_node_size(node, size, &num_nodes_processed, stack);
 }
 
 int kowhai_get_node_count(const struct kowhai_node_t *node, int *count)
 {
     int size, ret;
-    ret = get_node_size(node, &size, count);
+    ret = get_node_size_default(node, &size, count);
     (*count)++;
     return ret;
 }
 
+int kowhai_get_node_count_ex(const struct kowhai_node_t *node, int *count, struct kowhai_walk_stack_t *stack)
+{
+    int size, ret;
+    ret = get_node_size(node, &size, count, stack);
+    (*count)++;
+    return ret;
+}
+
+int kowhai_check_descriptor(const struct kowhai_node_t *desc, int num_nodes)
+{
+    int depth = 0;
+    int i;
+
+    for (i = 0; i < num_nodes; i++)
+    {
+        switch (desc[i].type)
+        {
+            case KOW_BRANCH_START:
+            case KOW_BRANCH_U_START:
+                depth++;
+                break;
+            case KOW_BRANCH_END:
+                depth--;
+                break;
+            default:
+                if (kowhai_get_node_type_size(desc[i].type) < 0)
+                    return KOW_STATUS_INVALID_NODE_TYPE;
+                break;
+        }
+        if (depth <= 0)
+            break;
+    }
+    if (depth != 0 || i != num_nodes - 1)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    return KOW_STATUS_OK;
+}
+
+// populate the tables for the node at index i (and all its children), next is set to the index of the following node
+static int init_node_tables(struct kowhai_node_tables_t *tables, int i, int offset, int *next)
+{
+    const struct kowhai_node_t *desc = tables->desc;
+    int start = i;
+    int size = 0;
+    int ret;
+
+    switch (desc[start].type)
+    {
+        case KOW_BRANCH_START:
+        case KOW_BRANCH_U_START:
+        {
+            int in_union = desc[start].type == KOW_BRANCH_U_START;
+            int child_offset = offset;
+            i++;
+            while (1)
+            {
+                int child = i;
+                if (i >= tables->num_nodes)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                if (desc[i].type == KOW_BRANCH_END)
+                    break;
+                ret = init_node_tables(tables, i, child_offset, &i);
+                if (ret != KOW_STATUS_OK)
+                    return ret;
+                // accumulate the branch size (or find the largest member of a union)
+                if (!in_union)
+                {
+                    size += tables->size[child];
+                    child_offset += tables->size[child];
+                }
+                else if (tables->size[child] > size)
+                    size = tables->size[child];
+            }
+            // the branch end node
+            tables->size[i] = 0;
+            tables->node_count[i] = 1;
+            tables->data_offset[i] = offset + size;
+            i++;
+            // accumulate the whole array
+            size *= desc[start].count;
+            break;
+        }
+        case KOW_BRANCH_END:
+            // a branch end with no matching start
+            return KOW_STATUS_INVALID_DESCRIPTOR;
+        default:
+        {
+            int type_size = kowhai_get_node_type_size(desc[start].type);
+            if (type_size < 0)
+                return KOW_STATUS_INVALID_NODE_TYPE;
+            size = type_size * desc[start].count;
+            i++;
+            break;
+        }
+    }
+
+    tables->size[start] = size;
+    tables->node_count[start] = i - start;
+    tables->data_offset[start] = offset;
+    *next = i;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_init_node_tables(struct kowhai_node_tables_t *tables, const struct kowhai_node_t *desc, int num_nodes, int32_t *size, int32_t *node_count, int32_t *data_offset)
+{
+    int next, ret;
+
+    if (num_nodes < 1)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+
+    tables->desc = desc;
+    tables->num_nodes = num_nodes;
+    tables->size = size;
+    tables->node_count = node_count;
+    tables->data_offset = data_offset;
+
+    ret = init_node_tables(tables, 0, 0, &next);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+
+    // only the nodes that are part of this tree are used
+    tables->num_nodes = next;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_get_node_size_from_tables(const struct kowhai_node_tables_t *tables, const struct kowhai_node_t *node, int *size)
+{
+    int i = node - tables->desc;
+    if (i < 0 || i >= tables->num_nodes)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    *size = tables->size[i];
+    return KOW_STATUS_OK;
+}
+
+int kowhai_get_node_count_from_tables(const struct kowhai_node_tables_t *tables, const struct kowhai_node_t *node, int *count)
+{
+    int i = node - tables->desc;
+    if (i < 0 || i >= tables->num_nodes)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    *count = tables->node_count[i];
+    return KOW_STATUS_OK;
+}
+
+// search the branch starting at index i for the symbols path, offset is relative to the first array item of each parent branch
+static int get_node_from_tables(const struct kowhai_node_tables_t *tables, int i, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, int *target, int initial_branch)
+{
+    const struct kowhai_node_t *desc = tables->desc;
+    int ret;
+
+    while (desc[i].type != KOW_BRANCH_END)
+    {
+        if ((symbols->parts.name == desc[i].symbol) && (desc[i].count > symbols->parts.array_index))
+        {
+            int element_offset = (tables->size[i] / desc[i].count) * symbols->parts.array_index;
+            if (num_symbols == 1)
+            {
+                *offset = element_offset;
+                *target = i;
+                return KOW_STATUS_OK;
+            }
+            if (desc[i].type == KOW_BRANCH_START || desc[i].type == KOW_BRANCH_U_START)
+            {
+                // this is not the target node but it is possibly in this branch
+                ret = get_node_from_tables(tables, i + 1, num_symbols - 1, symbols + 1, offset, target, 0);
+                if (ret == KOW_STATUS_OK)
+                {
+                    *offset += element_offset;
+                    return ret;
+                }
+                if (ret != KOW_STATUS_INVALID_SYMBOL_PATH)
+                    return ret;
+            }
+        }
+        if (initial_branch)
+            break;
+        // skip this node and all its children
+        i += tables->node_count[i];
+    }
+
+    return KOW_STATUS_INVALID_SYMBOL_PATH;
+}
+
+int kowhai_get_node_from_tables(const struct kowhai_node_tables_t *tables, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node)
+{
+    int index_offset, target, ret;
+
+    if (tables->desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    if (num_symbols < 1)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+
+    ret = get_node_from_tables(tables, 0, num_symbols, symbols, &index_offset, &target, 1);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+
+    // the data offset table assumes all the parent array indices are 0, index_offset adds the real indices in
+    if (offset != NULL)
+        *offset = tables->data_offset[target] + index_offset;
+    if (target_node != NULL)
+        *target_node = (struct kowhai_node_t*)&tables->desc[target];
+    return KOW_STATUS_OK;
+}
+
 /**
  * @brief find a item in the tree given its path
  * @param node to start searching from for the given item
@@ -133,12 +487,15 @@ int kowhai_get_node_count(const struct kowhai_node_t *node, int *count)
  * @param symbols the path of the item to seek
  * @param offset set to number of bytes from the current node to the requested symbol
  * @param target_node placeholder for the result of the node search
- * @param num_nodes_processed how many nodes were iterated over during this function call
+ * @param stack frames to save the search state of each parent branch in (used from stack->depth up)
  * @return < 0 on failure
- * @todo find the correct index (always 0 atm)
  */
-int get_node(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node, int initial_branch, int branch_union)
+static int get_node(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node, struct kowhai_walk_stack_t *stack)
 {
+    struct kowhai_walk_frame_t *frame;
+    int base = stack->depth;
+    int depth = base;
+    int branch_union = 0;
     int i = 0;
     int _offset = 0;
     int ret;
@@ -149,44 +506,56 @@ int get_node(const struct kowhai_node_t *node, int num_symbols, const union kowh
         int skip_size;
         int skip_nodes;
 
-        switch (node[i].type)
+        if (node[i].type == KOW_BRANCH_END)
         {
-            case KOW_BRANCH_END:
-                // if we got a branch end then we didn't find it on this path
+            // if we got a branch end then we didn't find it on this path
+            if (depth == base)
                 return KOW_STATUS_INVALID_SYMBOL_PATH;
-            default:
-                // if the path symbols match and the node array count is large enough to contain our index this could be the target node
-                if ((symbols->parts.name == node[i].symbol) && (node[i].count > symbols->parts.array_index))
-                {
-                    if (num_symbols == 1)
-                    {
-                        // the symbol paths fully match in values and length so this is the node we are looking for
-                        ret = KOW_STATUS_OK;
-                        if (target_node != NULL)
-                            *target_node = (struct kowhai_node_t*)node + i;
-                        goto done;
-                    }
-                    
-                    if (node[i].type == KOW_BRANCH_START || node[i].type == KOW_BRANCH_U_START)
-                    {
-                        int branch_offset = 0;
-                        // this is not the target node but it is possibly in this branch so drill baby drill
-                        ret = get_node(node + i + 1, num_symbols - 1, symbols + 1, &branch_offset, target_node, 0, node[i].type == KOW_BRANCH_U_START);
-                        if (ret == KOW_STATUS_INVALID_SYMBOL_PATH)
-                            // branch ended without finding our target node so goto next
-                            break;
-                        // add the branch offset to current total
-                        _offset += branch_offset;
-                        goto done;
-                    }
-                }
+            // go back to the parent branch and carry on from the next node
+            depth--;
+            frame = kowhai_walk_stack_frame(stack, depth);
+            node = frame->node;
+            i = frame->index;
+            _offset = frame->value[0];
+            branch_union = frame->value[1];
+            num_symbols++;
+            symbols--;
+        }
+        // if the path symbols match and the node array count is large enough to contain our index this could be the target node
+        else if ((symbols->parts.name == node[i].symbol) && (node[i].count > symbols->parts.array_index))
+        {
+            if (num_symbols == 1)
+                // the symbol paths fully match in values and length so this is the node we are looking for
                 break;
+
+            if (node[i].type == KOW_BRANCH_START || node[i].type == KOW_BRANCH_U_START)
+            {
+                // this is not the target node but it is possibly in this branch so drill baby drill
+                frame = kowhai_walk_stack_push(stack, depth);
+                if (frame == NULL)
+                    return KOW_STATUS_STACK_TOO_SMALL;
+                frame->node = node;
+                frame->index = i;
+                frame->value[0] = _offset;
+                frame->value[1] = branch_union;
+                depth++;
+                branch_union = node[i].type == KOW_BRANCH_U_START;
+                node = node + i + 1;
+                i = 0;
+                _offset = 0;
+                num_symbols--;
+                symbols++;
+                continue;
+            }
         }
-        
-        if (initial_branch)
+
+        // only the first node of the initial branch is checked
+        if (depth == base)
             return KOW_STATUS_INVALID_SYMBOL_PATH;
         // this item is not a match so skip it (find out how many bytes and nodes to skip)
-        ret = get_node_size(node + i, &skip_size, &skip_nodes);
+        stack->depth = depth;
+        ret = get_node_size(node + i, &skip_size, &skip_nodes, stack);
+        stack->depth = base;
         if (ret != KOW_STATUS_OK)
             // propagate the error
             return ret;
@@ -195,29 +564,231 @@ int get_node(const struct kowhai_node_t *node, int num_symbols, const union kowh
         i += skip_nodes + 1;
     }
 
-done:
+    if (target_node != NULL)
+        *target_node = (struct kowhai_node_t*)node + i;
 
     // update offset return parameter
     if (offset != NULL)
     {
-        // we have the index of the target node
-        // the offset is: (the size of this node / its count) * symbol array index
-        int size;
-        ret = kowhai_get_node_size(node + i, &size);
-        if (ret != KOW_STATUS_OK)
-            return ret;
-        _offset += (size / node[i].count) * symbols->parts.array_index;
+        // the offset is: (the size of this node / its count) * symbol array index, plus the same for
+        // each parent branch and the offsets of the branches within their parents
+        while (1)
+        {
+            int size, skip_nodes;
+            stack->depth = depth;
+            ret = get_node_size(node + i, &size, &skip_nodes, stack);
+            stack->depth = base;
+            if (ret != KOW_STATUS_OK)
+                return ret;
+            _offset += (size / node[i].count) * symbols->parts.array_index;
+            if (depth == base)
+                break;
+            depth--;
+            frame = kowhai_walk_stack_frame(stack, depth);
+            node = frame->node;
+            i = frame->index;
+            _offset += frame->value[0];
+            symbols--;
+        }
         *offset = _offset;
     }
 
-    return ret;
+    return KOW_STATUS_OK;
 }
 
-int kowhai_get_node(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node)
+int kowhai_get_node_ex(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node, struct kowhai_walk_stack_t *stack)
 {
     if (node->type != KOW_BRANCH_START)
         return KOW_STATUS_INVALID_DESCRIPTOR;
-    return get_node(node, num_symbols, symbols, offset, target_node, 1, node->type == KOW_BRANCH_U_START);
+    return get_node(node, num_symbols, symbols, offset, target_node, stack);
+}
+
+// the parameters of a get_node walk run by kowhai_walk_default
+struct node_walk_t
+{
+    const struct kowhai_node_t *node;
+    int num_symbols;
+    const union kowhai_symbol_t *symbols;
+    int *offset;
+    struct kowhai_node_t **target_node;
+};
+
+static int node_walk(void *param, struct kowhai_walk_stack_t *stack)
+{
+    struct node_walk_t *walk = (struct node_walk_t*)param;
+    return kowhai_get_node_ex(walk->node, walk->num_symbols, walk->symbols, walk->offset, walk->target_node, stack);
+}
+
+int kowhai_get_node(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node)
+{
+    struct kowhai_walk_frame_t frames[KOWHAI_WALK_STACK_DEPTH];
+    struct kowhai_walk_stack_t stack;
+    struct node_walk_t walk;
+    int ret;
+
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    ret = kowhai_get_node_ex(node, num_symbols, symbols, offset, target_node, &stack);
+    if (ret != KOW_STATUS_STACK_TOO_SMALL)
+        return ret;
+    // the tree is deeper than the default stack so walk it again with enough frames
+    walk.node = node;
+    walk.num_symbols = num_symbols;
+    walk.symbols = symbols;
+    walk.offset = offset;
+    walk.target_node = target_node;
+    return kowhai_walk_default(kowhai_get_node_depth(node), node_walk, &walk);
+}
+
+int kowhai_dirty_get_size(const struct kowhai_node_t *desc, int block_size, int *size)
+{
+    int data_size;
+    int status;
+    if (block_size < 1)
+        return KOW_STATUS_BUFFER_INVALID;
+    status = kowhai_get_node_size(desc, &data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    *size = ((data_size + block_size - 1) / block_size + 7) / 8;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_dirty_init(struct kowhai_dirty_t *dirty, const struct kowhai_node_t *desc, int block_size, uint8_t *bits, int bits_size)
+{
+    int size;
+    int status = kowhai_dirty_get_size(desc, block_size, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (bits_size < size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    status = kowhai_get_node_size(desc, &dirty->size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    dirty->bits = bits;
+    dirty->block_size = block_size;
+    dirty->num_blocks = (dirty->size + block_size - 1) / block_size;
+    dirty->next = NULL;
+    memset(bits, 0, size);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_dirty_chain(struct kowhai_dirty_t *dirty, struct kowhai_dirty_t *next)
+{
+    struct kowhai_dirty_t *last;
+    struct kowhai_dirty_t *d;
+
+    if (next->size != dirty->size)
+        return KOW_STATUS_BUFFER_INVALID;
+    for (last = dirty; ; last = last->next)
+    {
+        if (last == next)
+            return KOW_STATUS_OK;
+        if (last->next == NULL)
+            break;
+    }
+    // dont let the chain loop back on itself
+    for (d = next; d != NULL; d = d->next)
+        if (d == dirty)
+            return KOW_STATUS_BUFFER_INVALID;
+    last->next = next;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_dirty_unchain(struct kowhai_dirty_t *dirty, struct kowhai_dirty_t *next)
+{
+    for (; dirty != NULL; dirty = dirty->next)
+    {
+        if (dirty->next == next)
+        {
+            dirty->next = next->next;
+            next->next = NULL;
+            return KOW_STATUS_OK;
+        }
+    }
+    return KOW_STATUS_NOT_FOUND;
+}
+
+// set or clear the bits of all the blocks a range of tree data touches
+static void set_dirty_bits(struct kowhai_dirty_t *dirty, int offset, int size, int set)
+{
+    int block, last;
+    if (size <= 0 || offset < 0)
+        return;
+    block = offset / dirty->block_size;
+    last = (offset + size - 1) / dirty->block_size;
+    if (last >= dirty->num_blocks)
+        last = dirty->num_blocks - 1;
+    for (; block <= last; block++)
+    {
+        // whole bytes of the bitmap at once
+        if ((block & 7) == 0 && block + 7 <= last)
+        {
+            dirty->bits[block / 8] = set ? 0xFF : 0;
+            block += 7;
+        }
+        else if (set)
+            dirty->bits[block / 8] |= 1 << (block & 7);
+        else
+            dirty->bits[block / 8] &= ~(1 << (block & 7));
+    }
+}
+
+void kowhai_dirty_mark(struct kowhai_dirty_t *dirty, int offset, int size)
+{
+    for (; dirty != NULL; dirty = dirty->next)
+        set_dirty_bits(dirty, offset, size, 1);
+}
+
+void kowhai_dirty_clear(struct kowhai_dirty_t *dirty, int offset, int size)
+{
+    set_dirty_bits(dirty, offset, size, 0);
+}
+
+static int dirty_bit(const struct kowhai_dirty_t *dirty, int block)
+{
+    return dirty->bits[block / 8] & (1 << (block & 7));
+}
+
+int kowhai_dirty_next(const struct kowhai_dirty_t *dirty, int start, int *offset, int *size)
+{
+    int block = start > 0 ? start / dirty->block_size : 0;
+    int first;
+
+    // skip clean blocks, a byte at a time where possible
+    while (block < dirty->num_blocks && !dirty_bit(dirty, block))
+    {
+        if ((block & 7) == 0 && dirty->bits[block / 8] == 0)
+            block += 8;
+        else
+            block++;
+    }
+    if (block >= dirty->num_blocks)
+        return KOW_STATUS_NOT_FOUND;
+
+    first = block;
+    while (block < dirty->num_blocks && dirty_bit(dirty, block))
+        block++;
+    *offset = first * dirty->block_size;
+    if (*offset < start)
+        *offset = start;
+    *size = block * dirty->block_size;
+    if (*size > dirty->size)
+        *size = dirty->size;
+    *size -= *offset;
+    return KOW_STATUS_OK;
+}
+
+// copy the pages a write is about to change into the snapshot of the tree (if it has one)
+static void preserve_snapshot(struct kowhai_tree_t *tree, int offset, int size)
+{
+    if (tree->snapshot != NULL)
+        kowhai_snapshot_preserve(tree->snapshot, offset, size);
+}
+
+// mark a write to a tree in its dirty bitmap (if it has one)
+static void mark_dirty(struct kowhai_tree_t *tree, int offset, int size)
+{
+    if (tree->dirty != NULL)
+        kowhai_dirty_mark(tree->dirty, offset, size);
 }
 
 int kowhai_read(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int read_offset, void* result, int read_size)
@@ -238,7 +809,7 @@ int kowhai_read(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol
     status = kowhai_get_node_size(node, &size);
     if (status != KOW_STATUS_OK)
         return status;
-    if (read_size + read_offset > size)
+    if (read_size > size - read_offset)
         return KOW_STATUS_NODE_DATA_TOO_SMALL;
 
     // do read
@@ -264,14 +835,267 @@ int kowhai_write(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbo
     status = kowhai_get_node_size(node, &size);
     if (status != KOW_STATUS_OK)
         return status;
-    if (write_size + write_offset > size)
+    if (write_size > size - write_offset)
         return KOW_STATUS_NODE_DATA_TOO_SMALL;
     
     // do write
+    preserve_snapshot(tree, offset + write_offset, write_size);
     memcpy((char*)tree->data + offset + write_offset, value, write_size);
+    mark_dirty(tree, offset + write_offset, write_size);
     return status;
 }
 
+// order batch items by symbol path so the items that share a path prefix are next to each other
+static int compare_batch_items(const void *a, const void *b)
+{
+    const struct kowhai_batch_item_t *left = (const struct kowhai_batch_item_t*)a;
+    const struct kowhai_batch_item_t *right = (const struct kowhai_batch_item_t*)b;
+    int i;
+
+    for (i = 0; i < left->num_symbols && i < right->num_symbols; i++)
+    {
+        if (left->symbols[i].parts.name != right->symbols[i].parts.name)
+            return left->symbols[i].parts.name < right->symbols[i].parts.name ? -1 : 1;
+        if (left->symbols[i].parts.array_index != right->symbols[i].parts.array_index)
+            return left->symbols[i].parts.array_index < right->symbols[i].parts.array_index ? -1 : 1;
+    }
+    // shorter paths first
+    return left->num_symbols - right->num_symbols;
+}
+
+// do the read or write of a batch item that resolved to node
+static void batch_access(struct kowhai_tree_t *tree, struct kowhai_batch_item_t *item, const struct kowhai_node_t *node, int offset, int write)
+{
+    int size;
+
+    if (item->offset < 0)
+    {
+        item->status = KOW_STATUS_INVALID_OFFSET;
+        return;
+    }
+
+    // check the access wont overrun the item
+    item->status = kowhai_get_node_size(node, &size);
+    if (item->status != KOW_STATUS_OK)
+        return;
+    if (item->size + item->offset > size)
+    {
+        item->status = KOW_STATUS_NODE_DATA_TOO_SMALL;
+        return;
+    }
+
+    if (write)
+    {
+        preserve_snapshot(tree, offset + item->offset, item->size);
+        memcpy((char*)tree->data + offset + item->offset, item->buffer, item->size);
+        mark_dirty(tree, offset + item->offset, item->size);
+    }
+    else
+        memcpy(item->buffer, (char*)tree->data + offset + item->offset, item->size);
+}
+
+/**
+ * @brief resolve a group of sorted batch items that all share the same path up to depth
+ * Each child node is visited once and matched against the group by binary search, the items
+ * that continue into a child branch are resolved by recursing with the matching sub group
+ * @param tree, the tree to read/write
+ * @param node, the first node of this branch to search
+ * @param depth, the path depth of node
+ * @param items, sorted batch items that share the same path up to depth (unresolved items have a KOW_STATUS_INVALID_SYMBOL_PATH status)
+ * @param num_items, number of items in the group
+ * @param offset, offset of the branch data from the start of the tree data
+ * @param initial_branch, only check the first node (ie this is the root)
+ * @param branch_union, the branch is a union so all child nodes have the same offset
+ * @param write, write the items rather than read them
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+static int batch_resolve(struct kowhai_tree_t *tree, const struct kowhai_node_t *node, int depth, struct kowhai_batch_item_t *items, int num_items, int offset, int initial_branch, int branch_union, int write)
+{
+    int i = 0;
+
+    while (node[i].type != KOW_BRANCH_END)
+    {
+        int size, skip_nodes, ret;
+        int lo = 0, hi = num_items, j;
+
+        ret = get_node_size_default(node + i, &size, &skip_nodes);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+
+        // find the run of items that continue through this node
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (items[mid].symbols[depth].parts.name < node[i].symbol)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for (j = lo; j < num_items && items[j].symbols[depth].parts.name == node[i].symbol;)
+        {
+            uint16_t array_index = items[j].symbols[depth].parts.array_index;
+            int run_end = j;
+            while (run_end < num_items &&
+                    items[run_end].symbols[depth].parts.name == node[i].symbol &&
+                    items[run_end].symbols[depth].parts.array_index == array_index)
+                run_end++;
+
+            if (node[i].count > array_index)
+            {
+                int element_offset = offset + (size / node[i].count) * array_index;
+                int k;
+
+                // the shorter paths come first in the run, these end at this node
+                for (k = j; k < run_end && items[k].num_symbols == depth + 1; k++)
+                {
+                    if (items[k].status == KOW_STATUS_INVALID_SYMBOL_PATH)
+                        batch_access(tree, &items[k], node + i, element_offset, write);
+                }
+
+                // the rest continue into this branch
+                if (k < run_end && (node[i].type == KOW_BRANCH_START || node[i].type == KOW_BRANCH_U_START))
+                {
+                    ret = batch_resolve(tree, node + i + 1, depth + 1, items + k, run_end - k, element_offset, 0, node[i].type == KOW_BRANCH_U_START, write);
+                    if (ret != KOW_STATUS_OK)
+                        return ret;
+                }
+            }
+            j = run_end;
+        }
+
+        if (initial_branch)
+            break;
+        // move on to the next node in this branch
+        if (!branch_union)
+            offset += size;
+        i += skip_nodes + 1;
+    }
+
+    return KOW_STATUS_OK;
+}
+
+static int access_many(struct kowhai_tree_t *tree, struct kowhai_batch_item_t *items, int num_items, int write)
+{
+    int i, first = 0, ret;
+
+    if (tree->desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+
+    // sort the items by path and mark them all as unresolved (empty paths sort first and are never resolved)
+    qsort(items, num_items, sizeof(struct kowhai_batch_item_t), compare_batch_items);
+    for (i = 0; i < num_items; i++)
+    {
+        items[i].status = KOW_STATUS_INVALID_SYMBOL_PATH;
+        if (items[i].num_symbols < 1)
+            first = i + 1;
+    }
+
+    ret = batch_resolve(tree, tree->desc, 0, items + first, num_items - first, 0, 1, 0, write);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+
+    for (i = 0; i < num_items; i++)
+    {
+        if (items[i].status != KOW_STATUS_OK)
+            return items[i].status;
+    }
+    return KOW_STATUS_OK;
+}
+
+int kowhai_read_many(struct kowhai_tree_t *tree, struct kowhai_batch_item_t *items, int num_items)
+{
+    return access_many(tree, items, num_items, 0);
+}
+
+int kowhai_write_many(struct kowhai_tree_t *tree, struct kowhai_batch_item_t *items, int num_items)
+{
+    return access_many(tree, items, num_items, 1);
+}
+
+// find the first leaf item and the stride between branch array items for a gather or scatter
+static int resolve_strided(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int branch_index, int count, int *offset, int *item_size, int *stride)
+{
+    struct kowhai_node_t *node, *branch;
+    int branch_offset, size, status;
+
+    if (branch_index < 0 || branch_index >= num_symbols - 1 || count < 0)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+
+    status = kowhai_get_node(tree->desc, branch_index + 1, symbols, &branch_offset, &branch);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (branch->type != KOW_BRANCH_START && branch->type != KOW_BRANCH_U_START)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+    if (symbols[branch_index].parts.array_index + count > branch->count)
+        return KOW_STATUS_INVALID_OFFSET;
+    status = kowhai_get_node_size(branch, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    *stride = size / branch->count;
+
+    status = kowhai_get_node(tree->desc, num_symbols, symbols, offset, &node);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (node->type == KOW_BRANCH_START || node->type == KOW_BRANCH_U_START)
+        return KOW_STATUS_INVALID_NODE_TYPE;
+    *item_size = kowhai_get_node_type_size(node->type);
+    return KOW_STATUS_OK;
+}
+
+// copy count items of item_size bytes from src to dst stepping by the given strides, the fixed size
+// copies let the compiler use single loads and stores (the tree data may not be aligned)
+static void strided_copy(char *dst, int dst_stride, const char *src, int src_stride, int item_size, int count)
+{
+    int i;
+    switch (item_size)
+    {
+        case 1:
+            for (i = 0; i < count; i++)
+                dst[i * dst_stride] = src[i * src_stride];
+            break;
+        case 2:
+            for (i = 0; i < count; i++)
+                memcpy(dst + i * dst_stride, src + i * src_stride, 2);
+            break;
+        case 4:
+            for (i = 0; i < count; i++)
+                memcpy(dst + i * dst_stride, src + i * src_stride, 4);
+            break;
+        case 8:
+            for (i = 0; i < count; i++)
+                memcpy(dst + i * dst_stride, src + i * src_stride, 8);
+            break;
+        default:
+            for (i = 0; i < count; i++)
+                memcpy(dst + i * dst_stride, src + i * src_stride, item_size);
+            break;
+    }
+}
+
+int kowhai_gather(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int branch_index, void* result, int count)
+{
+    int offset, item_size, stride;
+    int status = resolve_strided(tree, num_symbols, symbols, branch_index, count, &offset, &item_size, &stride);
+    if (status != KOW_STATUS_OK)
+        return status;
+    strided_copy((char*)result, item_size, (char*)tree->data + offset, stride, item_size, count);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_scatter(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int branch_index, void* values, int count)
+{
+    int offset, item_size, stride;
+    int status = resolve_strided(tree, num_symbols, symbols, branch_index, count, &offset, &item_size, &stride);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (count > 0)
+        preserve_snapshot(tree, offset, stride * (count - 1) + item_size);
+    strided_copy((char*)tree->data + offset, stride, (char*)values, item_size, item_size, count);
+    if (count > 0)
+        mark_dirty(tree, offset, stride * (count - 1) + item_size);
+    return KOW_STATUS_OK;
+}
+
 int kowhai_get_int8(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int8_t* result)
 {
     struct kowhai_node_t* node;
@@ -395,7 +1219,9 @@ int kowhai_set_int8(struct kowhai_tree_t *tree, int num_symbols, union kowhai_sy
     if (node->type == KOW_INT8 || node->type == KOW_UINT8)
     {
         uint8_t* target_address = (uint8_t*)((uint8_t*)tree->data + offset);
+        preserve_snapshot(tree, offset, sizeof(*target_address));
         *target_address = value;
+        mark_dirty(tree, offset, sizeof(*target_address));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -412,7 +1238,9 @@ int kowhai_set_char(struct kowhai_tree_t *tree, int num_symbols, union kowhai_sy
     if (node->type == KOW_CHAR)
     {
         char* target_address = (char*)((char*)tree->data + offset);
+        preserve_snapshot(tree, offset, sizeof(*target_address));
         *target_address = value;
+        mark_dirty(tree, offset, sizeof(*target_address));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -429,7 +1257,9 @@ int kowhai_set_int16(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     if (node->type == KOW_INT16 || node->type == KOW_UINT16)
     {
         int16_t* target_address = (int16_t*)((char*)tree->data + offset);
+        preserve_snapshot(tree, offset, sizeof(*target_address));
         *target_address = value;
+        mark_dirty(tree, offset, sizeof(*target_address));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -446,7 +1276,9 @@ int kowhai_set_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     if (node->type == KOW_INT32 || node->type == KOW_UINT32)
     {
         uint32_t* target_address = (uint32_t*)((char*)tree->data + offset);
+        preserve_snapshot(tree, offset, sizeof(*target_address));
         *target_address = value;
+        mark_dirty(tree, offset, sizeof(*target_address));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -463,7 +1295,9 @@ int kowhai_set_float(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     if (node->type == KOW_FLOAT)
     {
         float* target_address = (float*)((char*)tree->data + offset);
+        preserve_snapshot(tree, offset, sizeof(*target_address));
         *target_address = value;
+        mark_dirty(tree, offset, sizeof(*target_address));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -480,7 +1314,9 @@ int kowhai_set_int64(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     if (node->type == KOW_INT64 || node->type == KOW_UINT64)
     {
         uint64_t* target_address = (uint64_t*)((char*)tree->data + offset);
+        preserve_snapshot(tree, offset, sizeof(*target_address));
         *target_address = value;
+        mark_dirty(tree, offset, sizeof(*target_address));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -497,9 +1333,256 @@ int kowhai_set_double(struct kowhai_tree_t *tree, int num_symbols, union kowhai_
     if (node->type == KOW_DOUBLE)
     {
         double* target_address = (double*)((char*)tree->data + offset);
+        preserve_snapshot(tree, offset, sizeof(*target_address));
         *target_address = value;
+        mark_dirty(tree, offset, sizeof(*target_address));
+        return status;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_resolve(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, struct kowhai_handle_t *handle)
+{
+    struct kowhai_node_t* node;
+    int offset;
+    int status;
+    int size;
+
+    // find this node
+    status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
+    if (status != KOW_STATUS_OK)
         return status;
+    status = kowhai_get_node_size(node, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    // the item may be part way into an array so only the remaining items are available
+    size -= (size / node->count) * symbols[num_symbols - 1].parts.array_index;
+
+    handle->desc = tree->desc;
+    handle->node = node;
+    handle->offset = offset;
+    handle->size = size;
+    handle->type = node->type;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_handle_is_valid(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle)
+{
+    return handle->desc != NULL && handle->desc == tree->desc;
+}
+
+int kowhai_handle_read(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int read_offset, void* result, int read_size)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (read_offset < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+    if (read_size + read_offset > handle->size)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+    memcpy(result, (char*)tree->data + handle->offset + read_offset, read_size);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_handle_write(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int write_offset, void* value, int write_size)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (write_offset < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+    if (write_size + write_offset > handle->size)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+    preserve_snapshot(tree, handle->offset + write_offset, write_size);
+    memcpy((char*)tree->data + handle->offset + write_offset, value, write_size);
+    mark_dirty(tree, handle->offset + write_offset, write_size);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_handle_get_int8(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int8_t* result)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_INT8 || handle->type == KOW_UINT8)
+    {
+        *result = *((int8_t*)((char*)tree->data + handle->offset));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_get_char(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, char* result)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_CHAR)
+    {
+        *result = *((char*)((char*)tree->data + handle->offset));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_get_int16(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int16_t* result)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_INT16 || handle->type == KOW_UINT16)
+    {
+        *result = *((int16_t*)((char*)tree->data + handle->offset));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_get_int32(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int32_t* result)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_INT32 || handle->type == KOW_UINT32)
+    {
+        *result = *((uint32_t*)((char*)tree->data + handle->offset));
+        return KOW_STATUS_OK;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
 }
 
+int kowhai_handle_get_float(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, float* result)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_FLOAT)
+    {
+        *result = *((float*)((char*)tree->data + handle->offset));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_get_int64(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int64_t* result)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_INT64 || handle->type == KOW_UINT64)
+    {
+        *result = *((uint64_t*)((char*)tree->data + handle->offset));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_get_double(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, double* result)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_DOUBLE)
+    {
+        *result = *((double*)((char*)tree->data + handle->offset));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_set_int8(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, uint8_t value)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_INT8 || handle->type == KOW_UINT8)
+    {
+        uint8_t* target_address = (uint8_t*)((char*)tree->data + handle->offset);
+        preserve_snapshot(tree, handle->offset, sizeof(*target_address));
+        *target_address = value;
+        mark_dirty(tree, handle->offset, sizeof(*target_address));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_set_char(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, char value)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_CHAR)
+    {
+        char* target_address = (char*)((char*)tree->data + handle->offset);
+        preserve_snapshot(tree, handle->offset, sizeof(*target_address));
+        *target_address = value;
+        mark_dirty(tree, handle->offset, sizeof(*target_address));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_set_int16(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int16_t value)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_INT16 || handle->type == KOW_UINT16)
+    {
+        int16_t* target_address = (int16_t*)((char*)tree->data + handle->offset);
+        preserve_snapshot(tree, handle->offset, sizeof(*target_address));
+        *target_address = value;
+        mark_dirty(tree, handle->offset, sizeof(*target_address));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_set_int32(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int32_t value)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_INT32 || handle->type == KOW_UINT32)
+    {
+        uint32_t* target_address = (uint32_t*)((char*)tree->data + handle->offset);
+        preserve_snapshot(tree, handle->offset, sizeof(*target_address));
+        *target_address = value;
+        mark_dirty(tree, handle->offset, sizeof(*target_address));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_set_float(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, float value)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_FLOAT)
+    {
+        float* target_address = (float*)((char*)tree->data + handle->offset);
+        preserve_snapshot(tree, handle->offset, sizeof(*target_address));
+        *target_address = value;
+        mark_dirty(tree, handle->offset, sizeof(*target_address));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_set_int64(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int64_t value)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_INT64 || handle->type == KOW_UINT64)
+    {
+        uint64_t* target_address = (uint64_t*)((char*)tree->data + handle->offset);
+        preserve_snapshot(tree, handle->offset, sizeof(*target_address));
+        *target_address = value;
+        mark_dirty(tree, handle->offset, sizeof(*target_address));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
+
+int kowhai_handle_set_double(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, double value)
+{
+    if (handle->desc != tree->desc)
+        return KOW_STATUS_STALE_HANDLE;
+    if (handle->type == KOW_DOUBLE)
+    {
+        double* target_address = (double*)((char*)tree->data + handle->offset);
+        preserve_snapshot(tree, handle->offset, sizeof(*target_address));
+        *target_address = value;
+        mark_dirty(tree, handle->offset, sizeof(*target_address));
+        return KOW_STATUS_OK;
+    }
+    return KOW_STATUS_INVALID_NODE_TYPE;
+}
@@ -35,6 +35,24 @@ enum kowhai_node_type
     KOW_DOUBLE,
 };
 
+/**
+ * @brief set in kowhai_version when the library is built with KOWHAI_WIDE_NODES (descriptors use the wide node format)
+ */
+#define KOWHAI_VERSION_WIDE_NODES 0x00010000
+
+/**
+ * @brief the type of a node array count
+ * By default nodes are limited to 65535 array items, define KOWHAI_WIDE_NODES to allow arrays of up to 2^31 items.
+ * This changes the layout of kowhai_node_t so descriptors (and the KOW_CMD_READ_DESCRIPTOR protocol command) are
+ * only compatible between builds that agree, kowhai_version tells them apart. The wide count is signed so array
+ * arithmetic behaves the same as with the promoted 16 bit count.
+ */
+#ifdef KOWHAI_WIDE_NODES
+typedef int32_t kowhai_count_t;
+#else
+typedef uint16_t kowhai_count_t;
+#endif
+
 /**
  * @brief base tree descriptor node entry
  */
@@ -42,17 +60,35 @@ struct kowhai_node_t
 {
     uint16_t type;          ///< what is this node
     uint16_t symbol;        ///< index to a name for this node
-    uint16_t count;         ///< if this is an array, this is the number of elements in the array (otherwise 1)
+    kowhai_count_t count;   ///< if this is an array, this is the number of elements in the array (otherwise 1)
     uint16_t tag;           ///< user defined tag
 };
 
+/**
+ * @brief a bitmap of the blocks of tree data that have been written since they were last cleared
+ */
+struct kowhai_dirty_t
+{
+    uint8_t *bits;                 ///< one bit per block of tree data (supplied by the caller)
+    int num_blocks;                ///< number of blocks in the tree data
+    int block_size;                ///< number of bytes of tree data covered by each bit
+    int size;                      ///< size of the tree data in bytes
+    struct kowhai_dirty_t *next;   ///< next bitmap in the chain, every range marked here is marked there too (or NULL)
+};
+
+struct kowhai_snapshot_t;
+
 /**
  * @brief contains a descriptor and data pair
+ * Version 7 added dirty and snapshot after data, a tree filled in member by member must set them too (or use
+ * kowhai_tree_init) and bindings that declare this struct must declare all four members
  */
 struct kowhai_tree_t
 {
     struct kowhai_node_t *desc;    ///< points to a descriptor of the data of this tree
     void *data;                    ///< points to the start of a structure containing the data described by the tree
+    struct kowhai_dirty_t *dirty;  ///< if not NULL the writes made by kowhai_write, kowhai_set_xxx etc are marked in this bitmap
+    struct kowhai_snapshot_t *snapshot; ///< if not NULL pages are copied into this snapshot before kowhai_write, kowhai_set_xxx etc change them (see kowhai_snapshot.h)
 };
 
 /**
@@ -88,12 +124,112 @@ union kowhai_symbol_t
 #define KOW_STATUS_NO_DATA                 14
 #define KOW_STATUS_PATH_TOO_SMALL          15
 #define KOW_STATUS_UNKNOWN_ERROR           16
+#define KOW_STATUS_STALE_HANDLE            17
+#define KOW_STATUS_STACK_TOO_SMALL         18
+#define KOW_STATUS_MISALIGNED              19
+#define KOW_STATUS_OUT_OF_RANGE            20
+#define KOW_STATUS_CHECKSUM_MISMATCH       21
+
+/**
+ * @brief number of frames in the walk stack used by functions that do not take one
+ * Each level of branch nesting walked needs a frame, deeper trees are walked with more blocks of this many
+ * frames (see kowhai_walk_default) so this only sets how much C stack a walk uses at a time
+ */
+#ifndef KOWHAI_WALK_STACK_DEPTH
+#define KOWHAI_WALK_STACK_DEPTH 16
+#endif
+
+/**
+ * @brief the saved state of one branch level of a descriptor walk
+ * The descriptor walkers are iterative, instead of recursing into a branch they save their state
+ * in a frame on a caller supplied stack. The meaning of each field depends on the walker.
+ */
+struct kowhai_walk_frame_t
+{
+    const struct kowhai_node_t *node;   ///< node being walked at this level
+    const struct kowhai_node_t *node2;  ///< second node being walked at this level (eg the right tree of a diff)
+    void *data;                         ///< data pointer at this level
+    void *data2;                        ///< second data pointer at this level
+    int index;                          ///< array index or node index at this level
+    int value[4];                       ///< other walker specific state
+};
+
+/**
+ * @brief a bounded stack of walk frames supplied by the caller
+ */
+struct kowhai_walk_stack_t
+{
+    struct kowhai_walk_frame_t *frames; ///< storage for the frames
+    int size;                           ///< number of frames in storage
+    int depth;                          ///< number of frames in use (walks start pushing frames from here)
+    int max_depth;                      ///< the most frames that have been in use since kowhai_walk_stack_init
+    struct kowhai_walk_stack_t *next;   ///< if not NULL more frames that carry on after these (see kowhai_walk_default)
+};
+
+/**
+ * @brief a walk run by kowhai_walk_default
+ * @param param, application specific parameter passed through
+ * @param stack, frames for the walk
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+typedef int (*kowhai_walk_t)(void *param, struct kowhai_walk_stack_t *stack);
 
 /**
- * @brief return the version of the kowhai library
+ * @brief return the version of the kowhai library (KOWHAI_VERSION_WIDE_NODES is set if nodes use the wide format)
  */
 uint32_t kowhai_version(void);
 
+/**
+ * @brief initialise a tree with no dirty bitmap or snapshot
+ * @param tree, the tree to initialise
+ * @param desc, the descriptor of the tree data
+ * @param data, the tree data
+ */
+void kowhai_tree_init(struct kowhai_tree_t *tree, struct kowhai_node_t *desc, void *data);
+
+/**
+ * @brief initialise a walk stack
+ * @param stack, the stack to initialise
+ * @param frames, storage for the stack frames
+ * @param size, number of frames in storage
+ */
+void kowhai_walk_stack_init(struct kowhai_walk_stack_t *stack, struct kowhai_walk_frame_t *frames, int size);
+
+/**
+ * @brief get the frame at depth for a walk to save its state in (this updates the stack max_depth)
+ * @param stack, the stack to push a frame on to
+ * @param depth, the index of the frame to use
+ * @return the frame or NULL if the stack is too small
+ */
+struct kowhai_walk_frame_t *kowhai_walk_stack_push(struct kowhai_walk_stack_t *stack, int depth);
+
+/**
+ * @brief get the frame at depth that a walk has already pushed (following on to the next frames if needed)
+ * @param stack, the stack the frame was pushed on to
+ * @param depth, the index of the frame
+ * @return the frame or NULL if the stack is too small
+ */
+struct kowhai_walk_frame_t *kowhai_walk_stack_frame(struct kowhai_walk_stack_t *stack, int depth);
+
+/**
+ * @brief call walk with a stack of at least depth frames
+ * The frames are taken from the C stack KOWHAI_WALK_STACK_DEPTH at a time and chained together, this is how the
+ * functions that do not take a walk stack walk trees of any depth
+ * @param depth, number of frames the walk needs (eg from kowhai_get_node_depth)
+ * @param walk, the walk to run
+ * @param param, application specific parameter passed through to walk
+ * @return the status returned by walk
+ */
+int kowhai_walk_default(int depth, kowhai_walk_t walk, void *param);
+
+/**
+ * @brief get the number of levels of branches in a node including the node itself (0 if it is not a branch)
+ * The descriptor is scanned without a walk stack, the result is the number of frames that is enough to walk the node
+ * @param node, the node to measure
+ * @return the number of levels
+ */
+int kowhai_get_node_depth(const struct kowhai_node_t *node);
+
 /**
  * @brief return the size for a given node type
  * @param type, a node type to find the size of
@@ -112,6 +248,18 @@ int kowhai_get_node_type_size(uint16_t type);
  */
 int kowhai_get_node(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node);
 
+/**
+ * @brief same as kowhai_get_node but uses a caller supplied walk stack
+ * @param node, to start searching from for the given item
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the item to find
+ * @param offset, set to number of bytes from the current branch to the item
+ * @param target_node, if return is successful this is the node that matches the symbol path
+ * @param stack, frames for the walk (KOW_STATUS_STACK_TOO_SMALL is returned if the tree is too deep)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_get_node_ex(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node, struct kowhai_walk_stack_t *stack);
+
 /**
  * @brief calculate the complete size of a node including all the sub-elements and array items.
  * @param node to find the size of
@@ -121,6 +269,15 @@ int kowhai_get_node(const struct kowhai_node_t *node, int num_symbols, const uni
  */
 int kowhai_get_node_size(const struct kowhai_node_t *node, int *size);
 
+/**
+ * @brief same as kowhai_get_node_size but uses a caller supplied walk stack
+ * @param node to find the size of
+ * @param size size of the node in bytes
+ * @param stack, frames for the walk (KOW_STATUS_STACK_TOO_SMALL is returned if the tree is too deep)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_get_node_size_ex(const struct kowhai_node_t *node, int *size, struct kowhai_walk_stack_t *stack);
+
 /**
  * @brief calculate the complete count of nodes including any child nodes, ie count all the child nodes + this one
  * @param node start counting from here
@@ -129,6 +286,142 @@ int kowhai_get_node_size(const struct kowhai_node_t *node, int *size);
  */
 int kowhai_get_node_count(const struct kowhai_node_t *node, int *count);
 
+/**
+ * @brief same as kowhai_get_node_count but uses a caller supplied walk stack
+ * @param node start counting from here
+ * @param count number of child nodes + this node
+ * @param stack, frames for the walk (KOW_STATUS_STACK_TOO_SMALL is returned if the tree is too deep)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_get_node_count_ex(const struct kowhai_node_t *node, int *count, struct kowhai_walk_stack_t *stack);
+
+/**
+ * @brief check a descriptor is a single complete tree of known node types that exactly fills its nodes (eg a descriptor loaded from a file or shared memory)
+ * Only desc[0] to desc[num_nodes - 1] are read so this is safe to call before walking a descriptor that is not trusted
+ * @param desc the descriptor to check
+ * @param num_nodes number of nodes in desc
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_check_descriptor(const struct kowhai_node_t *desc, int num_nodes);
+
+/**
+ * @brief precomputed size and skip information for every node in a descriptor
+ * Each table is indexed by the position of the node in the descriptor, branch end nodes have a size of 0
+ * and a node count of 1. The tables are supplied by the caller and populated by kowhai_init_node_tables.
+ */
+struct kowhai_node_tables_t
+{
+    const struct kowhai_node_t *desc;  ///< the descriptor these tables were built from
+    int num_nodes;                     ///< number of nodes in the descriptor (and number of items used in each table)
+    int32_t *size;                     ///< complete size of each node including all the sub-elements and array items
+    int32_t *node_count;               ///< number of nodes to skip to get past each node (ie all its child nodes + this one)
+    int32_t *data_offset;              ///< offset of each node from the start of the tree data (with all parent array indices 0)
+};
+
+/**
+ * @brief build the size and skip tables for a descriptor in a single pass
+ * @param tables, the tables to initialise
+ * @param desc, the descriptor to build the tables from (this must remain valid for the life of the tables)
+ * @param num_nodes, the number of items in each of the tables below (see kowhai_get_node_count)
+ * @param size, table to store the size of each node in
+ * @param node_count, table to store the node count of each node in
+ * @param data_offset, table to store the data offset of each node in
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_init_node_tables(struct kowhai_node_tables_t *tables, const struct kowhai_node_t *desc, int num_nodes, int32_t *size, int32_t *node_count, int32_t *data_offset);
+
+/**
+ * @brief same as kowhai_get_node_size but reads the size from precomputed tables
+ * @param tables, tables built from the descriptor that node belongs to
+ * @param node to find the size of
+ * @param size size of the node in bytes
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_get_node_size_from_tables(const struct kowhai_node_tables_t *tables, const struct kowhai_node_t *node, int *size);
+
+/**
+ * @brief same as kowhai_get_node_count but reads the count from precomputed tables
+ * @param tables, tables built from the descriptor that node belongs to
+ * @param node start counting from here
+ * @param count number of child nodes + this node
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_get_node_count_from_tables(const struct kowhai_node_tables_t *tables, const struct kowhai_node_t *node, int *count);
+
+/**
+ * @brief same as kowhai_get_node but skips non matching nodes using precomputed tables
+ * @param tables, tables built from the descriptor to search
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the item to find
+ * @param offset, set to number of bytes from the start of the tree data to the item
+ * @param target_node, if return is successful this is the node that matches the symbol path
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_get_node_from_tables(const struct kowhai_node_tables_t *tables, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node);
+
+/**
+ * @brief get the number of bytes needed for a dirty bitmap of a tree
+ * @param desc, the tree descriptor
+ * @param block_size, number of bytes of tree data covered by each bit (eg 1 for byte accuracy or 64 for cache lines)
+ * @param size, set to the number of bytes needed for the bitmap
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_dirty_get_size(const struct kowhai_node_t *desc, int block_size, int *size);
+
+/**
+ * @brief initialise a dirty bitmap with nothing marked dirty (set tree->dirty to it to start tracking writes)
+ * @param dirty, the bitmap to initialise
+ * @param desc, the tree descriptor
+ * @param block_size, number of bytes of tree data covered by each bit
+ * @param bits, storage for the bitmap
+ * @param bits_size, number of bytes in bits (see kowhai_dirty_get_size)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_dirty_init(struct kowhai_dirty_t *dirty, const struct kowhai_node_t *desc, int block_size, uint8_t *bits, int bits_size);
+
+/**
+ * @brief chain a bitmap onto another so it is marked whenever the other is (eg to give each consumer of the changes
+ * to a tree its own bitmap to clear), the chained bitmap is not changed so it only sees ranges marked from now on
+ * @param dirty, the bitmap writes mark (eg tree->dirty)
+ * @param next, the bitmap to add to the end of the chain, it must cover the same tree data (chaining it again does nothing)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_dirty_chain(struct kowhai_dirty_t *dirty, struct kowhai_dirty_t *next);
+
+/**
+ * @brief remove a bitmap from a chain (see kowhai_dirty_chain)
+ * @param dirty, the first bitmap in the chain
+ * @param next, the bitmap to remove, it is left unchanged apart from being unlinked
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_dirty_unchain(struct kowhai_dirty_t *dirty, struct kowhai_dirty_t *next);
+
+/**
+ * @brief mark a range of tree data dirty in a bitmap and all the bitmaps chained to it
+ * @param dirty, the bitmap
+ * @param offset, number of bytes from the start of the tree data to the first byte written
+ * @param size, number of bytes written
+ */
+void kowhai_dirty_mark(struct kowhai_dirty_t *dirty, int offset, int size);
+
+/**
+ * @brief mark a range of tree data clean (only in this bitmap, not in the bitmaps chained to it)
+ * @param dirty, the bitmap
+ * @param offset, number of bytes from the start of the tree data to the first byte to clear
+ * @param size, number of bytes to clear (partially covered blocks are cleared too)
+ */
+void kowhai_dirty_clear(struct kowhai_dirty_t *dirty, int offset, int size);
+
+/**
+ * @brief find the next range of dirty tree data, adjacent dirty blocks are merged into one range
+ * @param dirty, the bitmap
+ * @param start, number of bytes from the start of the tree data to start searching from
+ * @param offset, set to the start of the dirty range
+ * @param size, set to the number of bytes in the dirty range
+ * @return KOW_STATUS_OK if a range was found, KOW_STATUS_NOT_FOUND if there is no dirty data after start
+ */
+int kowhai_dirty_next(const struct kowhai_dirty_t *dirty, int start, int *offset, int *size);
+
 /**
  * @brief Read from a tree data buffer starting at a symbol path
  * @param tree, the tree to read from
@@ -153,6 +446,68 @@ int kowhai_read(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol
  */
 int kowhai_write(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int write_offset, void* value, int write_size);
 
+/**
+ * @brief a single read or write in a batch (see kowhai_read_many and kowhai_write_many)
+ */
+struct kowhai_batch_item_t
+{
+    int num_symbols;                   ///< number of symbols that make up the symbols path below
+    union kowhai_symbol_t *symbols;    ///< a collection of symbols that forms a path to the node to start the read/write from
+    int offset;                        ///< the offset into the node data to start the read/write at
+    void *buffer;                      ///< the buffer to read into or write from
+    int size;                          ///< the number of bytes to read/write
+    int status;                        ///< set to the kowhai status of this read/write
+};
+
+/**
+ * @brief Read many items from a tree data buffer resolving all their symbol paths in a single descriptor pass
+ * The items are sorted in place by symbol path so that shared path prefixes are only walked once, the result
+ * of each read is stored in the status member of each item (each read behaves the same as kowhai_read)
+ * @param tree, the tree to read from
+ * @param items, the reads to do
+ * @param num_items, number of items above
+ * @return KOW_STATUS_OK if every read succeeded otherwise the status of the first failed item
+ */
+int kowhai_read_many(struct kowhai_tree_t *tree, struct kowhai_batch_item_t *items, int num_items);
+
+/**
+ * @brief Write many items to a tree data buffer resolving all their symbol paths in a single descriptor pass
+ * The items are sorted in place by symbol path so that shared path prefixes are only walked once, the result
+ * of each write is stored in the status member of each item (each write behaves the same as kowhai_write,
+ * so an item that fails does not stop the others from being written)
+ * @param tree, the tree to write to
+ * @param items, the writes to do
+ * @param num_items, number of items above
+ * @return KOW_STATUS_OK if every write succeeded otherwise the status of the first failed item
+ */
+int kowhai_write_many(struct kowhai_tree_t *tree, struct kowhai_batch_item_t *items, int num_items);
+
+/**
+ * @brief Copy one leaf item from each of a run of branch array items into a contiguous buffer
+ * The symbol at branch_index in the path must be a branch, its array index is the first branch array item
+ * copied from (the rest of the path picks the leaf item to copy from each branch array item)
+ * @param tree, the tree to read from
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the leaf item in the first branch array item
+ * @param branch_index, the index of the branch symbol in the path to step through
+ * @param result, buffer for count leaf items packed one after the other
+ * @param count, number of branch array items to copy from
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_gather(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int branch_index, void* result, int count);
+
+/**
+ * @brief Copy leaf items from a contiguous buffer into one leaf item of each of a run of branch array items (see kowhai_gather)
+ * @param tree, the tree to write to
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the leaf item in the first branch array item
+ * @param branch_index, the index of the branch symbol in the path to step through
+ * @param values, count leaf items packed one after the other
+ * @param count, number of branch array items to copy to
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_scatter(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int branch_index, void* values, int count);
+
 /**
  * @brief Get a single byte char setting specified by a symbol path from a settings buffer
  * @param tree, the tree to get the value from
@@ -274,5 +629,90 @@ int kowhai_set_int64(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
  * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
  */
 int kowhai_set_double(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, double value);
-#endif
 
+/**
+ * @brief a node resolved from a symbol path so it can be accessed repeatedly without searching the descriptor
+ * Treat this as opaque, it is only valid for trees using the descriptor it was resolved against. If the
+ * descriptor of the tree changes all the kowhai_handle_xxx accessors return KOW_STATUS_STALE_HANDLE
+ * and the handle must be resolved again.
+ */
+struct kowhai_handle_t
+{
+    const struct kowhai_node_t *desc;   ///< descriptor the handle was resolved against
+    struct kowhai_node_t *node;         ///< the node the symbol path resolved to
+    int offset;                         ///< number of bytes from the start of the tree data to the item
+    int size;                           ///< number of bytes from the item to the end of the node data
+    uint16_t type;                      ///< type of the node
+};
+
+/**
+ * @brief resolve a symbol path into a handle
+ * @param tree, the tree to resolve the path in
+ * @param num_symbols, number of symbols that make up the symbols path below
+ * @param symbols, a collection of symbols that forms a path to the node
+ * @param handle, populated with the resolved node on success
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_handle_resolve(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, struct kowhai_handle_t *handle);
+
+/**
+ * @brief check a handle can still be used with a tree
+ * @param tree, the tree the handle will be used with
+ * @param handle, the handle to check
+ * @return 1 if the handle is valid for this tree otherwise 0
+ */
+int kowhai_handle_is_valid(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle);
+
+/**
+ * @brief Read from a tree data buffer starting at a resolved node (see kowhai_read)
+ * @param tree, the tree to read from
+ * @param handle, the resolved node to start the read from (not including the read_offset below)
+ * @param read_offset, the offset into the node data to start reading from
+ * @param result, the buffer to read the result into
+ * @param read_size, the number of bytes to read into the result
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_handle_read(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int read_offset, void* result, int read_size);
+
+/**
+ * @brief Write to a tree data buffer starting at a resolved node (see kowhai_write)
+ * @param tree, the tree to write to
+ * @param handle, the resolved node to start the write from (not including the write_offset below)
+ * @param write_offset, the offset into the node data to start writing at
+ * @param value, the buffer to write from
+ * @param write_size, the number of bytes to write into the settings buffer
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_handle_write(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int write_offset, void* value, int write_size);
+
+/**
+ * @brief Get a setting from a resolved node, these behave like the kowhai_get_xxx family without the descriptor search
+ * @param tree, the tree to get the value from
+ * @param handle, the resolved node to get
+ * @param result, the value of the node
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_handle_get_int8(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int8_t* result);
+int kowhai_handle_get_char(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, char* result);
+int kowhai_handle_get_int16(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int16_t* result);
+int kowhai_handle_get_int32(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int32_t* result);
+int kowhai_handle_get_float(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, float* result);
+int kowhai_handle_get_int64(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int64_t* result);
+int kowhai_handle_get_double(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, double* result);
+
+/**
+ * @brief Set a setting of a resolved node, these behave like the kowhai_set_xxx family without the descriptor search
+ * @param tree, the tree to write the value into
+ * @param handle, the resolved node to set
+ * @param value, the new value to change the node to
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_handle_set_int8(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, uint8_t value);
+int kowhai_handle_set_char(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, char value);
+int kowhai_handle_set_int16(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int16_t value);
+int kowhai_handle_set_int32(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int32_t value);
+int kowhai_handle_set_float(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, float value);
+int kowhai_handle_set_int64(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, int64_t value);
+int kowhai_handle_set_double(struct kowhai_tree_t *tree, const struct kowhai_handle_t *handle, double value);
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef _KOWHAI_HPP_
+#define _KOWHAI_HPP_
+
+/**
+ * @brief header only C++ view of a kowhai tree with paths resolved at compile time (requires C++17)
+ *
+ * The descriptor is the same array of kowhai_node_t the C library and protocol server use, it just has to be
+ * constexpr with static storage so it can be a template argument:
+ *
+ *     static constexpr kowhai_node_t settings_descriptor[] = { ... };
+ *     typedef kowhai::path<SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), SYM_GAIN> gain_path;
+ *     kowhai::tree_view<settings_descriptor> view(&settings);
+ *     view.set<gain_path>(view.get<gain_path>() + 1);
+ *
+ * A path that is not in the descriptor (or does not end at a leaf) fails to compile, get and set compile to a
+ * single load or store. A view made from a kowhai_tree_t preserves the pages of the tree snapshot and marks the
+ * tree dirty bitmap (if it has them) when set writes like kowhai_write, the tree must outlive the view. A view made
+ * from a data pointer does not track writes.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+#include "kowhai.h"
+#include "kowhai_snapshot.h"
+}
+
+namespace kowhai {
+
+/**
+ * @brief a symbol path, each symbol is a symbol name or KOWHAI_SYMBOL(name, array_index)
+ */
+template <uint32_t... Symbols>
+struct path {};
+
+/**
+ * @brief the C++ type of a leaf node type
+ */
+template <uint16_t Type> struct leaf_type;
+template <> struct leaf_type<KOW_INT8>   { typedef int8_t type; };
+template <> struct leaf_type<KOW_UINT8>  { typedef uint8_t type; };
+template <> struct leaf_type<KOW_INT16>  { typedef int16_t type; };
+template <> struct leaf_type<KOW_UINT16> { typedef uint16_t type; };
+template <> struct leaf_type<KOW_INT32>  { typedef int32_t type; };
+template <> struct leaf_type<KOW_UINT32> { typedef uint32_t type; };
+template <> struct leaf_type<KOW_FLOAT>  { typedef float type; };
+template <> struct leaf_type<KOW_CHAR>   { typedef char type; };
+template <> struct leaf_type<KOW_INT64>  { typedef int64_t type; };
+template <> struct leaf_type<KOW_UINT64> { typedef uint64_t type; };
+template <> struct leaf_type<KOW_DOUBLE> { typedef double type; };
+
+namespace detail {
+
+// same as kowhai_get_node_type_size
+constexpr int type_size(uint16_t type)
+{
+    switch (type)
+    {
+        case KOW_INT8:
+        case KOW_UINT8:
+        case KOW_CHAR:
+            return 1;
+        case KOW_INT16:
+        case KOW_UINT16:
+            return 2;
+        case KOW_INT32:
+        case KOW_UINT32:
+        case KOW_FLOAT:
+            return 4;
+        case KOW_INT64:
+        case KOW_UINT64:
+        case KOW_DOUBLE:
+            return 8;
+    }
+    return -1;
+}
+
+constexpr bool is_branch(const kowhai_node_t &node)
+{
+    return node.type == KOW_BRANCH_START || node.type == KOW_BRANCH_U_START;
+}
+
+// complete size of the node at index i (including array items) and the index of the node after it
+struct extent
+{
+    int size;
+    int next;
+};
+
+constexpr extent measure(const kowhai_node_t *desc, int i)
+{
+    int size = 0;
+    int j = i + 1;
+    if (!is_branch(desc[i]))
+        return extent{type_size(desc[i].type) * (int)desc[i].count, i + 1};
+    while (desc[j].type != KOW_BRANCH_END)
+    {
+        extent child = measure(desc, j);
+        if (desc[i].type == KOW_BRANCH_U_START)
+            size = child.size > size ? child.size : size;
+        else
+            size += child.size;
+        j = child.next;
+    }
+    return extent{size * (int)desc[i].count, j + 1};
+}
+
+// the node a symbol path leads to and its offset in the tree data (node is -1 if the path is not found)
+struct location
+{
+    int node;
+    int offset;
+};
+
+// same as kowhai_get_node
+constexpr location find(const kowhai_node_t *desc, const uint32_t *symbols, int num_symbols)
+{
+    int node = 0;
+    int offset = 0;
+
+    for (int k = 0; k < num_symbols; k++)
+    {
+        uint16_t name = (uint16_t)(symbols[k] & 0xFFFF);
+        int array_index = (int)(symbols[k] >> 16);
+        int child_offset = 0;
+        int j = node;
+        if (k > 0)
+        {
+            // search the children of the current branch
+            if (!is_branch(desc[node]))
+                return location{-1, 0};
+            j = node + 1;
+            while (desc[j].type != KOW_BRANCH_END && desc[j].symbol != name)
+            {
+                if (desc[node].type != KOW_BRANCH_U_START)
+                    child_offset += measure(desc, j).size;
+                j = measure(desc, j).next;
+            }
+        }
+        if (desc[j].type == KOW_BRANCH_END || desc[j].symbol != name || array_index >= (int)desc[j].count)
+            return location{-1, 0};
+        offset += child_offset + array_index * (measure(desc, j).size / (int)desc[j].count);
+        node = j;
+    }
+    return location{node, offset};
+}
+
+}
+
+/**
+ * @brief resolve a path in a descriptor at compile time
+ */
+template <const kowhai_node_t *Desc, class Path>
+struct resolve;
+
+template <const kowhai_node_t *Desc, uint32_t... Symbols>
+struct resolve<Desc, path<Symbols...> >
+{
+    static constexpr uint32_t symbols[] = {Symbols...};
+    static constexpr detail::location loc = detail::find(Desc, symbols, (int)sizeof...(Symbols));
+    static_assert(sizeof...(Symbols) > 0 && loc.node >= 0, "kowhai path is not in the descriptor");
+    static constexpr int node = loc.node >= 0 ? loc.node : 0;
+    static constexpr int offset = loc.offset;
+    static_assert(detail::type_size(Desc[node].type) > 0, "kowhai path does not end at a leaf");
+    typedef typename leaf_type<Desc[node].type>::type type;
+};
+
+/**
+ * @brief typed access to tree data described by Desc
+ */
+template <const kowhai_node_t *Desc>
+class tree_view
+{
+public:
+    explicit tree_view(void *data) : data_((uint8_t*)data), tree_(nullptr) {}
+    explicit tree_view(const kowhai_tree_t &tree) : data_((uint8_t*)tree.data), tree_(&tree) {}
+
+    void *data() const { return data_; }
+
+    /**
+     * @brief read the leaf at Path (the tree data is packed so this is an unaligned load)
+     */
+    template <class Path>
+    typename resolve<Desc, Path>::type get() const
+    {
+        typename resolve<Desc, Path>::type value;
+        memcpy(&value, data_ + resolve<Desc, Path>::offset, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief write the leaf at Path (preserving its tree snapshot page and marking it in the tree dirty bitmap)
+     */
+    template <class Path>
+    void set(typename resolve<Desc, Path>::type value)
+    {
+        if (tree_ != nullptr && tree_->snapshot != nullptr)
+            kowhai_snapshot_preserve(tree_->snapshot, resolve<Desc, Path>::offset, sizeof(value));
+        memcpy(data_ + resolve<Desc, Path>::offset, &value, sizeof(value));
+        if (tree_ != nullptr && tree_->dirty != nullptr)
+            kowhai_dirty_mark(tree_->dirty, resolve<Desc, Path>::offset, sizeof(value));
+    }
+
+    /**
+     * @brief byte offset of Path from the start of the tree data
+     */
+    template <class Path>
+    static constexpr int offset_of()
+    {
+        return resolve<Desc, Path>::offset;
+    }
+
+private:
+    uint8_t *data_;
+    const kowhai_tree_t *tree_;
+};
+
+}
+
+#endif
@@ -0,0 +1,154 @@
+#include "kowhai_atomic.h"
+#include "kowhai_snapshot.h"
+
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define ATOMIC_LOAD_32(p)           InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#define ATOMIC_STORE_32(p, v)       InterlockedExchange((volatile LONG*)(p), (v))
+#define ATOMIC_FETCH_ADD_32(p, v)   InterlockedExchangeAdd((volatile LONG*)(p), (v))
+#define ATOMIC_LOAD_64(p)           InterlockedCompareExchange64((volatile LONGLONG*)(p), 0, 0)
+#define ATOMIC_STORE_64(p, v)       InterlockedExchange64((volatile LONGLONG*)(p), (v))
+#define ATOMIC_FETCH_ADD_64(p, v)   InterlockedExchangeAdd64((volatile LONGLONG*)(p), (v))
+#define ATOMIC_OR_8(p, v)           _InterlockedOr8((volatile char*)(p), (char)(v))
+#elif defined(__GNUC__)
+#define ATOMIC_LOAD_32(p)           __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define ATOMIC_STORE_32(p, v)       __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define ATOMIC_FETCH_ADD_32(p, v)   __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define ATOMIC_LOAD_64(p)           __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define ATOMIC_STORE_64(p, v)       __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define ATOMIC_FETCH_ADD_64(p, v)   __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define ATOMIC_OR_8(p, v)           __atomic_fetch_or((p), (v), __ATOMIC_SEQ_CST)
+#else
+// no atomics available, only safe on single core targets where the caller masks interrupts
+#define ATOMIC_LOAD_32(p)           (*(p))
+#define ATOMIC_STORE_32(p, v)       (*(p) = (v))
+#define ATOMIC_FETCH_ADD_32(p, v)   ((*(p) += (v)) - (v))
+#define ATOMIC_LOAD_64(p)           (*(p))
+#define ATOMIC_STORE_64(p, v)       (*(p) = (v))
+#define ATOMIC_FETCH_ADD_64(p, v)   ((*(p) += (v)) - (v))
+#define ATOMIC_OR_8(p, v)           (*(p) |= (v))
+#endif
+
+// find the address of a setting for an atomic access, the setting must be one of the given types and naturally aligned
+static int resolve_atomic(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, uint16_t signed_type, uint16_t unsigned_type, void** address)
+{
+    struct kowhai_node_t* node;
+    int offset;
+    int status;
+    char* data;
+
+    status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (node->type != signed_type && node->type != unsigned_type)
+        return KOW_STATUS_INVALID_NODE_TYPE;
+    data = (char*)tree->data + offset;
+    if ((size_t)data % kowhai_get_node_type_size(node->type) != 0)
+        return KOW_STATUS_MISALIGNED;
+    *address = data;
+    return KOW_STATUS_OK;
+}
+
+// copy the snapshot page of a setting before it is changed (the copy and the store are not one atomic operation,
+// a snapshot taken while other threads write is only as consistent as it is for kowhai_write)
+static void preserve_atomic(struct kowhai_tree_t *tree, void* address, int size)
+{
+    if (tree->snapshot != NULL)
+        kowhai_snapshot_preserve(tree->snapshot, (int)((char*)address - (char*)tree->data), size);
+}
+
+// mark the dirty blocks of a setting after it is changed, the bits are set atomically so marks made by concurrent
+// atomic writers are not lost (the same as kowhai_dirty_mark otherwise, including the chained bitmaps)
+static void mark_atomic(struct kowhai_tree_t *tree, void* address, int size)
+{
+    struct kowhai_dirty_t *dirty;
+    int offset = (int)((char*)address - (char*)tree->data);
+    int block, last;
+
+    for (dirty = tree->dirty; dirty != NULL; dirty = dirty->next)
+    {
+        block = offset / dirty->block_size;
+        last = (offset + size - 1) / dirty->block_size;
+        if (last >= dirty->num_blocks)
+            last = dirty->num_blocks - 1;
+        for (; block <= last; block++)
+            ATOMIC_OR_8(&dirty->bits[block / 8], (uint8_t)(1 << (block & 7)));
+    }
+}
+
+int kowhai_atomic_load_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int32_t* result)
+{
+    void* address;
+    int status = resolve_atomic(tree, num_symbols, symbols, KOW_INT32, KOW_UINT32, &address);
+    if (status != KOW_STATUS_OK)
+        return status;
+    *result = ATOMIC_LOAD_32((volatile int32_t*)address);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_atomic_store_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int32_t value)
+{
+    void* address;
+    int status = resolve_atomic(tree, num_symbols, symbols, KOW_INT32, KOW_UINT32, &address);
+    if (status != KOW_STATUS_OK)
+        return status;
+    preserve_atomic(tree, address, sizeof(int32_t));
+    ATOMIC_STORE_32((volatile int32_t*)address, value);
+    mark_atomic(tree, address, sizeof(int32_t));
+    return KOW_STATUS_OK;
+}
+
+int kowhai_atomic_fetch_add_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int32_t value, int32_t* previous)
+{
+    void* address;
+    int32_t old;
+    int status = resolve_atomic(tree, num_symbols, symbols, KOW_INT32, KOW_UINT32, &address);
+    if (status != KOW_STATUS_OK)
+        return status;
+    preserve_atomic(tree, address, sizeof(int32_t));
+    old = ATOMIC_FETCH_ADD_32((volatile int32_t*)address, value);
+    mark_atomic(tree, address, sizeof(int32_t));
+    if (previous != NULL)
+        *previous = old;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_atomic_load_int64(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int64_t* result)
+{
+    void* address;
+    int status = resolve_atomic(tree, num_symbols, symbols, KOW_INT64, KOW_UINT64, &address);
+    if (status != KOW_STATUS_OK)
+        return status;
+    *result = ATOMIC_LOAD_64((volatile int64_t*)address);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_atomic_store_int64(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int64_t value)
+{
+    void* address;
+    int status = resolve_atomic(tree, num_symbols, symbols, KOW_INT64, KOW_UINT64, &address);
+    if (status != KOW_STATUS_OK)
+        return status;
+    preserve_atomic(tree, address, sizeof(int64_t));
+    ATOMIC_STORE_64((volatile int64_t*)address, value);
+    mark_atomic(tree, address, sizeof(int64_t));
+    return KOW_STATUS_OK;
+}
+
+int kowhai_atomic_fetch_add_int64(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int64_t value, int64_t* previous)
+{
+    void* address;
+    int64_t old;
+    int status = resolve_atomic(tree, num_symbols, symbols, KOW_INT64, KOW_UINT64, &address);
+    if (status != KOW_STATUS_OK)
+        return status;
+    preserve_atomic(tree, address, sizeof(int64_t));
+    old = ATOMIC_FETCH_ADD_64((volatile int64_t*)address, value);
+    mark_atomic(tree, address, sizeof(int64_t));
+    if (previous != NULL)
+        *previous = old;
+    return KOW_STATUS_OK;
+}
+
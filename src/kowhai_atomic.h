@@ -0,0 +1,47 @@
+#ifndef _KOWHAI_ATOMIC_H_
+#define _KOWHAI_ATOMIC_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief Atomically load a 32 bit integer setting specified by a symbol path from a settings buffer
+ * The setting must be naturally aligned in memory (packed trees may not be), KOW_STATUS_MISALIGNED is returned otherwise
+ * @param tree, the tree to read from
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the setting
+ * @param result, set to the value of the setting
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_atomic_load_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int32_t* result);
+
+/**
+ * @brief Atomically store a 32 bit integer setting specified by a symbol path in a settings buffer (see kowhai_atomic_load_int32)
+ * Snapshot pages are preserved before the store and the dirty bitmap of the tree is marked after it (the bits are set atomically, the page copy and the mark are not atomic with the store)
+ * @param tree, the tree to write to
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the setting
+ * @param value, the new value of the setting
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_atomic_store_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int32_t value);
+
+/**
+ * @brief Atomically add to a 32 bit integer setting specified by a symbol path in a settings buffer (see kowhai_atomic_load_int32)
+ * @param tree, the tree to update
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the setting
+ * @param value, the amount to add to the setting
+ * @param previous, if not NULL set to the value of the setting before the add
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_atomic_fetch_add_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int32_t value, int32_t* previous);
+
+/**
+ * @brief 64 bit integer versions of the atomic accessors above
+ */
+int kowhai_atomic_load_int64(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int64_t* result);
+int kowhai_atomic_store_int64(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int64_t value);
+int kowhai_atomic_fetch_add_int64(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int64_t value, int64_t* previous);
+
+#endif
+
@@ -0,0 +1,16 @@
+#ifndef _KOWHAI_BARRIER_H_
+#define _KOWHAI_BARRIER_H_
+
+// full memory barrier used by the lock free tree access modules (not part of the public api)
+#if defined(_MSC_VER)
+#include <windows.h>
+#define KOWHAI_BARRIER() MemoryBarrier()
+#elif defined(__GNUC__)
+#define KOWHAI_BARRIER() __sync_synchronize()
+#else
+// no barrier available, only safe on single core targets
+#define KOWHAI_BARRIER()
+#endif
+
+#endif
+
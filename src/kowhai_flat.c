@@ -0,0 +1,110 @@
+#include "kowhai_flat.h"
+
+#include <stddef.h>
+
+// bytes used by each node across all the flat arrays
+#define FLAT_NODE_SIZE (4 * sizeof(int32_t) + sizeof(kowhai_count_t) + 2 * sizeof(uint16_t))
+
+int kowhai_flat_get_buffer_size(const struct kowhai_node_t *desc, int *size)
+{
+    int num_nodes;
+    int ret = kowhai_get_node_count(desc, &num_nodes);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    *size = num_nodes * FLAT_NODE_SIZE;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_flat_init(struct kowhai_flat_desc_t *flat, const struct kowhai_node_t *desc, void *buffer, int buffer_size)
+{
+    int num_nodes, i, ret;
+    int32_t *size, *node_count, *data_offset;
+
+    if (desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    ret = kowhai_get_node_count(desc, &num_nodes);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    if (buffer_size < (int)(num_nodes * FLAT_NODE_SIZE))
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+
+    // the 32 bit arrays go first so everything stays aligned (count is 32 bit with KOWHAI_WIDE_NODES)
+    size = (int32_t*)buffer;
+    node_count = size + num_nodes;
+    data_offset = node_count + num_nodes;
+    flat->element_size = data_offset + num_nodes;
+    flat->count = (kowhai_count_t*)(flat->element_size + num_nodes);
+    flat->type = (uint16_t*)(flat->count + num_nodes);
+    flat->symbol = flat->type + num_nodes;
+
+    ret = kowhai_init_node_tables(&flat->tables, desc, num_nodes, size, node_count, data_offset);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+
+    for (i = 0; i < num_nodes; i++)
+    {
+        flat->type[i] = desc[i].type;
+        flat->symbol[i] = desc[i].symbol;
+        flat->count[i] = desc[i].count;
+        flat->element_size[i] = desc[i].count > 0 ? size[i] / desc[i].count : 0;
+    }
+
+    return KOW_STATUS_OK;
+}
+
+// search the branch starting at index i for the symbols path, offset is relative to the first array item of each parent branch
+static int flat_get_node(const struct kowhai_flat_desc_t *flat, int i, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, int *target, int initial_branch)
+{
+    int ret;
+
+    while (flat->type[i] != KOW_BRANCH_END)
+    {
+        if ((symbols->parts.name == flat->symbol[i]) && (flat->count[i] > symbols->parts.array_index))
+        {
+            int element_offset = flat->element_size[i] * symbols->parts.array_index;
+            if (num_symbols == 1)
+            {
+                *offset = element_offset;
+                *target = i;
+                return KOW_STATUS_OK;
+            }
+            if (flat->type[i] == KOW_BRANCH_START || flat->type[i] == KOW_BRANCH_U_START)
+            {
+                // this is not the target node but it is possibly in this branch
+                ret = flat_get_node(flat, i + 1, num_symbols - 1, symbols + 1, offset, target, 0);
+                if (ret == KOW_STATUS_OK)
+                {
+                    *offset += element_offset;
+                    return ret;
+                }
+                if (ret != KOW_STATUS_INVALID_SYMBOL_PATH)
+                    return ret;
+            }
+        }
+        if (initial_branch)
+            break;
+        // skip this node and all its children
+        i += flat->tables.node_count[i];
+    }
+
+    return KOW_STATUS_INVALID_SYMBOL_PATH;
+}
+
+int kowhai_flat_get_node(const struct kowhai_flat_desc_t *flat, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node)
+{
+    int index_offset, target, ret;
+
+    if (num_symbols < 1)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+
+    ret = flat_get_node(flat, 0, num_symbols, symbols, &index_offset, &target, 1);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+
+    if (offset != NULL)
+        *offset = flat->tables.data_offset[target] + index_offset;
+    if (target_node != NULL)
+        *target_node = (struct kowhai_node_t*)&flat->tables.desc[target];
+    return KOW_STATUS_OK;
+}
+
@@ -0,0 +1,50 @@
+#ifndef _KOWHAI_FLAT_H_
+#define _KOWHAI_FLAT_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief a descriptor flattened into separate contiguous arrays (one item per node)
+ * Walkers over a flat descriptor only touch the fields they need and never have to calculate
+ * sizes or skip counts. The arrays are carved out of a buffer supplied by the caller.
+ */
+struct kowhai_flat_desc_t
+{
+    struct kowhai_node_tables_t tables; ///< size, subtree skip (node_count) and data offset of each node
+    uint16_t *type;                     ///< type of each node
+    uint16_t *symbol;                   ///< symbol of each node
+    kowhai_count_t *count;              ///< array count of each node
+    int32_t *element_size;              ///< size of a single array item of each node
+};
+
+/**
+ * @brief calculate the size of the buffer needed to flatten a descriptor
+ * @param desc, the descriptor to flatten
+ * @param size, set to the number of bytes needed
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_flat_get_buffer_size(const struct kowhai_node_t *desc, int *size);
+
+/**
+ * @brief build a flat descriptor from a tree descriptor
+ * @param flat, the flat descriptor to initialise
+ * @param desc, the descriptor to flatten (this must remain valid for the life of the flat descriptor)
+ * @param buffer, storage for the flat arrays (must be aligned for int32_t access)
+ * @param buffer_size, number of bytes in buffer (see kowhai_flat_get_buffer_size)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_flat_init(struct kowhai_flat_desc_t *flat, const struct kowhai_node_t *desc, void *buffer, int buffer_size);
+
+/**
+ * @brief find a item in a flat descriptor given its path (this is the flat version of kowhai_get_node)
+ * @param flat, the flat descriptor to search
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the item to find
+ * @param offset, set to number of bytes from the start of the tree data to the item
+ * @param target_node, if return is successful this is the node (in the original descriptor) that matches the symbol path
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_flat_get_node(const struct kowhai_flat_desc_t *flat, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node);
+
+#endif
+
@@ -0,0 +1,176 @@
+#include "kowhai_image.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define ALIGN(x) (((x) + KOWHAI_IMAGE_ALIGN - 1) & ~(KOWHAI_IMAGE_ALIGN - 1))
+
+#ifdef KOWHAI_WIDE_NODES
+#define NODE_FLAGS KOWHAI_IMAGE_FLAG_WIDE_NODES
+#else
+#define NODE_FLAGS 0
+#endif
+
+// crc32 a nibble at a time, the table is small enough for flash on small targets
+static const uint32_t crc_table[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t kowhai_crc32(uint32_t crc, const void* buffer, int size)
+{
+    const uint8_t *p = (const uint8_t*)buffer;
+    crc = ~crc;
+    while (size-- > 0)
+    {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ crc_table[crc & 0xF];
+        crc = (crc >> 4) ^ crc_table[crc & 0xF];
+    }
+    return ~crc;
+}
+
+// crc of the header fields before layout_crc, the descriptor and the symbol names
+static uint32_t layout_crc(const struct kowhai_image_header_t *header)
+{
+    const char *image = (const char*)header;
+    uint32_t crc = kowhai_crc32(0, header, offsetof(struct kowhai_image_header_t, layout_crc));
+    crc = kowhai_crc32(crc, image + header->desc_offset, header->desc_size);
+    return kowhai_crc32(crc, image + header->symbols_offset, header->symbols_size);
+}
+
+// work out where each section of the image goes
+static int init_header(struct kowhai_image_header_t *header, const struct kowhai_tree_t *tree, char** symbols, int symbol_count)
+{
+    int num_nodes, data_size, symbols_size = 0;
+    int i, status;
+
+    status = kowhai_get_node_count(tree->desc, &num_nodes);
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = kowhai_get_node_size(tree->desc, &data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    for (i = 0; i < symbol_count; i++)
+        symbols_size += (int)strlen(symbols[i]) + 1;
+
+    memset(header, 0, sizeof(*header));
+    header->magic = KOWHAI_IMAGE_MAGIC;
+    header->version = KOWHAI_IMAGE_VERSION;
+    header->flags = NODE_FLAGS;
+    header->desc_offset = ALIGN(sizeof(struct kowhai_image_header_t));
+    header->desc_size = num_nodes * sizeof(struct kowhai_node_t);
+    header->symbols_offset = ALIGN(header->desc_offset + header->desc_size);
+    header->symbols_size = symbols_size;
+    header->symbol_count = symbol_count;
+    header->data_offset = ALIGN(header->symbols_offset + header->symbols_size);
+    header->data_size = data_size;
+    header->image_size = header->data_offset + header->data_size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_image_get_size(const struct kowhai_tree_t *tree, char** symbols, int symbol_count, int *size)
+{
+    struct kowhai_image_header_t header;
+    int status = init_header(&header, tree, symbols, symbol_count);
+    if (status != KOW_STATUS_OK)
+        return status;
+    *size = header.image_size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_image_create(void* image, int image_size, const struct kowhai_tree_t *tree, char** symbols, int symbol_count, int *size)
+{
+    struct kowhai_image_header_t *header = (struct kowhai_image_header_t*)image;
+    struct kowhai_image_header_t layout;
+    char *dst = (char*)image;
+    int i, status;
+
+    status = init_header(&layout, tree, symbols, symbol_count);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (image_size < (int)layout.image_size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+
+    // zero the padding so the same tree always makes the same image
+    memset(image, 0, layout.data_offset);
+    *header = layout;
+    memcpy(dst + header->desc_offset, tree->desc, header->desc_size);
+    dst += header->symbols_offset;
+    for (i = 0; i < symbol_count; i++)
+    {
+        int len = (int)strlen(symbols[i]) + 1;
+        memcpy(dst, symbols[i], len);
+        dst += len;
+    }
+    memcpy((char*)image + header->data_offset, tree->data, header->data_size);
+
+    header->layout_crc = layout_crc(header);
+    header->data_crc = kowhai_crc32(0, (char*)image + header->data_offset, header->data_size);
+    *size = header->image_size;
+    return KOW_STATUS_OK;
+}
+
+// check a section lies inside the image
+static int in_image(uint32_t offset, uint32_t size, uint32_t image_size)
+{
+    return offset <= image_size && size <= image_size - offset;
+}
+
+int kowhai_image_load(void* image, int image_size, int verify, struct kowhai_tree_t *tree, char** symbol_list, int *symbol_list_size)
+{
+    struct kowhai_image_header_t *header = (struct kowhai_image_header_t*)image;
+    char *base = (char*)image;
+    struct kowhai_node_t *desc;
+    int data_size, status;
+
+    // the fast checks, none of these read more than the header
+    if (image_size < (int)sizeof(struct kowhai_image_header_t) || header->magic != KOWHAI_IMAGE_MAGIC)
+        return KOW_STATUS_BUFFER_INVALID;
+    if (header->version != KOWHAI_IMAGE_VERSION || header->flags != NODE_FLAGS)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    // a truncated image
+    if (header->image_size > (uint32_t)image_size)
+        return KOW_STATUS_BUFFER_INVALID;
+    if (!in_image(header->desc_offset, header->desc_size, header->image_size) ||
+        !in_image(header->symbols_offset, header->symbols_size, header->image_size) ||
+        !in_image(header->data_offset, header->data_size, header->image_size) ||
+        header->desc_size < sizeof(struct kowhai_node_t) || header->desc_size % sizeof(struct kowhai_node_t) != 0)
+        return KOW_STATUS_BUFFER_INVALID;
+
+    // the layout is small so it is always checked before the descriptor is walked
+    if (layout_crc(header) != header->layout_crc)
+        return KOW_STATUS_CHECKSUM_MISMATCH;
+    desc = (struct kowhai_node_t*)(base + header->desc_offset);
+    status = kowhai_check_descriptor(desc, header->desc_size / sizeof(struct kowhai_node_t));
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = kowhai_get_node_size(desc, &data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if ((uint32_t)data_size != header->data_size)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    if (header->symbols_size > 0 && base[header->symbols_offset + header->symbols_size - 1] != 0)
+        return KOW_STATUS_BUFFER_INVALID;
+
+    if (verify == KOWHAI_IMAGE_VERIFY_DATA &&
+        kowhai_crc32(0, base + header->data_offset, header->data_size) != header->data_crc)
+        return KOW_STATUS_CHECKSUM_MISMATCH;
+
+    kowhai_tree_init(tree, desc, base + header->data_offset);
+    if (symbol_list != NULL)
+        *symbol_list = base + header->symbols_offset;
+    if (symbol_list_size != NULL)
+        *symbol_list_size = header->symbols_size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_image_update_checksum(void* image)
+{
+    struct kowhai_image_header_t *header = (struct kowhai_image_header_t*)image;
+    if (header->magic != KOWHAI_IMAGE_MAGIC)
+        return KOW_STATUS_BUFFER_INVALID;
+    header->data_crc = kowhai_crc32(0, (char*)image + header->data_offset, header->data_size);
+    return KOW_STATUS_OK;
+}
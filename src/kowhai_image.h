@@ -0,0 +1,93 @@
+#ifndef _KOWHAI_IMAGE_H_
+#define _KOWHAI_IMAGE_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief a binary image of a tree is a header followed by the descriptor, the symbol names and the tree data
+ * Each section starts on a KOWHAI_IMAGE_ALIGN boundary and is stored exactly as it is used in memory, so
+ * an image that is mapped (eg with mmap) or read into memory can be used as a tree without any parsing.
+ * Values are in native byte order, an image from a machine with the other byte order fails the magic check.
+ */
+#define KOWHAI_IMAGE_MAGIC              0x494F574B  ///< "KOWI"
+#define KOWHAI_IMAGE_VERSION            1
+#define KOWHAI_IMAGE_ALIGN              8
+#define KOWHAI_IMAGE_FLAG_WIDE_NODES    0x0001      ///< the descriptor uses the KOWHAI_WIDE_NODES node format
+
+/**
+ * @brief options for kowhai_image_load
+ */
+#define KOWHAI_IMAGE_VERIFY_LAYOUT      0           ///< check the header, descriptor and symbols (these are small)
+#define KOWHAI_IMAGE_VERIFY_DATA        1           ///< also check the tree data against its checksum
+
+/**
+ * @brief the header at the start of a binary tree image (offsets are from the start of the image)
+ */
+struct kowhai_image_header_t
+{
+    uint32_t magic;             ///< KOWHAI_IMAGE_MAGIC
+    uint16_t version;           ///< KOWHAI_IMAGE_VERSION
+    uint16_t flags;             ///< KOWHAI_IMAGE_FLAG_xxx
+    uint32_t image_size;        ///< number of bytes in the whole image
+    uint32_t desc_offset;       ///< offset of the descriptor nodes
+    uint32_t desc_size;         ///< number of bytes of descriptor nodes
+    uint32_t symbols_offset;    ///< offset of the symbol names (NULL terminated names one after the other like KOW_CMD_GET_SYMBOL_LIST)
+    uint32_t symbols_size;      ///< number of bytes of symbol names
+    uint32_t symbol_count;      ///< number of symbol names
+    uint32_t data_offset;       ///< offset of the tree data
+    uint32_t data_size;         ///< number of bytes of tree data
+    uint32_t layout_crc;        ///< crc32 of the header fields above, the descriptor and the symbol names
+    uint32_t data_crc;          ///< crc32 of the tree data
+};
+
+/**
+ * @brief update a crc32 (the zip/ethernet polynomial) with a buffer
+ * @param crc, the crc so far (0 to start)
+ * @param buffer, the bytes to add
+ * @param size, number of bytes in buffer
+ * @return the updated crc
+ */
+uint32_t kowhai_crc32(uint32_t crc, const void* buffer, int size);
+
+/**
+ * @brief get the number of bytes needed for the image of a tree
+ * @param tree, the tree to make an image of
+ * @param symbols, symbol names indexed by symbol id (or NULL if the image has no symbol names)
+ * @param symbol_count, number of items in symbols
+ * @param size, set to the image size in bytes
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_image_get_size(const struct kowhai_tree_t *tree, char** symbols, int symbol_count, int *size);
+
+/**
+ * @brief make the image of a tree (eg to write to a file)
+ * @param image, buffer to make the image in (this should be KOWHAI_IMAGE_ALIGN aligned)
+ * @param image_size, number of bytes in image
+ * @param tree, the tree to make an image of
+ * @param symbols, symbol names indexed by symbol id (or NULL if the image has no symbol names)
+ * @param symbol_count, number of items in symbols
+ * @param size, set to the number of bytes of image used
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_image_create(void* image, int image_size, const struct kowhai_tree_t *tree, char** symbols, int symbol_count, int *size);
+
+/**
+ * @brief check an image and make a tree that uses the descriptor and data in place (nothing is copied)
+ * @param image, the image (eg mapped from a file), it must remain valid for the life of the tree
+ * @param image_size, number of bytes in image
+ * @param verify, KOWHAI_IMAGE_VERIFY_LAYOUT or KOWHAI_IMAGE_VERIFY_DATA
+ * @param tree, set to the tree in the image (it has no dirty bitmap or snapshot)
+ * @param symbol_list, if not NULL set to the symbol names in the image (see kowhai_symbol_table_split_list)
+ * @param symbol_list_size, if not NULL set to the number of bytes of symbol names
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error (KOW_STATUS_CHECKSUM_MISMATCH if the image is corrupt)
+ */
+int kowhai_image_load(void* image, int image_size, int verify, struct kowhai_tree_t *tree, char** symbol_list, int *symbol_list_size);
+
+/**
+ * @brief recalculate the data checksum after the tree data in an image has been changed in place
+ * @param image, the image
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_image_update_checksum(void* image);
+
+#endif
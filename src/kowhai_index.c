@@ -0,0 +1,421 @@
+#include "kowhai_index.h"
+
+#include <string.h>
+
+#define HASH_SEED  2166136261u
+#define HASH_PRIME 16777619u
+
+#define IS_BRANCH(node) ((node)->type == KOW_BRANCH_START || (node)->type == KOW_BRANCH_U_START)
+
+// fold the next symbol of a path into a running path hash (fnv-1a over the symbol name and array index)
+static uint32_t hash_symbol(uint32_t hash, uint16_t name, uint16_t array_index)
+{
+    uint32_t symbol = ((uint32_t)array_index << 16) | name;
+    int i;
+    for (i = 0; i < 4; i++)
+    {
+        hash ^= (symbol >> (i * 8)) & 0xFF;
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+// count the entries needed by the children of a branch (multiplier is the number of times the branch is repeated)
+static int count_entries(const struct kowhai_node_t *branch, int multiplier, int *count, int *num_nodes_processed)
+{
+    int i = 1;
+    while (branch[i].type != KOW_BRANCH_END)
+    {
+        *count += multiplier;
+        if (IS_BRANCH(&branch[i]))
+        {
+            int child_nodes_processed;
+            int ret = count_entries(branch + i, multiplier * branch[i].count, count, &child_nodes_processed);
+            if (ret != KOW_STATUS_OK)
+                return ret;
+            i += child_nodes_processed;
+        }
+        i++;
+    }
+    *num_nodes_processed = i;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_path_index_get_entry_count(const struct kowhai_node_t *desc, int *count)
+{
+    int num_nodes_processed;
+    if (desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    // the root node plus all its children
+    *count = 1;
+    return count_entries(desc, desc->count, count, &num_nodes_processed);
+}
+
+// insert a node into the hash table, slot is set to -1 if the path was already present
+static int add_entry(struct kowhai_path_index_t *index, uint32_t hash, int node, int parent, uint16_t parent_index, int offset, int element_size, int *slot)
+{
+    int probe;
+    int s = hash % index->entry_count;
+
+    for (probe = 0; probe < index->entry_count; probe++)
+    {
+        struct kowhai_path_index_entry_t *entry = &index->entries[s];
+        if (entry->node < 0)
+        {
+            entry->hash = hash;
+            entry->node = node;
+            entry->parent = parent;
+            entry->parent_index = parent_index;
+            entry->offset = offset;
+            entry->element_size = element_size;
+            index->used_count++;
+            *slot = s;
+            return KOW_STATUS_OK;
+        }
+        // kowhai_get_node finds the first sibling with a matching symbol so ignore any later ones
+        if (entry->hash == hash && entry->parent == parent && entry->parent_index == parent_index &&
+            index->desc[entry->node].symbol == index->desc[node].symbol)
+        {
+            *slot = -1;
+            return KOW_STATUS_OK;
+        }
+        s = (s + 1) % index->entry_count;
+    }
+
+    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+}
+
+// add entries for all the children of a single array item of a branch
+static int index_branch(struct kowhai_path_index_t *index, int branch, int branch_slot, uint16_t array_index, uint32_t prefix, int offset)
+{
+    const struct kowhai_node_t *desc = index->desc;
+    int in_union = desc[branch].type == KOW_BRANCH_U_START;
+    int i = branch + 1;
+
+    while (desc[i].type != KOW_BRANCH_END)
+    {
+        int size, count, slot, element_size, ret;
+
+        ret = kowhai_get_node_size(&desc[i], &size);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        if (size < 0)
+            return KOW_STATUS_INVALID_DESCRIPTOR;
+        ret = kowhai_get_node_count(&desc[i], &count);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        element_size = desc[i].count > 0 ? size / desc[i].count : 0;
+
+        ret = add_entry(index, hash_symbol(prefix, desc[i].symbol, 0), i, branch_slot, array_index, offset, element_size, &slot);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+
+        // index each array item of child branches too
+        if (slot >= 0 && IS_BRANCH(&desc[i]))
+        {
+            int j;
+            for (j = 0; j < desc[i].count; j++)
+            {
+                ret = index_branch(index, i, slot, (uint16_t)j, hash_symbol(prefix, desc[i].symbol, (uint16_t)j), offset + j * element_size);
+                if (ret != KOW_STATUS_OK)
+                    return ret;
+            }
+        }
+
+        if (!in_union)
+            offset += size;
+        i += count;
+    }
+
+    return KOW_STATUS_OK;
+}
+
+int kowhai_path_index_init(struct kowhai_path_index_t *index, const struct kowhai_node_t *desc, struct kowhai_path_index_entry_t *entries, int entry_count)
+{
+    int i, j, size, slot, element_size, ret;
+
+    if (desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    if (entry_count < 1)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+
+    index->desc = desc;
+    index->entries = entries;
+    index->entry_count = entry_count;
+    index->used_count = 0;
+    for (i = 0; i < entry_count; i++)
+        entries[i].node = -1;
+
+    // add the root node then everything below it
+    ret = kowhai_get_node_size(desc, &size);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    element_size = desc->count > 0 ? size / desc->count : 0;
+    ret = add_entry(index, hash_symbol(HASH_SEED, desc->symbol, 0), 0, -1, 0, 0, element_size, &slot);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    for (j = 0; j < desc->count; j++)
+    {
+        ret = index_branch(index, 0, slot, (uint16_t)j, hash_symbol(HASH_SEED, desc->symbol, (uint16_t)j), j * element_size);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+    }
+
+    return KOW_STATUS_OK;
+}
+
+// check the entry in slot really is the node for this symbol path (and not just a hash collision)
+static int entry_matches_path(const struct kowhai_path_index_t *index, int slot, int num_symbols, const union kowhai_symbol_t *symbols)
+{
+    int i = num_symbols - 1;
+    const struct kowhai_path_index_entry_t *entry = &index->entries[slot];
+
+    if (index->desc[entry->node].symbol != symbols[i].parts.name)
+        return 0;
+    // walk up the parents checking the symbol and array index at each level
+    while (i > 0)
+    {
+        const struct kowhai_path_index_entry_t *parent;
+        i--;
+        if (entry->parent < 0)
+            return 0;
+        parent = &index->entries[entry->parent];
+        if (index->desc[parent->node].symbol != symbols[i].parts.name ||
+            entry->parent_index != symbols[i].parts.array_index)
+            return 0;
+        entry = parent;
+    }
+    return entry->parent < 0;
+}
+
+int kowhai_path_index_get_node(const struct kowhai_path_index_t *index, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node)
+{
+    int i, probe, slot;
+    uint32_t hash = HASH_SEED;
+
+    if (num_symbols < 1)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+
+    // hash the path, the array index of the last symbol is not part of the key
+    for (i = 0; i < num_symbols - 1; i++)
+        hash = hash_symbol(hash, symbols[i].parts.name, symbols[i].parts.array_index);
+    hash = hash_symbol(hash, symbols[i].parts.name, 0);
+
+    slot = hash % index->entry_count;
+    for (probe = 0; probe < index->entry_count; probe++)
+    {
+        const struct kowhai_path_index_entry_t *entry = &index->entries[slot];
+        if (entry->node < 0)
+            break;
+        if (entry->hash == hash && entry_matches_path(index, slot, num_symbols, symbols))
+        {
+            const struct kowhai_node_t *node = &index->desc[entry->node];
+            uint16_t array_index = symbols[num_symbols - 1].parts.array_index;
+            if (array_index >= node->count)
+                return KOW_STATUS_INVALID_SYMBOL_PATH;
+            if (offset != NULL)
+                *offset = entry->offset + entry->element_size * array_index;
+            if (target_node != NULL)
+                *target_node = (struct kowhai_node_t *)node;
+            return KOW_STATUS_OK;
+        }
+        slot = (slot + 1) % index->entry_count;
+    }
+
+    return KOW_STATUS_INVALID_SYMBOL_PATH;
+}
+
+// count the offset index entries needed by the children of a branch (multiplier is the number of times each child is repeated)
+static int count_offset_entries(const struct kowhai_node_t *branch, int multiplier, int *leaf_count, int *branch_count, int *num_nodes_processed)
+{
+    int i = 1;
+    while (branch[i].type != KOW_BRANCH_END)
+    {
+        if (IS_BRANCH(&branch[i]))
+        {
+            int child_nodes_processed;
+            int ret;
+            *branch_count += multiplier * branch[i].count;
+            ret = count_offset_entries(branch + i, multiplier * branch[i].count, leaf_count, branch_count, &child_nodes_processed);
+            if (ret != KOW_STATUS_OK)
+                return ret;
+            i += child_nodes_processed;
+        }
+        else if (branch[i].count > 0)
+            *leaf_count += multiplier;
+        i++;
+    }
+    *num_nodes_processed = i;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_offset_index_get_entry_count(const struct kowhai_node_t *desc, int *leaf_count, int *branch_count)
+{
+    int num_nodes_processed;
+    if (desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    *leaf_count = 0;
+    *branch_count = desc->count;
+    return count_offset_entries(desc, desc->count, leaf_count, branch_count, &num_nodes_processed);
+}
+
+// add a branch array item to an offset index
+static int add_offset_branch(struct kowhai_offset_index_t *index, int size, int node, int parent, uint16_t array_index, int *entry)
+{
+    struct kowhai_offset_index_branch_t *branch;
+    if (index->branch_count >= size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    branch = &index->branches[index->branch_count];
+    branch->node = node;
+    branch->parent = parent;
+    branch->array_index = array_index;
+    *entry = index->branch_count++;
+    return KOW_STATUS_OK;
+}
+
+// add leaf entries for all the children of a single array item of a branch (entries are added in descriptor order)
+static int offset_index_branch(struct kowhai_offset_index_t *index, int leaf_size, int branch_size, int branch, int branch_entry, int offset)
+{
+    const struct kowhai_node_t *desc = index->desc;
+    int in_union = desc[branch].type == KOW_BRANCH_U_START;
+    int i = branch + 1;
+
+    while (desc[i].type != KOW_BRANCH_END)
+    {
+        int size, count, ret;
+
+        ret = kowhai_get_node_size(&desc[i], &size);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        if (size < 0)
+            return KOW_STATUS_INVALID_DESCRIPTOR;
+        ret = kowhai_get_node_count(&desc[i], &count);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+
+        if (IS_BRANCH(&desc[i]))
+        {
+            int j, entry;
+            for (j = 0; j < desc[i].count; j++)
+            {
+                ret = add_offset_branch(index, branch_size, i, branch_entry, (uint16_t)j, &entry);
+                if (ret != KOW_STATUS_OK)
+                    return ret;
+                ret = offset_index_branch(index, leaf_size, branch_size, i, entry, offset + j * (size / desc[i].count));
+                if (ret != KOW_STATUS_OK)
+                    return ret;
+            }
+        }
+        else if (desc[i].count > 0)
+        {
+            struct kowhai_offset_index_leaf_t *leaf;
+            if (index->leaf_count >= leaf_size)
+                return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            leaf = &index->leaves[index->leaf_count];
+            leaf->offset = offset;
+            leaf->size = size;
+            leaf->node = i;
+            leaf->parent = branch_entry;
+            index->leaf_count++;
+        }
+
+        if (!in_union)
+            offset += size;
+        i += count;
+    }
+
+    return KOW_STATUS_OK;
+}
+
+int kowhai_offset_index_init(struct kowhai_offset_index_t *index, const struct kowhai_node_t *desc, struct kowhai_offset_index_leaf_t *leaves, int leaf_count, struct kowhai_offset_index_branch_t *branches, int branch_count)
+{
+    int i, j, size, entry, ret;
+
+    if (desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+
+    index->desc = desc;
+    index->leaves = leaves;
+    index->leaf_count = 0;
+    index->branches = branches;
+    index->branch_count = 0;
+
+    ret = kowhai_get_node_size(desc, &size);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    for (j = 0; j < desc->count; j++)
+    {
+        ret = add_offset_branch(index, branch_count, 0, -1, (uint16_t)j, &entry);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        ret = offset_index_branch(index, leaf_count, branch_count, 0, entry, j * (size / desc->count));
+        if (ret != KOW_STATUS_OK)
+            return ret;
+    }
+
+    // the leaves are in descriptor order which is only out of offset order where union members overlap (a member
+    // that is a branch has leaves after the start of the union) so an insertion sort is nearly linear
+    for (i = 1; i < index->leaf_count; i++)
+    {
+        struct kowhai_offset_index_leaf_t leaf = leaves[i];
+        for (j = i; j > 0 && leaves[j - 1].offset > leaf.offset; j--)
+            leaves[j] = leaves[j - 1];
+        leaves[j] = leaf;
+    }
+    for (i = 0; i < index->leaf_count; i++)
+    {
+        leaves[i].max_end = leaves[i].offset + leaves[i].size;
+        if (i > 0 && leaves[i - 1].max_end > leaves[i].max_end)
+            leaves[i].max_end = leaves[i - 1].max_end;
+    }
+
+    return KOW_STATUS_OK;
+}
+
+int kowhai_offset_index_get_path(const struct kowhai_offset_index_t *index, int offset, union kowhai_symbol_t *target, int *target_size)
+{
+    const struct kowhai_offset_index_leaf_t *leaf;
+    const struct kowhai_node_t *node;
+    int lo = 0, hi = index->leaf_count;
+    int i, entry, num_symbols;
+
+    // find the last leaf that starts at or before the offset
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (index->leaves[mid].offset <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    // union members overlap so earlier leaves may cover the offset too, max_end says when to stop looking, the
+    // last member in the descriptor wins (overlapping leaves are never items of the same array so the node index orders them)
+    leaf = NULL;
+    for (i = lo - 1; i >= 0 && index->leaves[i].max_end > offset; i--)
+    {
+        if (offset < index->leaves[i].offset + index->leaves[i].size && (leaf == NULL || index->leaves[i].node > leaf->node))
+            leaf = &index->leaves[i];
+    }
+    if (leaf == NULL)
+        return KOW_STATUS_NOT_FOUND;
+
+    // one symbol for the leaf and one for each branch it is in
+    num_symbols = 1;
+    for (entry = leaf->parent; entry >= 0; entry = index->branches[entry].parent)
+        num_symbols++;
+    if (*target_size < num_symbols)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    *target_size = num_symbols;
+
+    node = &index->desc[leaf->node];
+    i = num_symbols - 1;
+    target[i].symbol = KOWHAI_SYMBOL(node->symbol, (offset - leaf->offset) / kowhai_get_node_type_size(node->type));
+    for (entry = leaf->parent; entry >= 0; entry = index->branches[entry].parent)
+    {
+        i--;
+        target[i].symbol = KOWHAI_SYMBOL(index->desc[index->branches[entry].node].symbol, index->branches[entry].array_index);
+    }
+
+    return KOW_STATUS_OK;
+}
@@ -0,0 +1,132 @@
+#ifndef _KOWHAI_INDEX_H_
+#define _KOWHAI_INDEX_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief a single slot in a path index hash table
+ * Each entry describes one node for one combination of parent branch array indices,
+ * the array index of the node itself is not part of the key (it is applied to the offset on lookup)
+ */
+struct kowhai_path_index_entry_t
+{
+    uint32_t hash;              ///< hash of the symbol path to this node (excluding the array index of the node itself)
+    int32_t node;               ///< index of this node in the descriptor, or -1 if this slot is empty
+    int32_t parent;             ///< slot of the parent branch entry, or -1 if this is the root node
+    uint16_t parent_index;      ///< array index of the parent branch that this entry belongs to
+    int32_t offset;             ///< number of bytes from the start of the tree data to the first array item of this node
+    int32_t element_size;       ///< size of a single array item of this node in bytes
+};
+
+/**
+ * @brief a compiled descriptor that maps a full symbol path to its node and data offset in constant time
+ */
+struct kowhai_path_index_t
+{
+    const struct kowhai_node_t *desc;           ///< the descriptor this index was built from
+    struct kowhai_path_index_entry_t *entries;  ///< hash table slots (supplied by the caller)
+    int entry_count;                            ///< number of slots in the entries table
+    int used_count;                             ///< number of slots populated
+};
+
+/**
+ * @brief calculate the number of entries needed to index a descriptor
+ * The entries table given to kowhai_path_index_init must have at least this many slots, lookups
+ * are faster if the table is sparse so around twice this number is a good choice
+ * @param desc, the tree descriptor to index
+ * @param count, set to the minimum number of entries needed
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_path_index_get_entry_count(const struct kowhai_node_t *desc, int *count);
+
+/**
+ * @brief build a path index from a tree descriptor
+ * @param index, the index to initialise
+ * @param desc, the tree descriptor to index (this must remain valid for the life of the index)
+ * @param entries, storage for the hash table slots
+ * @param entry_count, number of slots in entries (see kowhai_path_index_get_entry_count)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_path_index_init(struct kowhai_path_index_t *index, const struct kowhai_node_t *desc, struct kowhai_path_index_entry_t *entries, int entry_count);
+
+/**
+ * @brief find a item in an indexed tree given its path (this is the indexed version of kowhai_get_node)
+ * @param index, the index of the tree to search
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the item to find
+ * @param offset, set to number of bytes from the start of the tree data to the item
+ * @param target_node, if return is successful this is the node that matches the symbol path
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_path_index_get_node(const struct kowhai_path_index_t *index, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node);
+
+/**
+ * @brief a leaf node in an offset index
+ * There is a leaf entry for each leaf node for each combination of parent branch array indices, it
+ * covers all the array items of the leaf
+ */
+struct kowhai_offset_index_leaf_t
+{
+    int32_t offset;             ///< number of bytes from the start of the tree data to the first array item of this leaf
+    int32_t size;               ///< size of all the array items of this leaf in bytes
+    int32_t max_end;            ///< largest end offset of this and all previous leaf entries (union members overlap)
+    int32_t node;               ///< index of the leaf node in the descriptor
+    int32_t parent;             ///< branch entry of the array item this leaf belongs to
+};
+
+/**
+ * @brief a single array item of a branch in an offset index
+ */
+struct kowhai_offset_index_branch_t
+{
+    int32_t node;               ///< index of the branch node in the descriptor
+    int32_t parent;             ///< branch entry of the parent array item, or -1 if this is an array item of the root node
+    uint16_t array_index;       ///< array index of this branch item
+};
+
+/**
+ * @brief a compiled descriptor that maps a data offset to its symbol path in logarithmic time
+ */
+struct kowhai_offset_index_t
+{
+    const struct kowhai_node_t *desc;               ///< the descriptor this index was built from
+    struct kowhai_offset_index_leaf_t *leaves;      ///< leaf entries ordered by offset (supplied by the caller)
+    int leaf_count;                                 ///< number of leaf entries populated
+    struct kowhai_offset_index_branch_t *branches;  ///< branch entries (supplied by the caller)
+    int branch_count;                               ///< number of branch entries populated
+};
+
+/**
+ * @brief calculate the number of entries needed to build an offset index of a descriptor
+ * @param desc, the tree descriptor to index
+ * @param leaf_count, set to the number of leaf entries needed
+ * @param branch_count, set to the number of branch entries needed
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_offset_index_get_entry_count(const struct kowhai_node_t *desc, int *leaf_count, int *branch_count);
+
+/**
+ * @brief build an offset index from a tree descriptor
+ * @param index, the index to initialise
+ * @param desc, the tree descriptor to index (this must remain valid for the life of the index)
+ * @param leaves, storage for the leaf entries
+ * @param leaf_count, number of items in leaves (see kowhai_offset_index_get_entry_count)
+ * @param branches, storage for the branch entries
+ * @param branch_count, number of items in branches (see kowhai_offset_index_get_entry_count)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_offset_index_init(struct kowhai_offset_index_t *index, const struct kowhai_node_t *desc, struct kowhai_offset_index_leaf_t *leaves, int leaf_count, struct kowhai_offset_index_branch_t *branches, int branch_count);
+
+/**
+ * @brief create the symbol path of the leaf item at an offset in the tree data (this is the indexed version of kowhai_create_symbol_path2)
+ * If the offset is inside a union the path is to the last member in the descriptor that covers the offset
+ * @param index, the index of the tree
+ * @param offset, number of bytes from the start of the tree data
+ * @param target, the target buffer for the symbol path
+ * @param target_size, the number of symbols target can hold, updated to the length of the symbol path
+ * @return kowhai status value, ie KOW_STATUS_OK on success, KOW_STATUS_NOT_FOUND if no leaf covers the offset or other on error
+ */
+int kowhai_offset_index_get_path(const struct kowhai_offset_index_t *index, int offset, union kowhai_symbol_t *target, int *target_size);
+
+#endif
+
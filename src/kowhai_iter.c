@@ -0,0 +1,188 @@
+#include "kowhai_iter.h"
+
+#include <stddef.h>
+
+// get the size and node count of a node from the tables or by walking the descriptor using the free frames of the stack
+static int get_node_info(struct kowhai_iter_t *iter, const struct kowhai_node_t *node, int *size, int *count)
+{
+    int ret;
+
+    if (iter->tables != NULL)
+    {
+        int i = node - iter->tables->desc;
+        if (size != NULL)
+            *size = iter->tables->size[i];
+        if (count != NULL)
+            *count = iter->tables->node_count[i];
+        return KOW_STATUS_OK;
+    }
+
+    iter->stack->depth = iter->base + iter->depth;
+    ret = KOW_STATUS_OK;
+    if (size != NULL)
+        ret = kowhai_get_node_size_ex(node, size, iter->stack);
+    if (ret == KOW_STATUS_OK && count != NULL)
+        ret = kowhai_get_node_count_ex(node, count, iter->stack);
+    iter->stack->depth = iter->base;
+    return ret;
+}
+
+// is the level at depth inside a union (so every node at that level starts at the same data)
+static int level_is_union(struct kowhai_iter_t *iter, int depth)
+{
+    if (depth == 0)
+        return 0;
+    return kowhai_walk_stack_frame(iter->stack, iter->base + depth - 1)->node->type == KOW_BRANCH_U_START;
+}
+
+// the branch at the current depth is done, carry on after it in the parent level
+static void close_branch(struct kowhai_iter_t *iter, int node_count)
+{
+    struct kowhai_walk_frame_t *frame = kowhai_walk_stack_frame(iter->stack, iter->base + iter->depth - 1);
+    const struct kowhai_node_t *branch = frame->node;
+
+    iter->depth--;
+    iter->next_node = branch + node_count;
+    if (level_is_union(iter, iter->depth))
+        iter->next_data = kowhai_walk_stack_frame(iter->stack, iter->base + iter->depth - 1)->data;
+    else
+        // the end of the branch is the start of the current array item plus the rest of the array items
+        iter->next_data = (char*)frame->data + frame->value[0] * (branch->count - frame->index);
+}
+
+int kowhai_iter_init(struct kowhai_iter_t *iter, struct kowhai_tree_t *tree, const struct kowhai_node_tables_t *tables, struct kowhai_walk_stack_t *stack, union kowhai_symbol_t *path, int path_len)
+{
+    if (tree->desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    if (tables != NULL && tables->desc != tree->desc)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+
+    iter->tree = *tree;
+    iter->tables = tables;
+    iter->stack = stack;
+    iter->base = stack->depth;
+    iter->path = path;
+    iter->path_len = path_len;
+    iter->node = NULL;
+    iter->array_index = 0;
+    iter->data = NULL;
+    iter->depth = 0;
+    iter->next_node = tree->desc;
+    iter->next_data = tree->data;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_iter_next(struct kowhai_iter_t *iter)
+{
+    struct kowhai_walk_frame_t *frame;
+    const struct kowhai_node_t *node;
+    int size, count, ret;
+
+    // next array item of the current leaf
+    if (iter->node != NULL && iter->array_index + 1 < iter->node->count)
+    {
+        iter->array_index++;
+        iter->data = (char*)iter->data + kowhai_get_node_type_size(iter->node->type);
+        iter->path[iter->depth].parts.array_index = iter->array_index;
+        return KOW_STATUS_OK;
+    }
+    iter->node = NULL;
+
+    while (1)
+    {
+        // the root is the only node at the top level
+        if (iter->depth == 0 && iter->next_node != iter->tree.desc)
+            return KOW_STATUS_NOT_FOUND;
+        if (iter->depth >= iter->path_len)
+            return KOW_STATUS_PATH_TOO_SMALL;
+
+        node = iter->next_node;
+        switch (node->type)
+        {
+            case KOW_BRANCH_END:
+                frame = kowhai_walk_stack_frame(iter->stack, iter->base + iter->depth - 1);
+                if (frame->index + 1 < frame->node->count)
+                {
+                    // start on the next array item of this branch
+                    frame->index++;
+                    frame->data = (char*)frame->data + frame->value[0];
+                    iter->path[iter->depth - 1].parts.array_index = frame->index;
+                    iter->next_node = frame->node + 1;
+                    iter->next_data = frame->data;
+                }
+                else
+                    close_branch(iter, node - frame->node + 1);
+                break;
+
+            case KOW_BRANCH_START:
+            case KOW_BRANCH_U_START:
+                if (node->count == 0)
+                {
+                    // nothing to visit in an empty branch
+                    ret = get_node_info(iter, node, NULL, &count);
+                    if (ret != KOW_STATUS_OK)
+                        return ret;
+                    iter->next_node = node + count;
+                    break;
+                }
+                ret = get_node_info(iter, node, &size, NULL);
+                if (ret != KOW_STATUS_OK)
+                    return ret;
+                frame = kowhai_walk_stack_push(iter->stack, iter->base + iter->depth);
+                if (frame == NULL)
+                    return KOW_STATUS_STACK_TOO_SMALL;
+                frame->node = node;
+                frame->data = iter->next_data;
+                frame->index = 0;
+                frame->value[0] = size / node->count;
+                iter->path[iter->depth].symbol = KOWHAI_SYMBOL(node->symbol, 0);
+                iter->depth++;
+                iter->next_node = node + 1;
+                break;
+
+            default:
+                size = kowhai_get_node_type_size(node->type);
+                if (size < 0)
+                    return KOW_STATUS_INVALID_NODE_TYPE;
+                iter->next_node = node + 1;
+                if (node->count == 0)
+                    break;
+                // this leaf is the current item, the next node starts after it (unless this is a union)
+                iter->node = node;
+                iter->array_index = 0;
+                iter->data = iter->next_data;
+                iter->path[iter->depth].symbol = KOWHAI_SYMBOL(node->symbol, 0);
+                if (!level_is_union(iter, iter->depth))
+                    iter->next_data = (char*)iter->next_data + size * node->count;
+                return KOW_STATUS_OK;
+        }
+    }
+}
+
+int kowhai_iter_skip(struct kowhai_iter_t *iter, int depth)
+{
+    if (depth < 0 || depth > iter->depth)
+        return KOW_STATUS_INVALID_OFFSET;
+
+    if (depth == iter->depth)
+    {
+        // the rest of the current leaf node
+        if (iter->node != NULL)
+            iter->array_index = iter->node->count - 1;
+        return KOW_STATUS_OK;
+    }
+
+    // close every branch up to and including the one at depth
+    iter->node = NULL;
+    while (iter->depth > depth)
+    {
+        struct kowhai_walk_frame_t *frame = kowhai_walk_stack_frame(iter->stack, iter->base + iter->depth - 1);
+        int count, ret;
+        ret = get_node_info(iter, frame->node, NULL, &count);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        close_branch(iter, count);
+    }
+    return KOW_STATUS_OK;
+}
+
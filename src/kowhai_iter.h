@@ -0,0 +1,56 @@
+#ifndef _KOWHAI_ITER_H_
+#define _KOWHAI_ITER_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief iterates over every leaf array item of a tree in document order
+ * Union members all start at the same data so each member is visited in turn. The iterator
+ * keeps a walk stack frame for each branch it is inside, branches are skipped in constant time
+ * if node tables are given (otherwise skipping walks the skipped descriptor nodes).
+ */
+struct kowhai_iter_t
+{
+    struct kowhai_tree_t tree;                  ///< the tree being iterated
+    const struct kowhai_node_tables_t *tables;  ///< precomputed tables for the tree descriptor (or NULL)
+    struct kowhai_walk_stack_t *stack;          ///< frames for the branches the current item is in
+    int base;                                   ///< first frame of the stack used by this iterator
+    union kowhai_symbol_t *path;                ///< path of the current item
+    int path_len;                               ///< number of symbols the path buffer can hold
+    const struct kowhai_node_t *node;           ///< leaf node of the current item (NULL before the first item)
+    int array_index;                            ///< array index of the current item
+    void *data;                                 ///< data of the current item
+    int depth;                                  ///< number of branches the current item is in (the path has depth + 1 symbols)
+    const struct kowhai_node_t *next_node;      ///< next node to visit once the current leaf is done
+    void *next_data;                            ///< data of next_node
+};
+
+/**
+ * @brief start iterating over a tree
+ * @param iter, the iterator to initialise
+ * @param tree, the tree to iterate over (the tree data must stay valid while iterating)
+ * @param tables, node tables built from the tree descriptor to make skipping constant time, or NULL
+ * @param stack, a frame is used for each level of branch nesting in the tree
+ * @param path, buffer for the path of the current item
+ * @param path_len, number of symbols path can hold (must be at least the deepest path in the tree)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_iter_init(struct kowhai_iter_t *iter, struct kowhai_tree_t *tree, const struct kowhai_node_tables_t *tables, struct kowhai_walk_stack_t *stack, union kowhai_symbol_t *path, int path_len);
+
+/**
+ * @brief move to the next leaf array item
+ * @param iter, the iterator to move on
+ * @return KOW_STATUS_OK if there is a current item, KOW_STATUS_NOT_FOUND once all the items have been visited or other on error
+ */
+int kowhai_iter_next(struct kowhai_iter_t *iter);
+
+/**
+ * @brief skip the rest of a node that contains the current item, the next call to kowhai_iter_next moves past it
+ * @param iter, the iterator to skip items in
+ * @param depth, the depth in the path of the node to skip (0 the root ... iter->depth the current leaf node)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_iter_skip(struct kowhai_iter_t *iter, int depth);
+
+#endif
+
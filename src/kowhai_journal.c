@@ -0,0 +1,270 @@
+#include "kowhai_journal.h"
+#include "kowhai_image.h"
+
+#include <string.h>
+
+#define RECORD_SIZE ((int)sizeof(struct kowhai_journal_record_t))
+// the crc covers offset and size, not itself
+#define RECORD_CRC_SIZE ((int)(2 * sizeof(uint32_t)))
+
+int kowhai_journal_init(struct kowhai_journal_t *journal, struct kowhai_tree_t *tree, struct kowhai_dirty_t *dirty, uint8_t *buffer, int buffer_size, uint32_t window,
+    kowhai_journal_append_t append, kowhai_journal_sync_t sync, kowhai_journal_truncate_t truncate, void* param)
+{
+    int status;
+
+    if (append == NULL || sync == NULL || buffer_size < 0)
+        return KOW_STATUS_BUFFER_INVALID;
+    if (dirty == NULL)
+        dirty = tree->dirty;
+    else if (dirty != tree->dirty)
+    {
+        if (tree->dirty == NULL)
+            return KOW_STATUS_BUFFER_INVALID;
+        status = kowhai_dirty_chain(tree->dirty, dirty);
+        if (status != KOW_STATUS_OK)
+            return status;
+    }
+    memset(journal, 0, sizeof(*journal));
+    status = kowhai_get_node_size(tree->desc, &journal->data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    journal->tree = tree;
+    journal->dirty = dirty;
+    journal->buffer = buffer;
+    journal->buffer_size = buffer_size;
+    journal->window = window;
+    journal->append = append;
+    journal->sync = sync;
+    journal->truncate = truncate;
+    journal->param = param;
+    return KOW_STATUS_OK;
+}
+
+// append the buffered records to the log
+static int flush(struct kowhai_journal_t *journal)
+{
+    int status;
+    if (journal->buffer_used == 0)
+        return KOW_STATUS_OK;
+    status = journal->append(journal->param, journal->buffer, journal->buffer_used);
+    if (status != KOW_STATUS_OK)
+        return status;
+    journal->log_size += journal->buffer_used;
+    journal->buffer_used = 0;
+    return KOW_STATUS_OK;
+}
+
+// buffer bytes for the log, anything that does not fit in the buffer goes straight to the log (keeping the order)
+static int put(struct kowhai_journal_t *journal, const void* data, int size)
+{
+    int status;
+    if (journal->buffer_used + size > journal->buffer_size)
+    {
+        status = flush(journal);
+        if (status != KOW_STATUS_OK)
+            return status;
+        if (size > journal->buffer_size)
+        {
+            status = journal->append(journal->param, data, size);
+            if (status == KOW_STATUS_OK)
+                journal->log_size += size;
+            return status;
+        }
+    }
+    memcpy(&journal->buffer[journal->buffer_used], data, size);
+    journal->buffer_used += size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_journal_record(struct kowhai_journal_t *journal, int offset, int size)
+{
+    struct kowhai_journal_record_t record;
+    const uint8_t *data = (const uint8_t*)journal->tree->data + offset;
+    int header_end, status;
+
+    if (journal->torn)
+        return KOW_STATUS_INVALID_SEQUENCE;
+    if (offset < 0 || size <= 0 || size > journal->data_size - offset)
+        return KOW_STATUS_INVALID_OFFSET;
+
+    record.offset = (uint32_t)offset;
+    record.size = (uint32_t)size;
+    record.crc = kowhai_crc32(kowhai_crc32(0, &record, RECORD_CRC_SIZE), data, size);
+    status = put(journal, &record, RECORD_SIZE);
+    if (status != KOW_STATUS_OK)
+        return status;
+    header_end = journal->buffer_used;
+    status = put(journal, data, size);
+    if (status != KOW_STATUS_OK)
+    {
+        // drop the header if it is still buffered, otherwise it is in the log without its data and replay would stop
+        // there, so latch until the log is compacted rather than log groups that can never be replayed
+        if (header_end != 0 && journal->buffer_used == header_end)
+            journal->buffer_used -= RECORD_SIZE;
+        else
+            journal->torn = 1;
+        return status;
+    }
+    journal->group_records++;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_journal_record_dirty(struct kowhai_journal_t *journal)
+{
+    struct kowhai_dirty_t *dirty = journal->dirty;
+    int offset, size, status;
+    int start = 0;
+
+    if (dirty == NULL)
+        return KOW_STATUS_OK;
+    while (kowhai_dirty_next(dirty, start, &offset, &size) == KOW_STATUS_OK)
+    {
+        // clear before copying the data so a write made meanwhile is marked again
+        kowhai_dirty_clear(dirty, offset, size);
+        status = kowhai_journal_record(journal, offset, size);
+        if (status != KOW_STATUS_OK)
+        {
+            // put the range back so it is recorded by the retry (bitmaps chained after this one see it again too)
+            kowhai_dirty_mark(dirty, offset, size);
+            return status;
+        }
+        start = offset + size;
+    }
+    return KOW_STATUS_OK;
+}
+
+int kowhai_journal_commit(struct kowhai_journal_t *journal)
+{
+    struct kowhai_journal_record_t record;
+    int status;
+
+    if (journal->torn)
+        return KOW_STATUS_INVALID_SEQUENCE;
+    status = kowhai_journal_record_dirty(journal);
+    if (status != KOW_STATUS_OK)
+        return status;
+    journal->pending = 0;
+
+    // once the commit record is buffered the group is closed, if appending or syncing fails a retry
+    // only appends and syncs again (another commit record would count the records of both groups)
+    if (journal->group_records != 0)
+    {
+        record.offset = KOWHAI_JOURNAL_COMMIT;
+        record.size = journal->group_records;
+        record.crc = kowhai_crc32(0, &record, RECORD_CRC_SIZE);
+        status = put(journal, &record, RECORD_SIZE);
+        if (status != KOW_STATUS_OK)
+            return status;
+        journal->group_records = 0;
+        journal->unsynced = 1;
+    }
+    if (!journal->unsynced)
+        return KOW_STATUS_OK;
+    status = flush(journal);
+    if (status != KOW_STATUS_OK)
+        return status;
+    // one sync for the whole group
+    status = journal->sync(journal->param);
+    if (status != KOW_STATUS_OK)
+        return status;
+    journal->unsynced = 0;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_journal_poll(struct kowhai_journal_t *journal, uint32_t now)
+{
+    int offset, size;
+
+    if (!journal->pending)
+    {
+        if (journal->group_records == 0 && !journal->unsynced &&
+            (journal->dirty == NULL || kowhai_dirty_next(journal->dirty, 0, &offset, &size) != KOW_STATUS_OK))
+            return KOW_STATUS_OK;
+        journal->pending = 1;
+        journal->pending_since = now;
+    }
+    if ((uint32_t)(now - journal->pending_since) < journal->window)
+        return KOW_STATUS_OK;
+    return kowhai_journal_commit(journal);
+}
+
+int kowhai_journal_truncate(struct kowhai_journal_t *journal)
+{
+    int status;
+
+    if (!journal->torn && (journal->group_records != 0 || journal->unsynced))
+        return KOW_STATUS_INVALID_SEQUENCE;
+    if (journal->truncate != NULL)
+    {
+        status = journal->truncate(journal->param);
+        if (status != KOW_STATUS_OK)
+            return status;
+    }
+    journal->log_size = 0;
+    if (journal->torn)
+    {
+        journal->buffer_used = 0;
+        journal->group_records = 0;
+        journal->pending = 0;
+        journal->unsynced = 0;
+        journal->torn = 0;
+    }
+    return KOW_STATUS_OK;
+}
+
+// check the records from start up to a commit record, returns the size of the group or 0 if it is incomplete or corrupt
+static int check_group(const uint8_t *log, int start, int log_size, int data_size)
+{
+    struct kowhai_journal_record_t record;
+    uint32_t records = 0;
+    int pos = start;
+
+    while (log_size - pos >= RECORD_SIZE)
+    {
+        memcpy(&record, &log[pos], RECORD_SIZE);
+        pos += RECORD_SIZE;
+        if (record.offset == KOWHAI_JOURNAL_COMMIT)
+        {
+            if (record.crc != kowhai_crc32(0, &record, RECORD_CRC_SIZE) || record.size != records)
+                return 0;
+            return pos - start;
+        }
+        if (record.size == 0 || record.size > (uint32_t)(log_size - pos) ||
+            record.offset > (uint32_t)data_size || record.size > (uint32_t)data_size - record.offset)
+            return 0;
+        if (record.crc != kowhai_crc32(kowhai_crc32(0, &record, RECORD_CRC_SIZE), &log[pos], record.size))
+            return 0;
+        pos += record.size;
+        records++;
+    }
+    return 0;
+}
+
+int kowhai_journal_replay(struct kowhai_tree_t *tree, const void* log, int log_size, int *valid_size)
+{
+    const uint8_t *p = (const uint8_t*)log;
+    struct kowhai_journal_record_t record;
+    int data_size, group_size, status;
+    int pos = 0;
+
+    status = kowhai_get_node_size(tree->desc, &data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    // apply each group only once all of it has been checked
+    while ((group_size = check_group(p, pos, log_size, data_size)) > 0)
+    {
+        int end = pos + group_size;
+        while (pos < end)
+        {
+            memcpy(&record, &p[pos], RECORD_SIZE);
+            pos += RECORD_SIZE;
+            if (record.offset == KOWHAI_JOURNAL_COMMIT)
+                break;
+            memcpy((uint8_t*)tree->data + record.offset, &p[pos], record.size);
+            pos += record.size;
+        }
+    }
+    *valid_size = pos;
+    return KOW_STATUS_OK;
+}
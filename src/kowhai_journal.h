@@ -0,0 +1,144 @@
+#ifndef _KOWHAI_JOURNAL_H_
+#define _KOWHAI_JOURNAL_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief the offset of a commit record, its size is the number of data records in the group it ends
+ */
+#define KOWHAI_JOURNAL_COMMIT 0xFFFFFFFF
+
+/**
+ * @brief the header of a journal record, data records are followed by size bytes of tree data
+ * Records are in native byte order with no padding between them
+ */
+struct kowhai_journal_record_t
+{
+    uint32_t offset;            ///< number of bytes from the start of the tree data to the data in this record (or KOWHAI_JOURNAL_COMMIT)
+    uint32_t size;              ///< number of bytes of data in this record (or the number of records in the group for a commit)
+    uint32_t crc;               ///< crc32 of offset, size and the data
+};
+
+/**
+ * @brief append bytes to the end of the log (eg write to the log file)
+ * @param param, application specific parameter given to kowhai_journal_init
+ * @param buffer, the bytes to append
+ * @param size, number of bytes to append
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+typedef int (*kowhai_journal_append_t)(void* param, const void* buffer, int size);
+
+/**
+ * @brief make everything appended to the log durable (eg fsync the log file)
+ * @param param, application specific parameter given to kowhai_journal_init
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+typedef int (*kowhai_journal_sync_t)(void* param);
+
+/**
+ * @brief empty the log (eg truncate the log file), this is only done once a compacted image of the tree is durable
+ * @param param, application specific parameter given to kowhai_journal_init
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+typedef int (*kowhai_journal_truncate_t)(void* param);
+
+/**
+ * @brief an append only log of changes to tree data, replayed over the last saved image of the tree at startup
+ * Changes are recorded as (offset, bytes) records and committed in groups, a group that was not completely
+ * written (eg power was lost) is ignored by kowhai_journal_replay so each group is applied all or nothing
+ */
+struct kowhai_journal_t
+{
+    struct kowhai_tree_t *tree;         ///< the tree being journaled
+    struct kowhai_dirty_t *dirty;       ///< the dirty bitmap the journal clears as it records (tree->dirty or one chained to it, or NULL)
+    int data_size;                      ///< size of the tree data in bytes
+    uint8_t *buffer;                    ///< records waiting to be appended (supplied by the caller)
+    int buffer_size;                    ///< number of bytes in buffer
+    int buffer_used;                    ///< number of bytes of buffer used
+    uint32_t group_records;             ///< number of records in the current (uncommitted) group
+    uint32_t log_size;                  ///< number of bytes appended to the log since it was last truncated
+    uint32_t window;                    ///< time to group changes for before committing them
+    uint32_t pending_since;             ///< time the current group was started
+    int pending;                        ///< non zero if the current group has records
+    int unsynced;                       ///< non zero if a committed group has not been appended and synced yet (eg the sync failed)
+    int torn;                           ///< non zero if part of a record reached the log, nothing more is logged until it is truncated
+    kowhai_journal_append_t append;     ///< appends to the log
+    kowhai_journal_sync_t sync;         ///< makes the log durable
+    kowhai_journal_truncate_t truncate; ///< empties the log
+    void* param;                        ///< parameter passed to the callbacks
+};
+
+/**
+ * @brief initialise a journal
+ * @param journal, the journal to initialise
+ * @param tree, the tree to journal
+ * @param dirty, the dirty bitmap kowhai_journal_record_dirty clears as it records, if it is not tree->dirty it is chained to
+ * tree->dirty (see kowhai_dirty_chain) so other consumers (eg subscriptions) can clear their own bitmap, NULL to use tree->dirty
+ * @param buffer, storage for records waiting to be appended (records larger than this are appended directly)
+ * @param buffer_size, number of bytes in buffer
+ * @param window, changes are grouped for this long before being committed (in the units of the time passed to kowhai_journal_poll)
+ * @param append, appends to the log
+ * @param sync, makes the log durable
+ * @param truncate, empties the log
+ * @param param, parameter passed to the callbacks
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_init(struct kowhai_journal_t *journal, struct kowhai_tree_t *tree, struct kowhai_dirty_t *dirty, uint8_t *buffer, int buffer_size, uint32_t window,
+    kowhai_journal_append_t append, kowhai_journal_sync_t sync, kowhai_journal_truncate_t truncate, void* param);
+
+/**
+ * @brief record the current value of a range of tree data in the current group (eg from a kowhai_on_change_t subscription callback)
+ * A record is all or nothing, if it fails before any of it reaches the log it is dropped from the buffer, if it fails after part
+ * of it was appended the journal refuses to log anything more (KOW_STATUS_INVALID_SEQUENCE) until it is compacted and truncated
+ * @param journal, the journal
+ * @param offset, number of bytes from the start of the tree data to the changed data
+ * @param size, number of bytes changed
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_record(struct kowhai_journal_t *journal, int offset, int size);
+
+/**
+ * @brief record all the dirty ranges of the tree and clear them in the dirty bitmap of the journal
+ * Each range is cleared before it is recorded so writes made meanwhile are recorded next time
+ * @param journal, the journal
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_record_dirty(struct kowhai_journal_t *journal);
+
+/**
+ * @brief end the current group, append it to the log and sync the log (does nothing if the group is empty)
+ * If appending or syncing fails calling this again retries without starting another group
+ * @param journal, the journal
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_commit(struct kowhai_journal_t *journal);
+
+/**
+ * @brief record the dirty ranges of the tree and commit them once they have been grouped for the window time
+ * @param journal, the journal
+ * @param now, the current time (any monotonic unit that wraps at 32 bits)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_poll(struct kowhai_journal_t *journal, uint32_t now);
+
+/**
+ * @brief empty the log once a compacted image of the tree is durable (see kowhai_image_create)
+ * The current group must be committed before the image is made so the image includes everything in the log, unless a
+ * record was torn (see kowhai_journal_record) in which case the current group is dropped (the image has its changes)
+ * @param journal, the journal
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error (KOW_STATUS_INVALID_SEQUENCE if the current group is not committed and synced)
+ */
+int kowhai_journal_truncate(struct kowhai_journal_t *journal);
+
+/**
+ * @brief apply the committed groups in a log to a tree (eg at startup after loading the last saved image)
+ * The tree data is written directly, nothing is marked dirty. Replay stops at the first incomplete or corrupt group.
+ * @param tree, the tree to apply the log to
+ * @param log, the contents of the log
+ * @param log_size, number of bytes in log
+ * @param valid_size, set to the number of bytes of log that were applied (the log should be truncated to this if it is less than log_size)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_replay(struct kowhai_tree_t *tree, const void* log, int log_size, int *valid_size);
+
+#endif
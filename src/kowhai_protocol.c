@@ -4,6 +4,81 @@
 
 #define SYM_COUNT_SIZE 1
 
+// bytes used on the wire by an offset or size field (32 bit commands use 32 bit fields)
+#define FIELD_SIZE(wide) ((wide) ? sizeof(uint32_t) : sizeof(uint16_t))
+// bytes used on the wire by each payload spec with 16 or 32 bit fields
+#define MEMORY_SPEC_SIZE(wide) (sizeof(uint16_t) + 2 * FIELD_SIZE(wide))
+#define DESCRIPTOR_SPEC_SIZE(wide) (3 * FIELD_SIZE(wide))
+#define FUNCTION_CALL_SIZE(wide) (2 * FIELD_SIZE(wide))
+
+// 16 bit commands and their 32 bit offset and size versions
+static const uint8_t command32_list[][2] =
+{
+    {KOW_CMD_WRITE_DATA, KOW_CMD_WRITE_DATA32},
+    {KOW_CMD_WRITE_DATA_END, KOW_CMD_WRITE_DATA32_END},
+    {KOW_CMD_WRITE_DATA_ACK, KOW_CMD_WRITE_DATA32_ACK},
+    {KOW_CMD_READ_DATA, KOW_CMD_READ_DATA32},
+    {KOW_CMD_READ_DATA_ACK, KOW_CMD_READ_DATA32_ACK},
+    {KOW_CMD_READ_DATA_ACK_END, KOW_CMD_READ_DATA32_ACK_END},
+    {KOW_CMD_READ_DESCRIPTOR, KOW_CMD_READ_DESCRIPTOR32},
+    {KOW_CMD_READ_DESCRIPTOR_ACK, KOW_CMD_READ_DESCRIPTOR32_ACK},
+    {KOW_CMD_READ_DESCRIPTOR_ACK_END, KOW_CMD_READ_DESCRIPTOR32_ACK_END},
+    {KOW_CMD_CALL_FUNCTION, KOW_CMD_CALL_FUNCTION32},
+    {KOW_CMD_CALL_FUNCTION_ACK, KOW_CMD_CALL_FUNCTION32_ACK},
+    {KOW_CMD_CALL_FUNCTION_RESULT, KOW_CMD_CALL_FUNCTION32_RESULT},
+    {KOW_CMD_CALL_FUNCTION_RESULT_END, KOW_CMD_CALL_FUNCTION32_RESULT_END},
+};
+
+uint8_t kowhai_protocol_get_command32(uint8_t command)
+{
+    int i;
+    for (i = 0; i < (int)(sizeof(command32_list) / sizeof(command32_list[0])); i++)
+        if (command32_list[i][0] == command)
+            return command32_list[i][1];
+    return command;
+}
+
+uint8_t kowhai_protocol_get_command16(uint8_t command)
+{
+    int i;
+    for (i = 0; i < (int)(sizeof(command32_list) / sizeof(command32_list[0])); i++)
+        if (command32_list[i][1] == command)
+            return command32_list[i][0];
+    return command;
+}
+
+// read an offset or size field off the wire
+static uint32_t get_field(const char* pkt, int wide)
+{
+    if (wide)
+    {
+        uint32_t value;
+        memcpy(&value, pkt, sizeof(value));
+        return value;
+    }
+    else
+    {
+        uint16_t value;
+        memcpy(&value, pkt, sizeof(value));
+        return value;
+    }
+}
+
+// write an offset or size field to the wire, 16 bit fields cannot hold values over 0xFFFF
+static int put_field(char* pkt, uint32_t value, int wide)
+{
+    if (wide)
+        memcpy(pkt, &value, sizeof(value));
+    else
+    {
+        uint16_t value16 = (uint16_t)value;
+        if (value > 0xFFFF)
+            return KOW_STATUS_OUT_OF_RANGE;
+        memcpy(pkt, &value16, sizeof(value16));
+    }
+    return KOW_STATUS_OK;
+}
+
 static int parse_version(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
 {
     // check packet is large enough for version integer
@@ -54,30 +129,32 @@ static int parse_symbols(void* payload_packet, int packet_size, struct kowhai_pr
  * @param payload parse the payload_packet into the data and buffer sections of this structure
  * @return KOW_STATUS_OK on success otherwise a KOW_STATUS error code
  */
-static int parse_data_payload(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+static int parse_data_payload(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload, int wide)
 {
     // parse symbols
     int required_size;
+    const char* spec;
     int status = parse_symbols(payload_packet, packet_size, payload, &required_size);
     if (status != KOW_STATUS_OK)
         return status;
+    spec = (char*)payload_packet + required_size;
 
     // check packet is large enough for the rest of the payload spec
-    required_size += sizeof(struct kowhai_protocol_data_payload_memory_spec_t);
+    required_size += MEMORY_SPEC_SIZE(wide);
     if (packet_size < required_size)
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
 
     // copy the rest of the payload spec
-    memcpy(&payload->spec.data.memory,
-        (uint8_t*)payload_packet + sizeof(payload->spec.data.symbols.count) + sizeof(union kowhai_symbol_t) * payload->spec.data.symbols.count,
-        sizeof(struct kowhai_protocol_data_payload_memory_spec_t));
+    memcpy(&payload->spec.data.memory.type, spec, sizeof(uint16_t));
+    payload->spec.data.memory.offset = get_field(spec + sizeof(uint16_t), wide);
+    payload->spec.data.memory.size = get_field(spec + sizeof(uint16_t) + FIELD_SIZE(wide), wide);
 
     // check the packet is large enough to hold the payload buffer
-    if (payload->spec.data.memory.size > packet_size - required_size)
+    if (payload->spec.data.memory.size > (uint32_t)(packet_size - required_size))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
 
     // set payload buffer pointer
-    payload->buffer = (void*)((char*)payload_packet + sizeof(payload->spec.data.symbols.count) + sizeof(union kowhai_symbol_t) * payload->spec.data.symbols.count + sizeof(struct kowhai_protocol_data_payload_memory_spec_t));
+    payload->buffer = (void*)((char*)payload_packet + required_size);
 
     return KOW_STATUS_OK;
 }
@@ -89,14 +166,17 @@ static int parse_data_payload(void* payload_packet, int packet_size, struct kowh
  * @param payload parse the payload_packet into the descriptor sections of this structure
  * @return KOW_STATUS_OK on success otherwise a KOW_STATUS error code
  */
-static int parse_descriptor_payload(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+static int parse_descriptor_payload(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload, int wide)
 {
-    if (packet_size < sizeof(struct kowhai_protocol_descriptor_payload_spec_t))
+    const char* spec = (char*)payload_packet;
+    if (packet_size < (int)DESCRIPTOR_SPEC_SIZE(wide))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    memcpy(&payload->spec, payload_packet, sizeof(struct kowhai_protocol_descriptor_payload_spec_t));
-    if (payload->spec.descriptor.size > packet_size - sizeof(struct kowhai_protocol_descriptor_payload_spec_t))
+    payload->spec.descriptor.node_count = get_field(spec, wide);
+    payload->spec.descriptor.offset = get_field(spec + FIELD_SIZE(wide), wide);
+    payload->spec.descriptor.size = get_field(spec + 2 * FIELD_SIZE(wide), wide);
+    if (payload->spec.descriptor.size > packet_size - DESCRIPTOR_SPEC_SIZE(wide))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    payload->buffer = (void*)((char*)payload_packet + sizeof(struct kowhai_protocol_descriptor_payload_spec_t));
+    payload->buffer = (void*)(spec + DESCRIPTOR_SPEC_SIZE(wide));
     return KOW_STATUS_OK;
 }
 
@@ -130,14 +210,16 @@ static int parse_function_details(void* payload_packet, int packet_size, struct
     return KOW_STATUS_OK;
 }
 
-static int parse_function_call(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+static int parse_function_call(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload, int wide)
 {
-    if (packet_size < sizeof(struct kowhai_protocol_function_call_t))
+    const char* spec = (char*)payload_packet;
+    if (packet_size < (int)FUNCTION_CALL_SIZE(wide))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    memcpy(&payload->spec, payload_packet, sizeof(struct kowhai_protocol_function_call_t));
-    if (payload->spec.function_call.size > packet_size - sizeof(struct kowhai_protocol_function_call_t))
+    payload->spec.function_call.offset = get_field(spec, wide);
+    payload->spec.function_call.size = get_field(spec + FIELD_SIZE(wide), wide);
+    if (payload->spec.function_call.size > packet_size - FUNCTION_CALL_SIZE(wide))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    payload->buffer = (void*)((char*)payload_packet + sizeof(struct kowhai_protocol_function_call_t));
+    payload->buffer = (void*)(spec + FUNCTION_CALL_SIZE(wide));
     return KOW_STATUS_OK;
 }
 
@@ -155,6 +237,7 @@ static int parse_event(void* payload_packet, int packet_size, struct kowhai_prot
 int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_protocol_t* protocol)
 {
     int required_size = sizeof(struct kowhai_protocol_header_t);
+    int wide;
     memset(protocol, 0, sizeof(struct kowhai_protocol_t));
 
     // check packet is large enough for header
@@ -162,7 +245,9 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
     memcpy(&protocol->header, proto_packet, required_size);
 
-    switch (protocol->header.command)
+    // 32 bit commands are parsed like their 16 bit versions but with wider fields
+    wide = kowhai_protocol_get_command16(protocol->header.command) != protocol->header.command;
+    switch (kowhai_protocol_get_command16(protocol->header.command))
     {
         case KOW_CMD_GET_VERSION:
             return KOW_STATUS_OK;
@@ -182,13 +267,13 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
         case KOW_CMD_WRITE_DATA_ACK:
         case KOW_CMD_READ_DATA_ACK:
         case KOW_CMD_READ_DATA_ACK_END:
-            return parse_data_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+            return parse_data_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload, wide);
         case KOW_CMD_READ_DESCRIPTOR:
             // read descriptor command requires no more parameters
             return KOW_STATUS_OK;
         case KOW_CMD_READ_DESCRIPTOR_ACK:
         case KOW_CMD_READ_DESCRIPTOR_ACK_END:
-            return parse_descriptor_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+            return parse_descriptor_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload, wide);
         case KOW_CMD_GET_FUNCTION_LIST:
         case KOW_CMD_GET_FUNCTION_DETAILS:
             // get function list/details command requires no more parameters
@@ -199,7 +284,7 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
         case KOW_CMD_CALL_FUNCTION_ACK:
         case KOW_CMD_CALL_FUNCTION_RESULT:
         case KOW_CMD_CALL_FUNCTION_RESULT_END:
-            return parse_function_call((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+            return parse_function_call((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload, wide);
         case KOW_CMD_CALL_FUNCTION_FAILED:
             return KOW_STATUS_OK;
         case KOW_CMD_EVENT:
@@ -229,6 +314,8 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
 int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_protocol_t* protocol, int* bytes_required)
 {
     char* pkt = (char*)proto_packet;
+    int wide = kowhai_protocol_get_command16(protocol->header.command) != protocol->header.command;
+    int status;
 
     // write protocol header
     *bytes_required = sizeof(struct kowhai_protocol_header_t);
@@ -237,8 +324,8 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
     memcpy(pkt, &protocol->header, sizeof(struct kowhai_protocol_header_t));
     pkt += sizeof(struct kowhai_protocol_header_t);
 
-    // check protocol command
-    switch (protocol->header.command)
+    // check protocol command (32 bit commands are created like their 16 bit versions but with wider fields)
+    switch (kowhai_protocol_get_command16(protocol->header.command))
     {
         case KOW_CMD_GET_VERSION:
             break;
@@ -287,14 +374,22 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
             memcpy(pkt, protocol->payload.spec.data.symbols.array_, protocol->payload.spec.data.symbols.count * sizeof(union kowhai_symbol_t));
             pkt += protocol->payload.spec.data.symbols.count * sizeof(union kowhai_symbol_t);
             // read data command requires no more parameters
-            if (protocol->header.command == KOW_CMD_READ_DATA)
+            if (kowhai_protocol_get_command16(protocol->header.command) == KOW_CMD_READ_DATA)
                 return KOW_STATUS_OK;
             // write payload spec
-            *bytes_required += sizeof(struct kowhai_protocol_data_payload_memory_spec_t);
+            *bytes_required += MEMORY_SPEC_SIZE(wide);
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-            memcpy(pkt, &protocol->payload.spec.data.memory, sizeof(struct kowhai_protocol_data_payload_memory_spec_t));
-            pkt += sizeof(struct kowhai_protocol_data_payload_memory_spec_t);
+            memcpy(pkt, &protocol->payload.spec.data.memory.type, sizeof(uint16_t));
+            pkt += sizeof(uint16_t);
+            status = put_field(pkt, protocol->payload.spec.data.memory.offset, wide);
+            if (status != KOW_STATUS_OK)
+                return status;
+            pkt += FIELD_SIZE(wide);
+            status = put_field(pkt, protocol->payload.spec.data.memory.size, wide);
+            if (status != KOW_STATUS_OK)
+                return status;
+            pkt += FIELD_SIZE(wide);
             // write payload
             *bytes_required += protocol->payload.spec.data.memory.size;
             if (packet_size < *bytes_required)
@@ -307,11 +402,14 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
         case KOW_CMD_READ_DESCRIPTOR_ACK:
         case KOW_CMD_READ_DESCRIPTOR_ACK_END:
             // write payload spec
-            *bytes_required += sizeof(struct kowhai_protocol_descriptor_payload_spec_t);
+            *bytes_required += DESCRIPTOR_SPEC_SIZE(wide);
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-            memcpy(pkt, &protocol->payload.spec.descriptor, sizeof(struct kowhai_protocol_descriptor_payload_spec_t));
-            pkt += sizeof(struct kowhai_protocol_descriptor_payload_spec_t);
+            if ((status = put_field(pkt, protocol->payload.spec.descriptor.node_count, wide)) != KOW_STATUS_OK ||
+                (status = put_field(pkt + FIELD_SIZE(wide), protocol->payload.spec.descriptor.offset, wide)) != KOW_STATUS_OK ||
+                (status = put_field(pkt + 2 * FIELD_SIZE(wide), protocol->payload.spec.descriptor.size, wide)) != KOW_STATUS_OK)
+                return status;
+            pkt += DESCRIPTOR_SPEC_SIZE(wide);
             // write payload
             *bytes_required += protocol->payload.spec.descriptor.size;
             if (packet_size < *bytes_required)
@@ -334,11 +432,13 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
         case KOW_CMD_CALL_FUNCTION_RESULT:
         case KOW_CMD_CALL_FUNCTION_RESULT_END:
             // write payload spec
-            *bytes_required += sizeof(struct kowhai_protocol_function_call_t);
+            *bytes_required += FUNCTION_CALL_SIZE(wide);
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-            memcpy(pkt, &protocol->payload.spec.function_call, sizeof(struct kowhai_protocol_function_call_t));
-            pkt += sizeof(struct kowhai_protocol_function_call_t);
+            if ((status = put_field(pkt, protocol->payload.spec.function_call.offset, wide)) != KOW_STATUS_OK ||
+                (status = put_field(pkt + FIELD_SIZE(wide), protocol->payload.spec.function_call.size, wide)) != KOW_STATUS_OK)
+                return status;
+            pkt += FUNCTION_CALL_SIZE(wide);
             // write payload
             *bytes_required += protocol->payload.spec.function_call.size;
             if (packet_size < *bytes_required)
@@ -386,8 +486,10 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
 
 int kowhai_protocol_get_overhead(struct kowhai_protocol_t* protocol, int* overhead)
 {
+    int wide = kowhai_protocol_get_command16(protocol->header.command) != protocol->header.command;
+
     // check protocol command
-    switch (protocol->header.command)
+    switch (kowhai_protocol_get_command16(protocol->header.command))
     {
         case KOW_CMD_GET_TREE_LIST:
             *overhead = sizeof(struct kowhai_protocol_header_t);
@@ -401,16 +503,16 @@ int kowhai_protocol_get_overhead(struct kowhai_protocol_t* protocol, int* overhe
             return KOW_STATUS_OK;
         case KOW_CMD_READ_DESCRIPTOR_ACK:
         case KOW_CMD_READ_DESCRIPTOR_ACK_END:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_descriptor_payload_spec_t);
+            *overhead = sizeof(struct kowhai_protocol_header_t) + DESCRIPTOR_SPEC_SIZE(wide);
             return KOW_STATUS_OK;
         case KOW_CMD_WRITE_DATA:
         case KOW_CMD_WRITE_DATA_END:
         case KOW_CMD_WRITE_DATA_ACK:
         case KOW_CMD_READ_DATA_ACK:
         case KOW_CMD_READ_DATA_ACK_END:
-            *overhead = sizeof(struct kowhai_protocol_t) - sizeof(protocol->payload.spec.data.symbols.array_) +
-                sizeof(union kowhai_symbol_t) * protocol->payload.spec.data.symbols.count -
-                sizeof(protocol->payload.buffer);
+            *overhead = sizeof(struct kowhai_protocol_header_t) + SYM_COUNT_SIZE +
+                sizeof(union kowhai_symbol_t) * protocol->payload.spec.data.symbols.count +
+                MEMORY_SPEC_SIZE(wide);
             return KOW_STATUS_OK;
         case KOW_CMD_READ_DATA:
             *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(protocol->payload.spec.data.symbols.count) +
@@ -431,7 +533,7 @@ int kowhai_protocol_get_overhead(struct kowhai_protocol_t* protocol, int* overhe
         case KOW_CMD_CALL_FUNCTION_ACK:
         case KOW_CMD_CALL_FUNCTION_RESULT:
         case KOW_CMD_CALL_FUNCTION_RESULT_END:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_function_call_t);
+            *overhead = sizeof(struct kowhai_protocol_header_t) + FUNCTION_CALL_SIZE(wide);
             return KOW_STATUS_OK;
         case KOW_CMD_EVENT:
         case KOW_CMD_EVENT_END:
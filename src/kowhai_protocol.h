@@ -74,6 +74,36 @@
 // Acknowledge get symbol list command (this is the final packet)
 #define KOW_CMD_GET_SYMBOL_LIST_ACK_END      0x9E
 
+// Write tree data with 32 bit offset and size (for nodes over 64KB, otherwise the same as KOW_CMD_WRITE_DATA)
+#define KOW_CMD_WRITE_DATA32                 0xA0
+// Write tree data with 32 bit offset and size (this is the final write packet)
+#define KOW_CMD_WRITE_DATA32_END             0xA1
+// Acknowledge write tree data with 32 bit offset and size command
+#define KOW_CMD_WRITE_DATA32_ACK             0xAF
+
+// Read tree data with 32 bit offset and size (for nodes over 64KB, otherwise the same as KOW_CMD_READ_DATA)
+#define KOW_CMD_READ_DATA32                  0xB0
+// Acknowledge read tree data with 32 bit offset and size command (and return the data)
+#define KOW_CMD_READ_DATA32_ACK              0xBF
+// Acknowledge read tree data with 32 bit offset and size command (this is the final packet)
+#define KOW_CMD_READ_DATA32_ACK_END          0xBE
+
+// Read the tree descriptor with 32 bit offset and size (for descriptors over 64KB, otherwise the same as KOW_CMD_READ_DESCRIPTOR)
+#define KOW_CMD_READ_DESCRIPTOR32            0xC0
+// Acknowledge read tree descriptor with 32 bit offset and size command (and return tree contents)
+#define KOW_CMD_READ_DESCRIPTOR32_ACK        0xCF
+// Acknowledge read tree descriptor with 32 bit offset and size command (this is the final packet)
+#define KOW_CMD_READ_DESCRIPTOR32_ACK_END    0xCE
+
+// Call function with 32 bit offset and size (for trees over 64KB, otherwise the same as KOW_CMD_CALL_FUNCTION)
+#define KOW_CMD_CALL_FUNCTION32              0xD0
+// Acknowledge call function with 32 bit offset and size command
+#define KOW_CMD_CALL_FUNCTION32_ACK          0xDF
+// Call function with 32 bit offset and size result command
+#define KOW_CMD_CALL_FUNCTION32_RESULT       0xDE
+// Call function with 32 bit offset and size result command (this is the final packet)
+#define KOW_CMD_CALL_FUNCTION32_RESULT_END   0xDD
+
 // Error codes
 #define KOW_CMD_ERROR_INVALID_COMMAND        0xF0
 #define KOW_CMD_ERROR_INVALID_TREE_ID        0xF1
@@ -111,12 +141,13 @@ struct kowhai_protocol_symbol_spec_t
 
 /**
  * @brief 
+ * offset and size are sent as 16 bit values except by the 32 bit commands (eg KOW_CMD_WRITE_DATA32)
  */
 struct kowhai_protocol_data_payload_memory_spec_t
 {
     uint16_t type;
-    uint16_t offset;
-    uint16_t size;
+    uint32_t offset;
+    uint32_t size;
 };
 
 /**
@@ -130,12 +161,13 @@ struct kowhai_protocol_data_payload_spec_t
 
 /**
  * @brief 
+ * fields are sent as 16 bit values except by the 32 bit commands (eg KOW_CMD_READ_DESCRIPTOR32_ACK)
  */
 struct kowhai_protocol_descriptor_payload_spec_t
 {
-    uint16_t node_count;
-    uint16_t offset;
-    uint16_t size;
+    uint32_t node_count;
+    uint32_t offset;
+    uint32_t size;
 };
 
 /**
@@ -179,11 +211,12 @@ struct kowhai_protocol_function_details_t
 
 /**
  * @brief 
+ * offset and size are sent as 16 bit values except by the 32 bit commands (eg KOW_CMD_CALL_FUNCTION32)
  */
 struct kowhai_protocol_function_call_t
 {
-    uint16_t offset;
-    uint16_t size;
+    uint32_t offset;
+    uint32_t size;
 };
 
 /**
@@ -345,6 +378,20 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
  */
 int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_protocol_t* protocol, int* bytes_required);
 
+/**
+ * @brief Get the 32 bit offset and size version of a command (eg KOW_CMD_READ_DATA32 for KOW_CMD_READ_DATA)
+ * @param command the protocol command
+ * @return the 32 bit version of the command, or command if it has none (or is already a 32 bit command)
+ */
+uint8_t kowhai_protocol_get_command32(uint8_t command);
+
+/**
+ * @brief Get the 16 bit offset and size version of a command (eg KOW_CMD_READ_DATA for KOW_CMD_READ_DATA32)
+ * @param command the protocol command
+ * @return the 16 bit version of the command, or command if it is not a 32 bit command
+ */
+uint8_t kowhai_protocol_get_command16(uint8_t command);
+
 /**
  * @brief Returkn the protocol overhead (header, payload specification etc, ie the meta part of the protocol that describes the payload)
  * @param protocol parse this for the overhead
@@ -1,4 +1,5 @@
 #include "kowhai_protocol_server.h"
+#include "kowhai_snapshot.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -102,17 +103,42 @@ int _get_tree_index(struct kowhai_protocol_server_t* server , uint16_t id, int*
 
 struct kowhai_tree_t _populate_tree(struct kowhai_protocol_server_t* server, uint16_t tree_id)
 {
-    struct kowhai_tree_t tree = {NULL, NULL};
+    struct kowhai_tree_t tree = {NULL, NULL, NULL, NULL};
     int index;
     if (tree_id != KOW_UNDEFINED_SYMBOL &&
         _get_tree_index(server, tree_id, &index))
     {
         tree.desc = (struct kowhai_node_t *)server->tree_list[index].descriptor;
-        tree.data = server->tree_list[index].data;
+        tree.dirty = server->tree_list[index].dirty;
+        if (server->tree_list[index].rcu != NULL)
+            tree.data = kowhai_rcu_get_data(server->tree_list[index].rcu);
+        else
+        {
+            tree.data = server->tree_list[index].data;
+            tree.snapshot = server->tree_list[index].snapshot;
+        }
     }
     return tree;
 }
 
+struct kowhai_rcu_tree_t* _get_tree_rcu(struct kowhai_protocol_server_t* server, uint16_t tree_id)
+{
+    int index;
+    if (tree_id != KOW_UNDEFINED_SYMBOL &&
+        _get_tree_index(server, tree_id, &index))
+        return server->tree_list[index].rcu;
+    return NULL;
+}
+
+struct kowhai_seqlock_set_t* _get_tree_locks(struct kowhai_protocol_server_t* server, uint16_t tree_id)
+{
+    int index;
+    if (tree_id != KOW_UNDEFINED_SYMBOL &&
+        _get_tree_index(server, tree_id, &index))
+        return server->tree_list[index].locks;
+    return NULL;
+}
+
 int _check_tree_id(struct kowhai_protocol_server_t* server, uint16_t id)
 {
     int i;
@@ -253,6 +279,14 @@ void _send_string_list(struct kowhai_protocol_server_t* server, struct kowhai_pr
     server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, prot);
 }
 
+// 32 bit requests get the 32 bit version of their reply
+uint8_t _reply_command(uint8_t command, int wide)
+{
+    if (wide)
+        return kowhai_protocol_get_command32(command);
+    return command;
+}
+
 void _set_error_cmd(struct kowhai_protocol_t* prot, int status)
 {
     switch (status)
@@ -266,6 +300,7 @@ void _set_error_cmd(struct kowhai_protocol_t* prot, int status)
             prot->header.command = KOW_CMD_ERROR_INVALID_PAYLOAD_OFFSET;
             break;
         case KOW_STATUS_NODE_DATA_TOO_SMALL:
+        case KOW_STATUS_OUT_OF_RANGE:
             KOW_LOG("    invalid payload size\n");
             prot->header.command = KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE;
             break;
@@ -288,6 +323,7 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
 {
     struct kowhai_protocol_t prot;
     int bytes_required, status;
+    int wide;
 
     if (packet_size > server->max_packet_size)
     {
@@ -305,7 +341,9 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
         return status;
     }
 
-    switch (prot.header.command)
+    // 32 bit commands are handled like their 16 bit versions
+    wide = kowhai_protocol_get_command16(prot.header.command) != prot.header.command;
+    switch (kowhai_protocol_get_command16(prot.header.command))
     {
         case KOW_CMD_GET_VERSION:
             KOW_LOG("    CMD get version\n");
@@ -326,6 +364,7 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             struct kowhai_tree_t tree;
             int offset;
             struct kowhai_node_t* node_to_write;
+            struct kowhai_rcu_tree_t* rcu;
             KOW_LOG("    CMD write data\n");
             if (!_check_tree_id(server, prot.header.id))
             {
@@ -334,6 +373,7 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             }
             // init tree helper struct
             tree = _populate_tree(server, prot.header.id);
+            rcu = _get_tree_rcu(server, prot.header.id);
             // check/set current write node
             status = kowhai_get_node(tree.desc, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, &offset, &node_to_write);
             if (status == KOW_STATUS_OK)
@@ -350,6 +390,9 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                     server->current_write_node = node_to_write;
                     server->current_write_node_offset = offset;
                     server->current_write_node_bytes_written = 0;
+                    // drop anything left in the shadow copy by an unfinished write sequence
+                    if (rcu != NULL)
+                        kowhai_rcu_abort(rcu);
                     // call node_pre_write callback
                     if (server->node_pre_write)
                         server->node_pre_write(server, server->node_write_param, prot.header.id, server->current_write_node, server->current_write_node_offset);
@@ -358,8 +401,18 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             // write to tree
             if (status == KOW_STATUS_OK)
             {
+                struct kowhai_seqlock_set_t* locks = NULL;
+                // double buffered trees are written to the shadow copy which readers cannot see
+                if (rcu != NULL)
+                    kowhai_rcu_write_begin(rcu, &tree.data);
+                else
+                    locks = _get_tree_locks(server, prot.header.id);
+                if (locks != NULL)
+                    kowhai_seqlock_write_begin(locks, offset + prot.payload.spec.data.memory.offset, prot.payload.spec.data.memory.size);
                 //TODO: user kowhai_get_node result in kowhai_write(2?)
                 status = kowhai_write(&tree, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, prot.payload.spec.data.memory.offset, prot.payload.buffer, prot.payload.spec.data.memory.size);
+                if (locks != NULL)
+                    kowhai_seqlock_write_end(locks, offset + prot.payload.spec.data.memory.offset, prot.payload.spec.data.memory.size);
                 if (status == KOW_STATUS_OK)
                 {
                     // update current_write_node_bytes_written
@@ -367,15 +420,18 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                     if (bytes_written > server->current_write_node_bytes_written)
                         server->current_write_node_bytes_written = bytes_written;
                     // call node_post_write callback
-                    if (prot.header.command == KOW_CMD_WRITE_DATA_END)
+                    if (kowhai_protocol_get_command16(prot.header.command) == KOW_CMD_WRITE_DATA_END)
                     {
+                        // publish the whole write sequence at once
+                        if (rcu != NULL)
+                            kowhai_rcu_publish(rcu);
                         if (server->node_post_write)
                             server->node_post_write(server, server->node_write_param, prot.header.id, server->current_write_node, server->current_write_node_offset, server->current_write_node_bytes_written);
                         // clear current write node if at end of write sequence
                         server->current_write_node = NULL;
                     }
                     // send response
-                    prot.header.command = KOW_CMD_WRITE_DATA_ACK;
+                    prot.header.command = _reply_command(KOW_CMD_WRITE_DATA_ACK, wide);
                     kowhai_read(&tree, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, prot.payload.spec.data.memory.offset, prot.payload.buffer, prot.payload.spec.data.memory.size);
                     kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
                     server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
@@ -384,6 +440,8 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             }
             // clear current write node if error encountered
             server->current_write_node = NULL;
+            if (rcu != NULL)
+                kowhai_rcu_abort(rcu);
             // send error response
             _set_error_cmd(&prot, status);
             kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
@@ -414,11 +472,17 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             if (status == KOW_STATUS_OK)
             {
                 union kowhai_symbol_t last_sym = symbols.array_[symbols.count-1];
-                kowhai_get_node_size(node, &size);
-                if (node->count > 1)
+                status = kowhai_get_node_size(node, &size);
+                if (status == KOW_STATUS_OK && node->count > 1)
                     size = size - size / node->count * last_sym.parts.array_index;
+                // 16 bit commands cannot address data past 64KB
+                if (status == KOW_STATUS_OK && !wide && size > 0xFFFF)
+                    status = KOW_STATUS_OUT_OF_RANGE;
+            }
+            if (status == KOW_STATUS_OK)
+            {
                 // get protocol overhead
-                prot.header.command = KOW_CMD_READ_DATA_ACK;
+                prot.header.command = _reply_command(KOW_CMD_READ_DATA_ACK, wide);
                 kowhai_protocol_get_overhead(&prot, &overhead);
                 // setup max payload size and payload offset
                 max_payload_size = server->max_packet_size - overhead;
@@ -431,18 +495,18 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                 // send packets
                 while (size > max_payload_size)
                 {
-                    prot.payload.spec.data.memory.size = (uint16_t)max_payload_size;
+                    prot.payload.spec.data.memory.size = max_payload_size;
                     kowhai_read(&tree, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, prot.payload.spec.data.memory.offset, prot.payload.buffer, prot.payload.spec.data.memory.size);
                     kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
                     if (!server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot))
                         return KOW_STATUS_OK;
                     // increment payload offset and decrement remaining payload size
-                    prot.payload.spec.data.memory.offset += (uint16_t)max_payload_size;
+                    prot.payload.spec.data.memory.offset += max_payload_size;
                     size -= max_payload_size;
                 }
                 // send final packet
-                prot.header.command = KOW_CMD_READ_DATA_ACK_END;
-                prot.payload.spec.data.memory.size = (uint16_t)size;
+                prot.header.command = _reply_command(KOW_CMD_READ_DATA_ACK_END, wide);
+                prot.payload.spec.data.memory.size = size;
                 kowhai_read(&tree, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, prot.payload.spec.data.memory.offset, prot.payload.buffer, prot.payload.spec.data.memory.size);
                 kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
                 server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
@@ -470,8 +534,16 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             // get descriptor size
             _get_tree_index(server, prot.header.id, &index);
             size = server->tree_list[index].descriptor_size;
+            // 16 bit commands cannot address descriptors past 64KB
+            if (!wide && size > 0xFFFF)
+            {
+                _set_error_cmd(&prot, KOW_STATUS_OUT_OF_RANGE);
+                kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
+                server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+                break;
+            }
             // get protocol overhead
-            prot.header.command = KOW_CMD_READ_DESCRIPTOR_ACK;
+            prot.header.command = _reply_command(KOW_CMD_READ_DESCRIPTOR_ACK, wide);
             kowhai_protocol_get_overhead(&prot, &overhead);
             // setup max payload size and payload offset
             max_payload_size = server->max_packet_size - overhead;
@@ -480,18 +552,18 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             // send packets
             while (size > max_payload_size)
             {
-                prot.payload.spec.descriptor.size = (uint16_t)max_payload_size;
+                prot.payload.spec.descriptor.size = max_payload_size;
                 prot.payload.buffer = (char*)tree.desc + prot.payload.spec.descriptor.offset;
                 kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
                 if (!server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot))
                     return KOW_STATUS_OK;
                 // increment payload offset and decrement remaining payload size
-                prot.payload.spec.descriptor.offset += (uint16_t)max_payload_size;
+                prot.payload.spec.descriptor.offset += max_payload_size;
                 size -= max_payload_size;
             }
             // send final packet
-            prot.header.command = KOW_CMD_READ_DESCRIPTOR_ACK_END;
-            prot.payload.spec.descriptor.size = (uint16_t)size;
+            prot.header.command = _reply_command(KOW_CMD_READ_DESCRIPTOR_ACK_END, wide);
+            prot.payload.spec.descriptor.size = size;
             prot.payload.buffer = (char*)tree.desc + prot.payload.spec.descriptor.offset;
             kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
             server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
@@ -547,7 +619,7 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                         KOW_LOG("        KOW_CMD_ERROR_INVALID_PAYLOAD_OFFSET\n");
                         prot.header.command = KOW_CMD_ERROR_INVALID_PAYLOAD_OFFSET;
                     }
-                    else if (prot.payload.spec.function_call.offset + prot.payload.spec.function_call.size > tree_data_size)
+                    else if (prot.payload.spec.function_call.size > (uint32_t)tree_data_size - prot.payload.spec.function_call.offset)
                     {
                         KOW_LOG("        KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE\n");
                         prot.header.command = KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE;
@@ -556,49 +628,85 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                     {
                         int offset = prot.payload.spec.function_call.offset;
                         int size = prot.payload.spec.function_call.size;
+                        struct kowhai_rcu_tree_t* rcu = _get_tree_rcu(server, server->function_list[function_index].details.tree_in_id);
+                        struct kowhai_seqlock_set_t* locks = NULL;
                         KOW_LOG("        write data (offset: %d, size: %d, tree_data_size: %d)\n", offset, size, tree_data_size);
+                        // double buffered input trees are written to the shadow copy and published once all the input has arrived
+                        if (rcu != NULL)
+                        {
+                            // a call starting again drops anything left in the shadow copy by an unfinished call
+                            if (offset == 0)
+                                kowhai_rcu_abort(rcu);
+                            kowhai_rcu_write_begin(rcu, &tree.data);
+                        }
+                        else
+                            locks = _get_tree_locks(server, server->function_list[function_index].details.tree_in_id);
+                        if (locks != NULL)
+                            kowhai_seqlock_write_begin(locks, offset, size);
+                        if (tree.snapshot != NULL)
+                            kowhai_snapshot_preserve(tree.snapshot, offset, size);
                         memcpy((char*)tree.data + offset, prot.payload.buffer, size);
+                        if (tree.dirty != NULL)
+                            kowhai_dirty_mark(tree.dirty, offset, size);
+                        if (locks != NULL)
+                            kowhai_seqlock_write_end(locks, offset, size);
                         // setup response details
-                        prot.header.command = KOW_CMD_CALL_FUNCTION_ACK;
+                        prot.header.command = _reply_command(KOW_CMD_CALL_FUNCTION_ACK, wide);
                         prot.payload.spec.function_call.offset = 0;
                         prot.payload.spec.function_call.size = 0;
                         prot.payload.buffer = NULL;
                         // handle server->function_called when all data has been written
                         if (tree_data_size == 0 || offset + size == tree_data_size)
                         {
-                            struct kowhai_tree_t tree = _populate_tree(server, server->function_list[function_index].details.tree_out_id);
+                            struct kowhai_tree_t tree;
+                            if (rcu != NULL)
+                                kowhai_rcu_publish(rcu);
+                            tree = _populate_tree(server, server->function_list[function_index].details.tree_out_id);
                             KOW_LOG("        function_called callback\n");
                             if (server->function_called(server, server->function_called_param, prot.header.id))
                             {
                                 // respond with result tree or not
+                                int size = 0;
+                                int size_status = KOW_STATUS_OK;
                                 if (tree.desc != NULL)
+                                    size_status = kowhai_get_node_size(tree.desc, &size);
+                                if (size_status != KOW_STATUS_OK)
+                                {
+                                    KOW_LOG("        return tree size unknown\n");
+                                    _set_error_cmd(&prot, size_status);
+                                }
+                                // 16 bit commands cannot return trees past 64KB
+                                else if (!wide && size > 0xFFFF)
+                                {
+                                    KOW_LOG("        return tree too large\n");
+                                    prot.header.command = KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE;
+                                }
+                                else if (tree.desc != NULL)
                                 {
-                                    int size, overhead, max_payload_size;
+                                    int overhead, max_payload_size;
                                     KOW_LOG("        send return tree\n");
-                                    prot.header.command = KOW_CMD_CALL_FUNCTION_RESULT;
+                                    prot.header.command = _reply_command(KOW_CMD_CALL_FUNCTION_RESULT, wide);
                                     kowhai_protocol_get_overhead(&prot, &overhead);
-                                    // setup size
-                                    kowhai_get_node_size(tree.desc, &size);
                                     // setup max payload size and payload offset
                                     max_payload_size = server->max_packet_size - overhead;
                                     prot.payload.spec.function_call.offset = 0;
-                                    prot.payload.spec.function_call.size = (uint16_t)max_payload_size;
+                                    prot.payload.spec.function_call.size = max_payload_size;
                                     prot.payload.buffer = tree.data;
                                     // send packets
                                     while (size > max_payload_size)
                                     {
-                                        prot.payload.spec.function_call.size = (uint16_t)max_payload_size;
+                                        prot.payload.spec.function_call.size = max_payload_size;
                                         prot.payload.buffer = (char*)tree.data + prot.payload.spec.function_call.offset;
                                         kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
                                         if (!server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot))
                                             return KOW_STATUS_OK;
                                         // increment payload offset and decrement remaining payload size
-                                        prot.payload.spec.function_call.offset += (uint16_t)max_payload_size;
+                                        prot.payload.spec.function_call.offset += max_payload_size;
                                         size -= max_payload_size;
                                     }
                                     // send final packet
-                                    prot.header.command = KOW_CMD_CALL_FUNCTION_RESULT_END;
-                                    prot.payload.spec.function_call.size = (uint16_t)size;
+                                    prot.header.command = _reply_command(KOW_CMD_CALL_FUNCTION_RESULT_END, wide);
+                                    prot.payload.spec.function_call.size = size;
                                     prot.payload.buffer = (char*)tree.data + prot.payload.spec.function_call.offset;
                                     kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
                                     server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
@@ -607,7 +715,7 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                                 else
                                 {
                                     KOW_LOG("        send no return tree\n");
-                                    prot.header.command = KOW_CMD_CALL_FUNCTION_RESULT_END;
+                                    prot.header.command = _reply_command(KOW_CMD_CALL_FUNCTION_RESULT_END, wide);
                                 }
                             }
                             else
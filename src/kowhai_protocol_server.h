@@ -2,6 +2,8 @@
 #define _KOWHAI_PROTOCOL_SERVER_H_
 
 #include "kowhai_protocol.h" 
+#include "kowhai_seqlock.h"
+#include "kowhai_rcu.h"
 
 #include <stddef.h>
 
@@ -53,6 +55,10 @@ struct kowhai_protocol_server_tree_item_t
     const struct kowhai_node_t * descriptor;
     size_t descriptor_size;
     void* data;
+    struct kowhai_seqlock_set_t* locks;     ///< if not NULL writes from the protocol are made inside these sequence locks
+    struct kowhai_rcu_tree_t* rcu;          ///< if not NULL the tree data is double buffered, protocol writes go to a shadow copy that is published on KOW_CMD_WRITE_DATA_END or once all the input of a function call has arrived (data is then unused)
+    struct kowhai_dirty_t* dirty;           ///< if not NULL writes from the protocol are marked in this bitmap
+    struct kowhai_snapshot_t* snapshot;     ///< if not NULL pages are copied into this snapshot before protocol writes change them (not used with rcu)
 };
 
 struct kowhai_protocol_server_function_item_t
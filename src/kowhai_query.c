@@ -0,0 +1,217 @@
+#include "kowhai_query.h"
+#include "kowhai_snapshot.h"
+
+#include <string.h>
+
+// a node selected by one symbol of a query, each level is kept in a frame of compile_level and points to the
+// level of the symbol before it
+struct query_level_t
+{
+    const struct kowhai_node_t *node;
+    int offset;                 // bytes from the start of the parent array item to the first array item of this node
+    int element_size;           // bytes between array items of this node
+    int start, end;             // selected array items
+    int index;                  // array item being compiled
+    struct query_level_t *parent;
+};
+
+// find the first child of a branch with a symbol and its offset from the start of a branch array item
+static int find_child(const struct kowhai_node_t *branch, uint16_t symbol, const struct kowhai_node_t **child, int *offset)
+{
+    const struct kowhai_node_t *node = branch + 1;
+    int in_union = branch->type == KOW_BRANCH_U_START;
+
+    *offset = 0;
+    while (node->type != KOW_BRANCH_END)
+    {
+        int size, count, ret;
+        if (node->symbol == symbol)
+        {
+            *child = node;
+            return KOW_STATUS_OK;
+        }
+        ret = kowhai_get_node_size(node, &size);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        ret = kowhai_get_node_count(node, &count);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        if (!in_union)
+            *offset += size;
+        node += count;
+    }
+    return KOW_STATUS_INVALID_SYMBOL_PATH;
+}
+
+// step through every combination of the array items selected above the run level adding a run for each
+static int compile_runs(struct kowhai_query_t *query, struct query_level_t *leaf, struct kowhai_query_run_t *runs, int num_runs)
+{
+    struct query_level_t *run_level = leaf;
+    struct query_level_t *level;
+
+    if (leaf->node->type == KOW_BRANCH_START || leaf->node->type == KOW_BRANCH_U_START)
+        return KOW_STATUS_INVALID_NODE_TYPE;
+
+    // the deepest level with more than one item selected is stepped through in each run, all the levels
+    // above it are stepped through one run at a time
+    while (run_level->parent != NULL && run_level->end - run_level->start == 1)
+        run_level = run_level->parent;
+
+    for (level = leaf; level != NULL; level = level->parent)
+        level->index = level->start;
+    while (1)
+    {
+        int offset = 0;
+
+        for (level = leaf; level != NULL; level = level->parent)
+            offset += level->offset + level->index * level->element_size;
+        // keep counting once runs is full so the caller knows how many are needed
+        if (query->num_runs < num_runs)
+        {
+            struct kowhai_query_run_t *run = &runs[query->num_runs];
+            run->offset = offset;
+            run->stride = run_level->element_size;
+            run->count = run_level->end - run_level->start;
+            run->type = leaf->node->type;
+            query->num_runs++;
+        }
+        query->runs_needed++;
+        query->size += (run_level->end - run_level->start) * leaf->element_size;
+
+        // move on to the next combination of array items above the run level
+        for (level = run_level->parent; level != NULL; level = level->parent)
+        {
+            if (++level->index < level->end)
+                break;
+            level->index = level->start;
+        }
+        if (level == NULL)
+            break;
+    }
+
+    if (query->runs_needed > num_runs)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    return KOW_STATUS_OK;
+}
+
+// resolve the node, offset and selected array items for symbol i then the symbols after it, the levels are
+// kept on the C stack so query paths are not limited in length
+static int compile_level(struct kowhai_query_t *query, const struct kowhai_query_symbol_t *symbols, int i, int num_symbols, struct query_level_t *parent, struct kowhai_query_run_t *runs, int num_runs)
+{
+    struct query_level_t level;
+    const struct kowhai_node_t *node = query->desc;
+    int size, ret;
+
+    if (parent == NULL)
+    {
+        if (node->symbol != symbols[i].name)
+            return KOW_STATUS_INVALID_SYMBOL_PATH;
+        level.offset = 0;
+    }
+    else
+    {
+        if (parent->node->type != KOW_BRANCH_START && parent->node->type != KOW_BRANCH_U_START)
+            return KOW_STATUS_INVALID_SYMBOL_PATH;
+        ret = find_child(parent->node, symbols[i].name, &node, &level.offset);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+    }
+    level.node = node;
+    level.parent = parent;
+
+    ret = kowhai_get_node_size(node, &size);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    level.element_size = node->count > 0 ? size / node->count : 0;
+    level.start = symbols[i].start;
+    level.end = symbols[i].end == KOWHAI_QUERY_END ? node->count : symbols[i].end;
+    if (level.start >= level.end || level.end > node->count)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+
+    if (i + 1 < num_symbols)
+        return compile_level(query, symbols, i + 1, num_symbols, &level, runs, num_runs);
+    return compile_runs(query, &level, runs, num_runs);
+}
+
+int kowhai_query_compile(struct kowhai_query_t *query, const struct kowhai_node_t *desc, const struct kowhai_query_symbol_t *symbols, int num_symbols, struct kowhai_query_run_t *runs, int num_runs)
+{
+    int status;
+
+    query->desc = desc;
+    query->runs = runs;
+    query->num_runs = 0;
+    query->runs_needed = 0;
+    query->size = 0;
+
+    if (num_symbols < 1)
+        status = KOW_STATUS_INVALID_SYMBOL_PATH;
+    else if (desc->type != KOW_BRANCH_START)
+        status = KOW_STATUS_INVALID_DESCRIPTOR;
+    else
+        status = compile_level(query, symbols, 0, num_symbols, NULL, runs, num_runs);
+    // a query that did not compile is not usable (see query_copy)
+    if (status != KOW_STATUS_OK)
+        query->desc = NULL;
+    return status;
+}
+
+// copy all the items of a query between the tree data and a packed buffer
+static int query_copy(const struct kowhai_query_t *query, struct kowhai_tree_t *tree, char *buffer, int buffer_size, int write)
+{
+    int i, j;
+
+    if (query->desc == NULL)
+        return KOW_STATUS_INVALID_SEQUENCE;
+    if (tree->desc != query->desc)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    if (buffer_size < query->size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+
+    for (i = 0; i < query->num_runs; i++)
+    {
+        const struct kowhai_query_run_t *run = &query->runs[i];
+        int item_size = kowhai_get_node_type_size(run->type);
+        char *data = (char*)tree->data + run->offset;
+
+        if (write && run->count > 0)
+        {
+            if (tree->snapshot != NULL)
+                kowhai_snapshot_preserve(tree->snapshot, run->offset, run->stride * (run->count - 1) + item_size);
+            if (tree->dirty != NULL)
+                kowhai_dirty_mark(tree->dirty, run->offset, run->stride * (run->count - 1) + item_size);
+        }
+
+        // contiguous runs are a single copy
+        if (run->stride == item_size)
+        {
+            if (write)
+                memcpy(data, buffer, item_size * run->count);
+            else
+                memcpy(buffer, data, item_size * run->count);
+            buffer += item_size * run->count;
+            continue;
+        }
+        for (j = 0; j < run->count; j++)
+        {
+            if (write)
+                memcpy(data, buffer, item_size);
+            else
+                memcpy(buffer, data, item_size);
+            data += run->stride;
+            buffer += item_size;
+        }
+    }
+
+    return KOW_STATUS_OK;
+}
+
+int kowhai_query_read(const struct kowhai_query_t *query, struct kowhai_tree_t *tree, void *result, int result_size)
+{
+    return query_copy(query, tree, (char*)result, result_size, 0);
+}
+
+int kowhai_query_write(const struct kowhai_query_t *query, struct kowhai_tree_t *tree, const void *values, int values_size)
+{
+    return query_copy(query, tree, (char*)values, values_size, 1);
+}
+
@@ -0,0 +1,77 @@
+#ifndef _KOWHAI_QUERY_H_
+#define _KOWHAI_QUERY_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief end value of a query symbol that selects up to the last array item of a node
+ */
+#define KOWHAI_QUERY_END 0xFFFF
+
+/**
+ * @brief one symbol of a query path, selects a range of array items of the named node
+ */
+struct kowhai_query_symbol_t
+{
+    uint16_t name;              ///< the symbol of the node
+    uint16_t start;             ///< first array item selected
+    uint16_t end;               ///< one past the last array item selected (or KOWHAI_QUERY_END for all the remaining items)
+};
+
+/**
+ * @brief a run of leaf items selected by a query, the items are evenly spaced in the tree data
+ */
+struct kowhai_query_run_t
+{
+    int32_t offset;             ///< number of bytes from the start of the tree data to the first item
+    int32_t stride;             ///< number of bytes between the start of each item
+    int32_t count;              ///< number of items
+    uint16_t type;              ///< type of the items (see KOW_INT8 etc)
+};
+
+/**
+ * @brief a query path compiled against a descriptor into the runs of leaf items it selects
+ */
+struct kowhai_query_t
+{
+    const struct kowhai_node_t *desc;   ///< the descriptor the query was compiled against (NULL if compiling failed)
+    struct kowhai_query_run_t *runs;    ///< the runs in data order (supplied by the caller)
+    int num_runs;                       ///< number of runs populated
+    int runs_needed;                    ///< number of runs the query selects (more than num_runs if runs was too small)
+    int size;                           ///< total size of all the selected items in bytes
+};
+
+/**
+ * @brief compile a query path into runs of leaf items
+ * @param query, the query to initialise
+ * @param desc, the tree descriptor to compile against (this must remain valid for the life of the query)
+ * @param symbols, the query path, the last symbol must be a leaf node
+ * @param num_symbols, number of items in the query path
+ * @param runs, storage for the runs
+ * @param num_runs, number of items in runs, if this is too small the number needed is stored in query->runs_needed
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error (the query can not be read or written then)
+ */
+int kowhai_query_compile(struct kowhai_query_t *query, const struct kowhai_node_t *desc, const struct kowhai_query_symbol_t *symbols, int num_symbols, struct kowhai_query_run_t *runs, int num_runs);
+
+/**
+ * @brief read every item selected by a query, the items are packed one after the other in data order
+ * @param query, the compiled query
+ * @param tree, the tree to read from (this must use the descriptor the query was compiled against)
+ * @param result, buffer for the items
+ * @param result_size, size of the result buffer in bytes (must be at least query->size)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error (KOW_STATUS_INVALID_SEQUENCE if the query did not compile)
+ */
+int kowhai_query_read(const struct kowhai_query_t *query, struct kowhai_tree_t *tree, void *result, int result_size);
+
+/**
+ * @brief write every item selected by a query from a buffer of packed items (see kowhai_query_read)
+ * @param query, the compiled query
+ * @param tree, the tree to write to (this must use the descriptor the query was compiled against)
+ * @param values, the items to write
+ * @param values_size, size of the values buffer in bytes (must be at least query->size)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error (KOW_STATUS_INVALID_SEQUENCE if the query did not compile)
+ */
+int kowhai_query_write(const struct kowhai_query_t *query, struct kowhai_tree_t *tree, const void *values, int values_size);
+
+#endif
+
@@ -0,0 +1,111 @@
+#include "kowhai_rcu.h"
+#include "kowhai_barrier.h"
+
+#include <string.h>
+
+int kowhai_rcu_init(struct kowhai_rcu_tree_t* rcu, const struct kowhai_node_t* desc, void** buffers, int num_buffers, volatile uint32_t* readers, int num_readers)
+{
+    int i, ret;
+
+    if (num_buffers < 2 || num_buffers > KOWHAI_RCU_MAX_BUFFERS)
+        return KOW_STATUS_BUFFER_INVALID;
+    ret = kowhai_get_node_size(desc, &rcu->size);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+
+    for (i = 0; i < num_buffers; i++)
+    {
+        rcu->buffers[i] = buffers[i];
+        rcu->retired[i] = 0;
+    }
+    rcu->num_buffers = num_buffers;
+    rcu->current = buffers[0];
+    rcu->current_index = 0;
+    rcu->shadow_index = -1;
+    // epoch 0 marks an idle reader slot
+    rcu->epoch = 1;
+    rcu->readers = readers;
+    rcu->num_readers = num_readers;
+    for (i = 0; i < num_readers; i++)
+        readers[i] = 0;
+    return KOW_STATUS_OK;
+}
+
+void* kowhai_rcu_read_lock(struct kowhai_rcu_tree_t* rcu, int reader)
+{
+    // the epoch must be recorded before the data pointer is read so the writer can see this reader
+    rcu->readers[reader] = rcu->epoch;
+    KOWHAI_BARRIER();
+    return rcu->current;
+}
+
+void kowhai_rcu_read_unlock(struct kowhai_rcu_tree_t* rcu, int reader)
+{
+    KOWHAI_BARRIER();
+    rcu->readers[reader] = 0;
+}
+
+void* kowhai_rcu_get_data(struct kowhai_rcu_tree_t* rcu)
+{
+    return rcu->current;
+}
+
+// can a buffer be reused (no reader started before it was replaced)
+static int buffer_is_free(struct kowhai_rcu_tree_t* rcu, int index)
+{
+    int i;
+    for (i = 0; i < rcu->num_readers; i++)
+    {
+        uint32_t epoch = rcu->readers[i];
+        if (epoch != 0 && epoch < rcu->retired[index])
+            return 0;
+    }
+    return 1;
+}
+
+int kowhai_rcu_write_begin(struct kowhai_rcu_tree_t* rcu, void** data)
+{
+    int i;
+
+    if (rcu->shadow_index < 0)
+    {
+        // wait for a buffer that no reader can still be using
+        while (1)
+        {
+            KOWHAI_BARRIER();
+            for (i = 0; i < rcu->num_buffers; i++)
+            {
+                if (i != rcu->current_index && buffer_is_free(rcu, i))
+                    break;
+            }
+            if (i < rcu->num_buffers)
+                break;
+        }
+        rcu->shadow_index = i;
+        memcpy(rcu->buffers[i], rcu->buffers[rcu->current_index], rcu->size);
+    }
+
+    *data = rcu->buffers[rcu->shadow_index];
+    return KOW_STATUS_OK;
+}
+
+int kowhai_rcu_publish(struct kowhai_rcu_tree_t* rcu)
+{
+    if (rcu->shadow_index < 0)
+        return KOW_STATUS_INVALID_SEQUENCE;
+
+    // the shadow data must be visible before the pointer swap, and the swap before the new epoch
+    KOWHAI_BARRIER();
+    rcu->current = rcu->buffers[rcu->shadow_index];
+    KOWHAI_BARRIER();
+    rcu->retired[rcu->current_index] = ++rcu->epoch;
+    rcu->current_index = rcu->shadow_index;
+    rcu->shadow_index = -1;
+    return KOW_STATUS_OK;
+}
+
+void kowhai_rcu_abort(struct kowhai_rcu_tree_t* rcu)
+{
+    rcu->shadow_index = -1;
+}
+
@@ -0,0 +1,89 @@
+#ifndef _KOWHAI_RCU_H_
+#define _KOWHAI_RCU_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief maximum number of data buffers in a read copy update tree (triple buffering)
+ */
+#define KOWHAI_RCU_MAX_BUFFERS 3
+
+/**
+ * @brief tree data that is updated by writing a shadow copy then publishing it with a single pointer swap
+ * Readers never block or see a partial update. A reader records the publish epoch it started in, a buffer that
+ * has been replaced is only reused once every reader that could still be using it has finished. Only one writer
+ * may update the tree at a time.
+ */
+struct kowhai_rcu_tree_t
+{
+    void* buffers[KOWHAI_RCU_MAX_BUFFERS];      ///< tree data buffers (supplied by the caller)
+    uint32_t retired[KOWHAI_RCU_MAX_BUFFERS];   ///< the epoch each buffer was replaced in (0 if it has never been published)
+    int num_buffers;                            ///< number of buffers
+    int size;                                   ///< size of the tree data in bytes
+    void* volatile current;                     ///< the published tree data
+    int current_index;                          ///< index of the published buffer
+    int shadow_index;                           ///< index of the buffer being written or -1 if there is no write in progress
+    volatile uint32_t epoch;                    ///< incremented each time a buffer is published
+    volatile uint32_t* readers;                 ///< the epoch each reader started in or 0 if it is not reading (supplied by the caller)
+    int num_readers;                            ///< number of reader slots
+};
+
+/**
+ * @brief initialise a read copy update tree
+ * @param rcu, the tree to initialise
+ * @param desc, the tree descriptor
+ * @param buffers, data buffers big enough for the tree data, the first buffer is published first (the others are overwritten)
+ * @param num_buffers, number of buffers (2 for double buffering up to KOWHAI_RCU_MAX_BUFFERS)
+ * @param readers, a slot for each reader thread
+ * @param num_readers, number of reader slots
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_rcu_init(struct kowhai_rcu_tree_t* rcu, const struct kowhai_node_t* desc, void** buffers, int num_buffers, volatile uint32_t* readers, int num_readers);
+
+/**
+ * @brief start reading the published tree data, this never blocks
+ * @param rcu, the tree to read
+ * @param reader, the slot of the calling reader
+ * @return the tree data to read from, it will not change until kowhai_rcu_read_unlock is called
+ */
+void* kowhai_rcu_read_lock(struct kowhai_rcu_tree_t* rcu, int reader);
+
+/**
+ * @brief finish reading the tree data returned by kowhai_rcu_read_lock
+ * @param rcu, the tree being read
+ * @param reader, the slot of the calling reader
+ */
+void kowhai_rcu_read_unlock(struct kowhai_rcu_tree_t* rcu, int reader);
+
+/**
+ * @brief get the published tree data (only safe from the writer thread or when there are no writers)
+ * @param rcu, the tree
+ * @return the published tree data
+ */
+void* kowhai_rcu_get_data(struct kowhai_rcu_tree_t* rcu);
+
+/**
+ * @brief start updating the tree, the shadow buffer starts as a copy of the published data
+ * This waits for readers of the buffer to be reused if they started before it was replaced. If a write is already
+ * in progress the same shadow buffer is returned.
+ * @param rcu, the tree to update
+ * @param data, set to the shadow buffer to write to
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_rcu_write_begin(struct kowhai_rcu_tree_t* rcu, void** data);
+
+/**
+ * @brief publish the shadow buffer so new readers see all the writes at once
+ * @param rcu, the tree being updated
+ * @return kowhai status value, ie KOW_STATUS_OK on success or KOW_STATUS_INVALID_SEQUENCE if there is no write in progress
+ */
+int kowhai_rcu_publish(struct kowhai_rcu_tree_t* rcu);
+
+/**
+ * @brief throw away the shadow buffer without publishing it
+ * @param rcu, the tree being updated
+ */
+void kowhai_rcu_abort(struct kowhai_rcu_tree_t* rcu);
+
+#endif
+
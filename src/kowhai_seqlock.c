@@ -0,0 +1,200 @@
+#include "kowhai_seqlock.h"
+#include "kowhai_barrier.h"
+#include "kowhai_snapshot.h"
+
+#include <string.h>
+
+int kowhai_seqlock_get_branch_count(const struct kowhai_node_t *desc, int *count)
+{
+    const struct kowhai_node_t *node = desc + 1;
+    int children = 0;
+
+    if (desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+
+    while (node->type != KOW_BRANCH_END)
+    {
+        int node_count;
+        int ret = kowhai_get_node_count(node, &node_count);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        node += node_count;
+        children++;
+    }
+    // each array item of the root node has its own copy of the children
+    *count = children * desc->count;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_seqlock_init(struct kowhai_seqlock_set_t *set, const struct kowhai_node_t *desc, struct kowhai_seqlock_t *locks, int num_locks)
+{
+    int size, count, ret, i;
+    int end = 0;
+
+    ret = kowhai_get_node_size(desc, &size);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    ret = kowhai_seqlock_get_branch_count(desc, &count);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    if (num_locks != 1 && num_locks != count)
+        return KOW_STATUS_BUFFER_INVALID;
+
+    set->locks = locks;
+    set->num_locks = num_locks;
+    for (i = 0; i < num_locks; i++)
+        locks[i].sequence = 0;
+    if (num_locks == 1)
+    {
+        locks[0].end = size;
+        return KOW_STATUS_OK;
+    }
+
+    // a lock for each child of each root array item
+    i = 0;
+    while (i < num_locks)
+    {
+        const struct kowhai_node_t *node = desc + 1;
+        while (node->type != KOW_BRANCH_END)
+        {
+            int node_size, node_count;
+            ret = kowhai_get_node_size(node, &node_size);
+            if (ret != KOW_STATUS_OK)
+                return ret;
+            ret = kowhai_get_node_count(node, &node_count);
+            if (ret != KOW_STATUS_OK)
+                return ret;
+            end += node_size;
+            locks[i++].end = end;
+            node += node_count;
+        }
+    }
+    return KOW_STATUS_OK;
+}
+
+// find the first lock covering an offset
+static int first_lock(const struct kowhai_seqlock_set_t *set, int offset)
+{
+    int lo = 0, hi = set->num_locks;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (set->locks[mid].end <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void kowhai_seqlock_write_begin(struct kowhai_seqlock_set_t *set, int offset, int size)
+{
+    int i;
+    for (i = first_lock(set, offset); i < set->num_locks; i++)
+    {
+        set->locks[i].sequence++;
+        if (set->locks[i].end >= offset + size)
+            break;
+    }
+    // the odd sequences must be visible before any data is written
+    KOWHAI_BARRIER();
+}
+
+void kowhai_seqlock_write_end(struct kowhai_seqlock_set_t *set, int offset, int size)
+{
+    int i;
+    // the data must be visible before the sequences are even again
+    KOWHAI_BARRIER();
+    for (i = first_lock(set, offset); i < set->num_locks; i++)
+    {
+        set->locks[i].sequence++;
+        if (set->locks[i].end >= offset + size)
+            break;
+    }
+}
+
+// add up the sequences of all the locks covering a range, sequences only ever increase so any write changes the sum
+static uint32_t sum_sequences(const struct kowhai_seqlock_set_t *set, int offset, int size, int wait)
+{
+    uint32_t sum = 0;
+    int i;
+    for (i = first_lock(set, offset); i < set->num_locks; i++)
+    {
+        uint32_t sequence = set->locks[i].sequence;
+        while (wait && (sequence & 1))
+            sequence = set->locks[i].sequence;
+        sum += sequence;
+        if (set->locks[i].end >= offset + size)
+            break;
+    }
+    return sum;
+}
+
+uint32_t kowhai_seqlock_read_begin(const struct kowhai_seqlock_set_t *set, int offset, int size)
+{
+    uint32_t sequence = sum_sequences(set, offset, size, 1);
+    KOWHAI_BARRIER();
+    return sequence;
+}
+
+int kowhai_seqlock_read_retry(const struct kowhai_seqlock_set_t *set, int offset, int size, uint32_t sequence)
+{
+    KOWHAI_BARRIER();
+    return sum_sequences(set, offset, size, 0) != sequence;
+}
+
+// find the tree data offset of a read or write and check it fits in the node
+static int resolve_access(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int access_offset, int access_size, int *offset)
+{
+    struct kowhai_node_t* node;
+    int size;
+    int status;
+
+    status = kowhai_get_node(tree->desc, num_symbols, symbols, offset, &node);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (access_offset < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+    status = kowhai_get_node_size(node, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (access_size + access_offset > size)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+    *offset += access_offset;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_seqlock_read(const struct kowhai_seqlock_set_t *set, struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int read_offset, void* result, int read_size)
+{
+    uint32_t sequence;
+    int offset;
+    int status = resolve_access(tree, num_symbols, symbols, read_offset, read_size, &offset);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    do
+    {
+        sequence = kowhai_seqlock_read_begin(set, offset, read_size);
+        memcpy(result, (char*)tree->data + offset, read_size);
+    }
+    while (kowhai_seqlock_read_retry(set, offset, read_size, sequence));
+    return KOW_STATUS_OK;
+}
+
+int kowhai_seqlock_write(struct kowhai_seqlock_set_t *set, struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int write_offset, void* value, int write_size)
+{
+    int offset;
+    int status = resolve_access(tree, num_symbols, symbols, write_offset, write_size, &offset);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    kowhai_seqlock_write_begin(set, offset, write_size);
+    if (tree->snapshot != NULL)
+        kowhai_snapshot_preserve(tree->snapshot, offset, write_size);
+    memcpy((char*)tree->data + offset, value, write_size);
+    if (tree->dirty != NULL)
+        kowhai_dirty_mark(tree->dirty, offset, write_size);
+    kowhai_seqlock_write_end(set, offset, write_size);
+    return KOW_STATUS_OK;
+}
+
@@ -0,0 +1,106 @@
+#ifndef _KOWHAI_SEQLOCK_H_
+#define _KOWHAI_SEQLOCK_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief a sequence lock over a range of tree data
+ * The sequence is odd while a write is in progress, readers copy the data without locking and retry if the
+ * sequence changed while they were copying
+ */
+struct kowhai_seqlock_t
+{
+    volatile uint32_t sequence;     ///< incremented at the start and end of every write
+    int32_t end;                    ///< one past the last byte of tree data covered by this lock
+};
+
+/**
+ * @brief the sequence locks protecting a tree, either one for the whole tree or one for each child of the root node
+ */
+struct kowhai_seqlock_set_t
+{
+    struct kowhai_seqlock_t *locks;     ///< locks in data order (supplied by the caller)
+    int num_locks;                      ///< number of locks
+};
+
+/**
+ * @brief get the number of locks needed to lock each child branch of the root node separately
+ * @param desc, the tree descriptor
+ * @param count, set to the number of locks needed
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_seqlock_get_branch_count(const struct kowhai_node_t *desc, int *count);
+
+/**
+ * @brief initialise the sequence locks for a tree
+ * @param set, the lock set to initialise
+ * @param desc, the tree descriptor
+ * @param locks, storage for the locks
+ * @param num_locks, 1 to lock the whole tree with a single lock or the count from kowhai_seqlock_get_branch_count to lock each child of the root node separately
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_seqlock_init(struct kowhai_seqlock_set_t *set, const struct kowhai_node_t *desc, struct kowhai_seqlock_t *locks, int num_locks);
+
+/**
+ * @brief start writing to a range of tree data, only one writer may write to a lock at a time
+ * @param set, the locks of the tree
+ * @param offset, offset of the first byte to write in the tree data
+ * @param size, number of bytes to write
+ */
+void kowhai_seqlock_write_begin(struct kowhai_seqlock_set_t *set, int offset, int size);
+
+/**
+ * @brief finish writing to a range of tree data (the offset and size must match kowhai_seqlock_write_begin)
+ * @param set, the locks of the tree
+ * @param offset, offset of the first byte written in the tree data
+ * @param size, number of bytes written
+ */
+void kowhai_seqlock_write_end(struct kowhai_seqlock_set_t *set, int offset, int size);
+
+/**
+ * @brief start reading a range of tree data, this waits for any write in progress to finish
+ * @param set, the locks of the tree
+ * @param offset, offset of the first byte to read in the tree data
+ * @param size, number of bytes to read
+ * @return the sequence to pass to kowhai_seqlock_read_retry once the data has been copied
+ */
+uint32_t kowhai_seqlock_read_begin(const struct kowhai_seqlock_set_t *set, int offset, int size);
+
+/**
+ * @brief check if a range of tree data was written while it was being read
+ * @param set, the locks of the tree
+ * @param offset, offset of the first byte read in the tree data
+ * @param size, number of bytes read
+ * @param sequence, the value returned by kowhai_seqlock_read_begin
+ * @return non zero if the data was changed and must be read again
+ */
+int kowhai_seqlock_read_retry(const struct kowhai_seqlock_set_t *set, int offset, int size, uint32_t sequence);
+
+/**
+ * @brief Read from a tree data buffer starting at a symbol path, retrying until the read is not torn by a write (see kowhai_read)
+ * @param set, the locks of the tree
+ * @param tree, the tree to read from
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the item to read
+ * @param read_offset, the offset into the node data to start reading from
+ * @param result, buffer for the data read
+ * @param read_size, number of bytes to read
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_seqlock_read(const struct kowhai_seqlock_set_t *set, struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int read_offset, void* result, int read_size);
+
+/**
+ * @brief Write to a tree data buffer starting at a symbol path inside a sequence lock write (see kowhai_write)
+ * @param set, the locks of the tree
+ * @param tree, the tree to write to
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the item to write
+ * @param write_offset, the offset into the node data to start writing at
+ * @param value, the data to write
+ * @param write_size, number of bytes to write
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_seqlock_write(struct kowhai_seqlock_set_t *set, struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int write_offset, void* value, int write_size);
+
+#endif
+
@@ -24,6 +24,9 @@
 
 #define MIN(a,b) ((a<b)?a:b)
 
+// returned by the serialize walkers when the walk stack is too small
+#define SERIALIZE_STACK_TOO_SMALL -2000
+
 union any_type_t
 {
     char c;
@@ -165,53 +168,127 @@ static int str_printable(char *str, int len)
     return 1;
 }
 
-int serialize_tree(struct kowhai_node_t** desc, void** data, char* target_buffer, size_t target_size, int level, void* get_name_param, kowhai_get_symbol_name_t get_name, int in_union, int* largest_data_field)
+// serialize the node at desc, each branch walked into saves its state on the stack (from stack->depth up)
+static int serialize_tree(struct kowhai_node_t* desc, void* data, char* target_buffer, size_t target_size, void* get_name_param, kowhai_get_symbol_name_t get_name, int in_union, struct kowhai_walk_stack_t *stack)
 {
+    struct kowhai_walk_frame_t *frame;
     int target_offset = 0;
+    int largest_data_field = 0;
+    int base = stack->depth;
+    int level = 0;
     struct kowhai_node_t* node;
     int i, chars;
     char* node_end_str;
 
     while (1)
     {
-        node = *desc;
+        node = desc;
 
         if (node->type == KOW_BRANCH_END)
-            return target_offset;
-
-        // indent to current level using tabs
-        chars = add_indent(&target_buffer, &target_size, &target_offset, level);
-        if (chars < 0)
-            return chars;
-
-        //
-        // write node
-        //
-
-        switch (node->type)
         {
-            case KOW_BRANCH_START:
-            case KOW_BRANCH_U_START:
+            if (level == 0)
+                return target_offset;
+
+            // the children of a branch (array item) are done
+            frame = kowhai_walk_stack_frame(stack, base + level - 1);
+            node = (struct kowhai_node_t*)frame->node;
+            if (node->count > 1)
             {
-                int node_is_union = node->type == KOW_BRANCH_U_START;
-                int largest_child_data_field = 0;
-                void* initial_data = *data;
-                // write header
-                chars = add_header(&target_buffer, &target_size, &target_offset, node, get_name_param, get_name);
+                // increment data pointer if node is a union
+                if (node->type == KOW_BRANCH_U_START)
+                {
+                    data = (char*)frame->data + frame->value[0];
+                    frame->data = data;
+                }
+                // indent to current level using tab
+                chars = add_indent(&target_buffer, &target_size, &target_offset, level);
                 if (chars < 0)
                     return chars;
-                if (node->count > 1)
+                // write branch children end
+                chars = add_string(&target_buffer, &target_size, &target_offset, "]");
+                if (chars < 0)
+                    return chars;
+                if (frame->index < node->count - 1)
                 {
-                    struct kowhai_node_t* initial_node = *desc;
-                    // write array identifier
-                    chars = add_string(&target_buffer, &target_size, &target_offset, ", \""ARRAY"\": [\n");
+                    chars = add_string(&target_buffer, &target_size, &target_offset, ",\n");
                     if (chars < 0)
-                    return chars;
-                    for (i = 0; i < node->count; i++)
+                        return chars;
+                }
+                else
+                {
+                    chars = add_string(&target_buffer, &target_size, &target_offset, "\n");
+                    if (chars < 0)
+                        return chars;
+                }
+                frame->index++;
+                if (frame->index < node->count)
+                {
+                    // set descriptor to the first child of the branch for the next array item
+                    desc = node + 1;
+                    // indent to current level using tab
+                    chars = add_indent(&target_buffer, &target_size, &target_offset, level);
+                    if (chars < 0)
+                        return chars;
+                    // write branch children start
+                    chars = add_string(&target_buffer, &target_size, &target_offset, "[\n");
+                    if (chars < 0)
+                        return chars;
+                    continue;
+                }
+            }
+            else if (node->type == KOW_BRANCH_U_START)
+                // increment data pointer if node is a union
+                data = (char*)frame->data + frame->value[0];
+
+            // back to the level of the branch
+            level--;
+            // indent to current level using tab
+            chars = add_indent(&target_buffer, &target_size, &target_offset, level);
+            if (chars < 0)
+                return chars;
+            // write node end
+            if (level == 0 || desc[1].type == KOW_BRANCH_END)
+                node_end_str = "]}\n";
+            else
+                node_end_str = "]},\n";
+            chars = add_string(&target_buffer, &target_size, &target_offset, node_end_str);
+            if (chars < 0)
+                return chars;
+        }
+        else
+        {
+            // indent to current level using tabs
+            chars = add_indent(&target_buffer, &target_size, &target_offset, level);
+            if (chars < 0)
+                return chars;
+
+            //
+            // write node
+            //
+
+            switch (node->type)
+            {
+                case KOW_BRANCH_START:
+                case KOW_BRANCH_U_START:
+                {
+                    // save the branch so we can come back to it after its children
+                    frame = kowhai_walk_stack_push(stack, base + level);
+                    if (frame == NULL)
+                        return SERIALIZE_STACK_TOO_SMALL;
+                    frame->node = node;
+                    frame->data = data;
+                    frame->index = 0;
+                    frame->value[0] = 0;
+                    // write header
+                    chars = add_header(&target_buffer, &target_size, &target_offset, node, get_name_param, get_name);
+                    if (chars < 0)
+                        return chars;
+                    if (node->count > 1)
                     {
-                        // set descriptor to initial node at the branch array
-                        *desc = initial_node;
-                        (*desc) += 1;
+                        // write array identifier
+                        chars = add_string(&target_buffer, &target_size, &target_offset, ", \""ARRAY"\": [\n");
+                        if (chars < 0)
+                            return chars;
                         // indent to current level using tab
                         chars = add_indent(&target_buffer, &target_size, &target_offset, level + 1);
                         if (chars < 0)
@@ -220,175 +297,171 @@ int serialize_tree(struct kowhai_node_t** desc, void** data, char* target_buffer
                         chars = add_string(&target_buffer, &target_size, &target_offset, "[\n");
                         if (chars < 0)
                             return chars;
-                        // write branch children
-                        chars = serialize_tree(desc, data, target_buffer, target_size, level + 1, get_name_param, get_name, node_is_union, &largest_child_data_field);
-                        if (chars < 0)
-                            return chars;
-                        target_offset += chars;
-                        target_buffer += chars;
-                        target_size -= chars;
-                        // increment data pointer if node is a union
-                        if (node_is_union)
-                        {
-                            *data = (char*)initial_data + largest_child_data_field;
-                            initial_data = *data;
-                        }
-                        // indent to current level using tab
-                        chars = add_indent(&target_buffer, &target_size, &target_offset, level + 1);
-                        if (chars < 0)
-                            return chars;
-                        // write branch children end
-                        chars = add_string(&target_buffer, &target_size, &target_offset, "]");
+                    }
+                    else
+                    {
+                        // write children identifier
+                        chars = add_string(&target_buffer, &target_size, &target_offset, ", \""CHILDREN"\": [\n");
                         if (chars < 0)
                             return chars;
-                        if (i < node->count - 1)
-                        {
-                            chars = add_string(&target_buffer, &target_size, &target_offset, ",\n");
-                            if (chars < 0)
-                                return chars;
-                        }
-                        else
-                        {
-                            chars = add_string(&target_buffer, &target_size, &target_offset, "\n");
-                            if (chars < 0)
-                                return chars;
-                        }
                     }
-                }
-                else
-                {
-                    // write children identifier
-                    chars = add_string(&target_buffer, &target_size, &target_offset, ", \""CHILDREN"\": [\n");
-                    if (chars < 0)
-                        return chars;
                     // write branch children
-                    (*desc) += 1;
-                    chars = serialize_tree(desc, data, target_buffer, target_size, level + 1, get_name_param, get_name, node_is_union, &largest_child_data_field);
-                    if (chars < 0)
-                        return chars;
-                    target_offset += chars;
-                    target_buffer += chars;
-                    target_size -= chars;
-                    // increment data pointer if node is a union
-                    if (node_is_union)
-                        *data = (char*)initial_data + largest_child_data_field;
+                    desc = node + 1;
+                    level++;
+                    continue;
                 }
-                // indent to current level using tab
-                chars = add_indent(&target_buffer, &target_size, &target_offset, level);
-                if (chars < 0)
-                    return chars;
-                // write node end
-                if (level == 0 || (*desc)[1].type == KOW_BRANCH_END)
-                    node_end_str = "]}\n";
-                else
-                    node_end_str = "]},\n";
-                chars = add_string(&target_buffer, &target_size, &target_offset, node_end_str);
-                if (chars < 0)
-                    return chars;
-                break;
-            }
-            default:
-            {
-                int value_size = kowhai_get_node_type_size(node->type);
-                // write header
-                chars = add_header(&target_buffer, &target_size, &target_offset, node, get_name_param, get_name);
-                if (chars < 0)
-                    return chars;
-                // write value identifier
-                chars = add_string(&target_buffer, &target_size, &target_offset, ", \""VALUE"\": ");
-                if (chars < 0)
-                    return chars;
-                // write value/s
-                if (node->type == KOW_CHAR && node->count > 1 && str_printable((char *)*data, node->count))
+                default:
                 {
-                    // special string case
-                    chars = write_string(target_buffer, target_size, "\"%.*s\"", node->count, (char*)*data);
-                    if (chars >= 0)
+                    int value_size = kowhai_get_node_type_size(node->type);
+                    int *largest = &largest_data_field;
+                    int leaf_in_union = in_union;
+                    // leaves in a union branch only track the largest field (the union moves the data pointer)
+                    if (level > 0)
                     {
-                        target_buffer += chars;
-                        target_size -= chars;
-                        target_offset += chars;
+                        frame = kowhai_walk_stack_frame(stack, base + level - 1);
+                        largest = &frame->value[0];
+                        leaf_in_union = frame->node->type == KOW_BRANCH_U_START;
                     }
-                    else
+                    // write header
+                    chars = add_header(&target_buffer, &target_size, &target_offset, node, get_name_param, get_name);
+                    if (chars < 0)
                         return chars;
-                    // increment data pointer
-                    if (!in_union)
-                        *data = (char*)*data + value_size * node->count;
-                    else if (value_size * node->count > *largest_data_field)
-                        *largest_data_field = value_size * node->count;
-                }
-                else if (node->count > 1)
-                {
-                    // write start bracket
-                    chars = add_string(&target_buffer, &target_size, &target_offset, "[");
+                    // write value identifier
+                    chars = add_string(&target_buffer, &target_size, &target_offset, ", \""VALUE"\": ");
                     if (chars < 0)
                         return chars;
-                    for (i = 0; i < node->count; i++)
+                    // write value/s
+                    if (node->type == KOW_CHAR && node->count > 1 && str_printable((char *)data, node->count))
                     {
-                        // write leaf node array item value
-                        chars = add_value(&target_buffer, &target_size, &target_offset, node->type, (char*)*data + i * value_size);
+                        // special string case
+                        chars = write_string(target_buffer, target_size, "\"%.*s\"", node->count, (char*)data);
+                        if (chars >= 0)
+                        {
+                            target_buffer += chars;
+                            target_size -= chars;
+                            target_offset += chars;
+                        }
+                        else
+                            return chars;
+                        // increment data pointer
+                        if (!leaf_in_union)
+                            data = (char*)data + value_size * node->count;
+                        else if (value_size * node->count > *largest)
+                            *largest = value_size * node->count;
+                    }
+                    else if (node->count > 1)
+                    {
+                        // write start bracket
+                        chars = add_string(&target_buffer, &target_size, &target_offset, "[");
                         if (chars < 0)
                             return chars;
-                        // write comma if there is another array item
-                        if (i < node->count - 1)
+                        for (i = 0; i < node->count; i++)
                         {
-                            chars = add_string(&target_buffer, &target_size, &target_offset, ", ");
+                            // write leaf node array item value
+                            chars = add_value(&target_buffer, &target_size, &target_offset, node->type, (char*)data + i * value_size);
                             if (chars < 0)
                                 return chars;
+                            // write comma if there is another array item
+                            if (i < node->count - 1)
+                            {
+                                chars = add_string(&target_buffer, &target_size, &target_offset, ", ");
+                                if (chars < 0)
+                                    return chars;
+                            }
                         }
+                        // increment data pointer
+                        if (!leaf_in_union)
+                            data = (char*)data + value_size * node->count;
+                        else if (value_size * node->count > *largest)
+                            *largest = value_size * node->count;
+                        // write end bracket
+                        chars = add_string(&target_buffer, &target_size, &target_offset, "]");
+                        if (chars < 0)
+                            return chars;
                     }
-                    // increment data pointer
-                    if (!in_union)
-                        *data = (char*)*data + value_size * node->count;
-                    else if (value_size * node->count > *largest_data_field)
-                        *largest_data_field = value_size * node->count;
-                    // write end bracket
-                    chars = add_string(&target_buffer, &target_size, &target_offset, "]");
-                    if (chars < 0)
-                        return chars;
-                }
-                else
-                {
-                    // write leaf node value
-                    chars = add_value(&target_buffer, &target_size, &target_offset, node->type, *data);
+                    else
+                    {
+                        // write leaf node value
+                        chars = add_value(&target_buffer, &target_size, &target_offset, node->type, data);
+                        if (chars < 0)
+                            return chars;
+                        // increment data pointer
+                        if (!leaf_in_union)
+                            data = (char*)data + value_size;
+                        else if (value_size > *largest)
+                            *largest = value_size;
+                    }
+                    // write node end
+                    if (level == 0 || node[1].type == KOW_BRANCH_END)
+                        node_end_str = " }\n";
+                    else
+                        node_end_str = " },\n";
+                    chars = add_string(&target_buffer, &target_size, &target_offset, node_end_str);
                     if (chars < 0)
                         return chars;
-                    // increment data pointer
-                    if (!in_union)
-                        *data = (char*)*data + value_size;
-                    else if (value_size > *largest_data_field)
-                        *largest_data_field = value_size;
+                    break;
                 }
-                // write node end
-                if (level == 0 || node[1].type == KOW_BRANCH_END)
-                    node_end_str = " }\n";
-                else
-                    node_end_str = " },\n";
-                chars = add_string(&target_buffer, &target_size, &target_offset, node_end_str);
-                if (chars < 0)
-                    return chars;
-                break;
             }
         }
 
         if (level == 0)
             return target_offset;
 
-        (*desc) += 1;
+        desc += 1;
     }
 }
 
+// the parameters of a serialize walk run by kowhai_walk_default
+struct serialize_walk_t
+{
+    struct kowhai_tree_t tree;
+    struct kowhai_node_t *desc;
+    const struct kowhai_node_tables_t *tables;
+    char *dst;
+    int *dst_len;
+    union kowhai_symbol_t *path;
+    int path_len;
+    void *get_name_param;
+    kowhai_get_symbol_name_t get_name;
+};
+
+static int serialize_tree_walk(void *param, struct kowhai_walk_stack_t *stack)
+{
+    struct serialize_walk_t *walk = (struct serialize_walk_t*)param;
+    return kowhai_serialize_tree_ex(walk->tree, walk->dst, walk->dst_len, walk->get_name_param, walk->get_name, stack);
+}
+
 int kowhai_serialize_tree(struct kowhai_tree_t tree, char* target_buffer, int* target_size, void* get_name_param, kowhai_get_symbol_name_t get_name)
 {
-    int largest_data_field;
-    int chars = serialize_tree(&tree.desc, &tree.data, target_buffer, *target_size, 0, get_name_param, get_name, tree.desc->type == KOW_BRANCH_U_START, &largest_data_field);
+    struct serialize_walk_t walk;
+    walk.tree = tree;
+    walk.dst = target_buffer;
+    walk.dst_len = target_size;
+    walk.get_name_param = get_name_param;
+    walk.get_name = get_name;
+    return kowhai_walk_default(kowhai_get_node_depth(tree.desc), serialize_tree_walk, &walk);
+}
+
+int kowhai_serialize_tree_ex(struct kowhai_tree_t tree, char* target_buffer, int* target_size, void* get_name_param, kowhai_get_symbol_name_t get_name, struct kowhai_walk_stack_t *stack)
+{
+    int chars = serialize_tree(tree.desc, tree.data, target_buffer, *target_size, get_name_param, get_name, tree.desc->type == KOW_BRANCH_U_START, stack);
+    if (chars == SERIALIZE_STACK_TOO_SMALL)
+        return KOW_STATUS_STACK_TOO_SMALL;
     if (chars < 0)
         return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
     *target_size = chars;
     return KOW_STATUS_OK;
 }
 
-static int path_to_str(union kowhai_symbol_t *path, int path_len, char *dst, int dst_len, const char *separator, int hide_last_index, struct kowhai_node_t *root, void* get_name_param, kowhai_get_symbol_name_t get_name)
+// find a node from the root of the tree, using the precomputed tables if we have them
+static int find_node(struct kowhai_node_t *root, const struct kowhai_node_tables_t *tables, struct kowhai_walk_stack_t *stack, int num_symbols, union kowhai_symbol_t *symbols, struct kowhai_node_t **target_node)
+{
+    if (tables != NULL)
+        return kowhai_get_node_from_tables(tables, num_symbols, symbols, NULL, target_node);
+    return kowhai_get_node_ex(root, num_symbols, symbols, NULL, target_node, stack);
+}
+
+static int path_to_str(union kowhai_symbol_t *path, int path_len, char *dst, int dst_len, const char *separator, int hide_last_index, struct kowhai_node_t *root, const struct kowhai_node_tables_t *tables, struct kowhai_walk_stack_t *stack, void* get_name_param, kowhai_get_symbol_name_t get_name)
 {
     int i, r, e;
     int count = 0;
@@ -401,8 +474,8 @@ static int path_to_str(union kowhai_symbol_t *path, int path_len, char *dst, int
         // node count for each path item using kowhai_get_node(), then we only add the index if it
         // is not 0 
         if (root)
-            if ((e = kowhai_get_node(root, i+1, path, 0, &tnode)) != KOW_STATUS_OK)
-                return -1;
+            if ((e = find_node(root, tables, stack, i+1, path, &tnode)) != KOW_STATUS_OK)
+                return e == KOW_STATUS_STACK_TOO_SMALL ? SERIALIZE_STACK_TOO_SMALL : -1;
         
         // display the index at the end of this node if we can know the count of this node (needs root so we can find this node from
         // the path), and if the count > 1 ie is an array, and if this is the last item and hide_last_index == true
@@ -448,7 +521,30 @@ static const char *strnchr(const char *str, size_t len, char c)
     return NULL;
 }
 
-int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbol_t *path, int *path_len, void *get_name_param, kowhai_get_symbol_t get_name)
+// parse an array index or query slice ('*', 'n', 'n:m', 'n:' or ':m') from the chars between '[' and ']'
+static void parse_slice(const char *str, int len, struct kowhai_query_symbol_t *query)
+{
+    const char *colon = strnchr(str, len, ':');
+
+    if (len == 1 && str[0] == '*')
+    {
+        query->start = 0;
+        query->end = KOWHAI_QUERY_END;
+    }
+    else if (colon != NULL)
+    {
+        query->start = colon > str ? atoi(str) : 0;
+        query->end = colon < str + len - 1 ? atoi(colon + 1) : KOWHAI_QUERY_END;
+    }
+    else
+    {
+        query->start = atoi(str);
+        query->end = query->start + 1;
+    }
+}
+
+// split a path string into symbols and fill either a symbol path or a query path
+static int parse_path_str(const char *path_str, int path_strlen, union kowhai_symbol_t *path, struct kowhai_query_symbol_t *query, int *path_len, void *get_name_param, kowhai_get_symbol_t get_name)
 {
     int ipath = 0;
     const char *init = path_str;
@@ -480,9 +576,23 @@ int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbo
         r = get_name(get_name_param, sym_start, istart - sym_start);
         if (r < 0)
             return KOW_STATUS_NOT_FOUND;
-        path[ipath++].symbol = KOWHAI_SYMBOL(r, index);
-        if (ipath >= *path_len)
-            return KOW_STATUS_PATH_TOO_SMALL; // path buffer not big enough
+        if (query != NULL)
+        {
+            if (ipath >= *path_len)
+                return KOW_STATUS_PATH_TOO_SMALL; // query buffer not big enough
+            query[ipath].name = r;
+            query[ipath].start = index;
+            query[ipath].end = index + 1;
+            if (istart != sym_end)
+                parse_slice(istart + 1, iend - istart - 1, &query[ipath]);
+            ipath++;
+        }
+        else
+        {
+            path[ipath++].symbol = KOWHAI_SYMBOL(r, index);
+            if (ipath >= *path_len)
+                return KOW_STATUS_PATH_TOO_SMALL; // path buffer not big enough
+        }
 
         sym_start = sym_end + 1;
     }
@@ -492,6 +602,16 @@ int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbo
     return KOW_STATUS_OK;
 }
 
+int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbol_t *path, int *path_len, void *get_name_param, kowhai_get_symbol_t get_name)
+{
+    return parse_path_str(path_str, path_strlen, path, NULL, path_len, get_name_param, get_name);
+}
+
+int kowhai_str_to_query(const char *path_str, int path_strlen, struct kowhai_query_symbol_t *query, int *query_len, void *get_name_param, kowhai_get_symbol_t get_name)
+{
+    return parse_path_str(path_str, path_strlen, NULL, query, query_len, get_name_param, get_name);
+}
+
 // internal helper function to avoid return type conflicts with the kowhai method
 static int str_to_path(jsmn_parser* parser, jsmntok_t* tok, union kowhai_symbol_t *path, int path_len, void *get_name_param, kowhai_get_symbol_t get_name)
 {
@@ -605,7 +725,7 @@ static int val_to_str(struct kowhai_node_t *node, void *data, char *dst, int dst
     return count;
 }
 
-static int print_node_type(struct kowhai_node_t *root, char *dst, int dst_len, struct kowhai_node_t *node, void **src_data, 
+static int print_node_type(struct kowhai_node_t *root, const struct kowhai_node_tables_t *tables, struct kowhai_walk_stack_t *stack, char *dst, int dst_len, struct kowhai_node_t *node, void **src_data, 
         union kowhai_symbol_t *path, int ipath, void* get_name_param, kowhai_get_symbol_name_t get_name)
 {
     int r, count = 0;
@@ -620,7 +740,9 @@ static int print_node_type(struct kowhai_node_t *root, char *dst, int dst_len, s
     count += r;
     dst_len -= r;
 
-    r = path_to_str(path, ipath + 1, dst, dst_len, ".", 1, root, get_name_param, get_name);
+    r = path_to_str(path, ipath + 1, dst, dst_len, ".", 1, root, tables, stack, get_name_param, get_name);
+    if (r == SERIALIZE_STACK_TOO_SMALL)
+        return r;
     if (r < 0)
         return -1;
     if (r > dst_len)
@@ -722,172 +844,223 @@ static int print_node_type(struct kowhai_node_t *root, char *dst, int dst_len, s
 }
 
 
-static int serialize_nodes(struct kowhai_node_t *root, char *dst, int dst_len, struct kowhai_node_t *src_node, void **src_data, 
-                    union kowhai_symbol_t *path, int ipath, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name,
-                    int is_union, int level)
+// get the size and node count of a node, using the precomputed tables if we have them
+static int get_node_size_and_count(const struct kowhai_node_tables_t *tables, struct kowhai_walk_stack_t *stack, struct kowhai_node_t *node, int *size, int *count)
 {
-    int r, i, n = 0;
+    int ret;
+    if (tables != NULL)
+    {
+        ret = kowhai_get_node_size_from_tables(tables, node, size);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        return kowhai_get_node_count_from_tables(tables, node, count);
+    }
+    ret = kowhai_get_node_size_ex(node, size, stack);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    return kowhai_get_node_count_ex(node, count, stack);
+}
+
+// the output did not fit in dst, add on the characters counted by each parent level (as if returning up through them)
+static int truncated_count(struct kowhai_walk_stack_t *stack, int base, int level, int count)
+{
+    while (level > 0)
+    {
+        level--;
+        count += kowhai_walk_stack_frame(stack, base + level)->value[0];
+    }
+    return count;
+}
+
+// serialize the nodes from src_node on, each branch array item walked into saves the state of its parent on the stack
+static int serialize_nodes(struct kowhai_node_t *root, const struct kowhai_node_tables_t *tables, struct kowhai_walk_stack_t *stack, char *dst, int dst_len, 
+                    struct kowhai_node_t *src_node, void **src_data, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name,
+                    int is_union)
+{
+    struct kowhai_walk_frame_t *frame;
+    int r = 0, i = 0, n = 0;
     int count = 0;
+    int ret;
     int node_size;
     int node_count;
     int max_union_size = 0;
     int rmax = 0;
+    int base = stack->depth;
+    int top_is_union = is_union;
+    int level = 0;
 
-    // print opening array brace only if we are level 0
-    if (level == 0)
-        STARTEND("[");
+    // print opening array brace (only the top level does this)
+    STARTEND("[");
 
     while (1)
     {
         struct kowhai_node_t *node = &src_node[n];
-        
-        switch(node->type)
-        {
-            case KOW_BRANCH_U_START:
-                if (kowhai_get_node_size(node, &node_size) != KOW_STATUS_OK)
-                    return -1;
 
-                // for each complex array type recurse into each array element
-                for (i = 0; i < node->count; i++)
-                {
-                    // append this branch to the path
-                    if (ipath >= path_len)
-                        return -2;
-                    path[ipath].symbol = KOWHAI_SYMBOL(node->symbol, i);
-                
-                    // recurse into branch
-                    r = serialize_nodes(root, dst, dst_len, node + 1, src_data, path, ipath + 1, path_len, get_name_param, get_name, 1, level + 1);
-                    if (r < 0)
-                        return r;
-                    if (r >= dst_len)
-                        return count + r;
-                }
-                
-                // union type over
-                dst += r;
-                count += r;
-                dst_len -= r;
-                *(char **)src_data += node_size;
-
-                // move past this branch in the descriptor
-                if (kowhai_get_node_count(node, &node_count) != KOW_STATUS_OK)
-                    return -1;
-                node_count -= 1;
-                n += node_count;
+        // the frames above the current level are free for the node lookups
+        stack->depth = base + level;
 
-                // ending criteria
-                if (level == 0)
-                {
-                    STARTEND("]");
-                    return count;
-                }
-                break;
+        if (node->type == KOW_BRANCH_END)
+        {
+            if (is_union)
+            {
+                dst += rmax;
+                count += rmax;
+                dst_len -= rmax;
+            }
+            if (level == 0)
+                return count;
 
-            case KOW_BRANCH_START:
-                if (kowhai_get_node_size(node, &node_size) != KOW_STATUS_OK)
-                    return -1;
+            // this branch array item is done, go back to the parent level with its result
+            r = count;
+            level--;
+            frame = kowhai_walk_stack_frame(stack, base + level);
+            src_node = (struct kowhai_node_t*)frame->node;
+            node = (struct kowhai_node_t*)frame->node2;
+            n = node - src_node;
+            dst = (char*)frame->data;
+            i = frame->index;
+            count = frame->value[0];
+            dst_len = frame->value[1];
+            max_union_size = frame->value[2];
+            rmax = frame->value[3];
+            is_union = level > 0 ? kowhai_walk_stack_frame(stack, base + level - 1)->node2->type == KOW_BRANCH_U_START : top_is_union;
+            if (r < 0)
+                return r;
+            if (r >= dst_len)
+                return truncated_count(stack, base, level, count + r);
+            if (node->type == KOW_BRANCH_START)
+            {
+                rmax = r;
 
-                // for each complex array type recurse into each array element
-                if ((is_union && (node_size >= max_union_size)) || !is_union)
+                // push pointer on if this is not a union
+                // if it is we do this at the end for the
+                // biggest field
+                if (!is_union)
                 {
-                    for (i = 0; i < node->count; i++)
-                    {
-                        // append this branch to the path
-                        if (ipath >= path_len)
-                            return -2;
-                        path[ipath].symbol = KOWHAI_SYMBOL(node->symbol, i);
-                    
-                        // recurse into branch
-                        r = serialize_nodes(root, dst, dst_len, node + 1, src_data, path, ipath + 1, path_len, get_name_param, get_name, 0, level + 1);
-                        if (r < 0)
-                            return r;
-                        if (r >= dst_len)
-                            return count + r;
-                        rmax = r;
-
-                        // push pointer on if this is not a union
-                        // if it is we do this at the end for the
-                        // biggest field
-                        if (!is_union)
-                        {
-                            dst += r;
-                            count += r;
-                            dst_len -= r;
-                        }
-                    }
+                    dst += r;
+                    count += r;
+                    dst_len -= r;
                 }
-                
-                // move past this branch in the descriptor
-                if (kowhai_get_node_count(node, &node_count) != KOW_STATUS_OK)
-                    return -1;
-                node_count -= 1;
-                n += node_count;
+            }
+            i++;
+        }
+        else if (node->type == KOW_BRANCH_START || node->type == KOW_BRANCH_U_START)
+        {
+            ret = get_node_size_and_count(tables, stack, node, &node_size, &node_count);
+            if (ret != KOW_STATUS_OK)
+                return ret == KOW_STATUS_STACK_TOO_SMALL ? SERIALIZE_STACK_TOO_SMALL : -1;
+            r = 0;
+            i = 0;
+            // in a union only recurse into branches that are at least as big as the largest field so far
+            if (node->type == KOW_BRANCH_START && is_union && node_size < max_union_size)
+                i = node->count;
+        }
+        else
+        {
+            // get this node size in bytes
+            node_size = kowhai_get_node_type_size(node->type) * node->count;
+            if (node_size < 0)
+                return -1;
 
-                // ending criteria
-                if (level == 0)
+            // handle unions
+            if (is_union)
+            {
+                if (node_size <= max_union_size)
                 {
-                    STARTEND("]");
-                    return count;
+                    n++;
+                    continue;
                 }
-                break;
+                max_union_size = node_size;
+            }
 
-            case KOW_BRANCH_END:
-                if (is_union)
-                {
-                    dst += rmax;
-                    count += rmax;
-                    dst_len -= rmax;
-                }
-                return count;
+            // update the path scratch buffer for this item
+            if (level >= path_len)
+                return -2;
+            path[level].symbol = KOWHAI_SYMBOL(node->symbol, 0);
 
-            default:
+            // print this item
+            r = print_node_type(root, tables, stack, dst, dst_len, node, src_data, path, level, get_name_param, get_name);
+            if (r < 0)
+                return r;
+            if (r > dst_len)
+                return truncated_count(stack, base, level, count + r);
+            rmax = r;
+            if (!is_union)
+            {
+                dst += r;
+                count += r;
+                dst_len -= r;
 
-                // get this node size in bytes
-                node_size = kowhai_get_node_type_size(node->type) * node->count;
-                if (node_size < 0)
-                    return -1;
+                // move the data pointer
+                *(char **)src_data += node_size;
+            }
 
-                // handle unions
-                if (is_union)
-                {
-                    if (node_size <= max_union_size)
-                        break;
-                    max_union_size = node_size;
-                }
+            n++;
+            continue;
+        }
 
-                // update the path scratch buffer for this item
-                if (ipath >= path_len)
-                    return -2;
-                path[ipath].symbol = KOWHAI_SYMBOL(node->symbol, 0);
-
-                // print this item
-                r = print_node_type(root, dst, dst_len, node, src_data, path, ipath, get_name_param, get_name);
-                if (r < 0)
-                    return r;
-                if (r > dst_len)
-                    return count + r;
-                rmax = r;
-                if (!is_union)
-                {
-                    dst += r;
-                    count += r;
-                    dst_len -= r;
+        // for each complex array type walk into each array element
+        if (i < node->count)
+        {
+            // append this branch to the path
+            if (level >= path_len)
+                return -2;
+            path[level].symbol = KOWHAI_SYMBOL(node->symbol, i);
+
+            // save this level and start on the branch array item
+            frame = kowhai_walk_stack_push(stack, base + level);
+            if (frame == NULL)
+                return SERIALIZE_STACK_TOO_SMALL;
+            frame->node = src_node;
+            frame->node2 = node;
+            frame->data = dst;
+            frame->index = i;
+            frame->value[0] = count;
+            frame->value[1] = dst_len;
+            frame->value[2] = max_union_size;
+            frame->value[3] = rmax;
+            level++;
+            src_node = node + 1;
+            n = 0;
+            count = 0;
+            max_union_size = 0;
+            rmax = 0;
+            is_union = node->type == KOW_BRANCH_U_START;
+            continue;
+        }
 
-                    // move the data pointer
-                    *(char **)src_data += node_size;
-                }
+        // move past this branch in the descriptor
+        ret = get_node_size_and_count(tables, stack, node, &node_size, &node_count);
+        if (ret != KOW_STATUS_OK)
+            return ret == KOW_STATUS_STACK_TOO_SMALL ? SERIALIZE_STACK_TOO_SMALL : -1;
+        if (node->type == KOW_BRANCH_U_START)
+        {
+            // union type over
+            dst += r;
+            count += r;
+            dst_len -= r;
+            *(char **)src_data += node_size;
+        }
+        n += node_count - 1;
 
-                break;
+        // ending criteria
+        if (level == 0)
+        {
+            STARTEND("]");
+            return count;
         }
         n++;
     }
 }
 
-int kowhai_serialize_nodes(char *dst, int *dst_len, struct kowhai_tree_t *src_tree, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name)
+// run serialize_nodes over a whole tree and convert the result to a kowhai status
+static int serialize_tree_nodes(char *dst, int *dst_len, struct kowhai_node_t *desc, const struct kowhai_node_tables_t *tables, void *data, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name, struct kowhai_walk_stack_t *stack)
 {
-    void *src_data = src_tree->data;
-    int is_union = src_tree->desc->type == KOW_BRANCH_U_START;
-    int chars = serialize_nodes(src_tree->desc, dst, *dst_len, src_tree->desc, &src_data, path, 0, path_len, get_name_param, get_name, is_union, 0);
+    void *src_data = data;
+    int is_union = desc->type == KOW_BRANCH_U_START;
+    int base = stack->depth;
+    int chars = serialize_nodes(desc, tables, stack, dst, *dst_len, desc, &src_data, path, path_len, get_name_param, get_name, is_union);
+    stack->depth = base;
 
     // handle errors
     switch (chars)
@@ -896,6 +1069,8 @@ int kowhai_serialize_nodes(char *dst, int *dst_len, struct kowhai_tree_t *src_tr
             return KOW_STATUS_UNKNOWN_ERROR;
         case -2:
             return KOW_STATUS_PATH_TOO_SMALL;
+        case SERIALIZE_STACK_TOO_SMALL:
+            return KOW_STATUS_STACK_TOO_SMALL;
         default:
             break;
     }
@@ -907,6 +1082,43 @@ int kowhai_serialize_nodes(char *dst, int *dst_len, struct kowhai_tree_t *src_tr
     return KOW_STATUS_OK;
 }
 
+static int serialize_nodes_walk(void *param, struct kowhai_walk_stack_t *stack)
+{
+    struct serialize_walk_t *walk = (struct serialize_walk_t*)param;
+    return serialize_tree_nodes(walk->dst, walk->dst_len, walk->desc, walk->tables, walk->tree.data, walk->path, walk->path_len, walk->get_name_param, walk->get_name, stack);
+}
+
+// run serialize_tree_nodes with a stack deep enough for desc
+static int serialize_tree_nodes_default(char *dst, int *dst_len, struct kowhai_node_t *desc, const struct kowhai_node_tables_t *tables, void *data, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name)
+{
+    struct serialize_walk_t walk;
+    walk.tree.data = data;
+    walk.desc = desc;
+    walk.tables = tables;
+    walk.dst = dst;
+    walk.dst_len = dst_len;
+    walk.path = path;
+    walk.path_len = path_len;
+    walk.get_name_param = get_name_param;
+    walk.get_name = get_name;
+    return kowhai_walk_default(kowhai_get_node_depth(desc), serialize_nodes_walk, &walk);
+}
+
+int kowhai_serialize_nodes(char *dst, int *dst_len, struct kowhai_tree_t *src_tree, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name)
+{
+    return serialize_tree_nodes_default(dst, dst_len, src_tree->desc, NULL, src_tree->data, path, path_len, get_name_param, get_name);
+}
+
+int kowhai_serialize_nodes_ex(char *dst, int *dst_len, struct kowhai_tree_t *src_tree, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name, struct kowhai_walk_stack_t *stack)
+{
+    return serialize_tree_nodes(dst, dst_len, src_tree->desc, NULL, src_tree->data, path, path_len, get_name_param, get_name, stack);
+}
+
+int kowhai_flat_serialize_nodes(char *dst, int *dst_len, const struct kowhai_flat_desc_t *flat, void *data, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name)
+{
+    return serialize_tree_nodes_default(dst, dst_len, (struct kowhai_node_t*)flat->tables.desc, &flat->tables, data, path, path_len, get_name_param, get_name);
+}
+
 static int copy_string_from_token(const char* js, jsmntok_t* tok, char* dest, int dest_size)
 {
     int token_string_size = tok->end - tok->start;
@@ -957,6 +1169,18 @@ static int get_token_uint32(jsmn_parser* parser, jsmntok_t* tok, uint32_t* value
         return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
 }
 
+static int get_token_count(jsmn_parser* parser, jsmntok_t* tok, kowhai_count_t* value)
+{
+    char temp[TEMP_SIZE];
+    if (copy_string_from_token(parser->js, tok, temp, TEMP_SIZE))
+    {
+        *value = (kowhai_count_t)atol(temp);
+        return KOW_STATUS_OK;
+    }
+    else
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+}
+
 static int get_token_float(jsmn_parser* parser, jsmntok_t* tok, float* value)
 {
     char temp[TEMP_SIZE];
@@ -1043,7 +1267,7 @@ static int process_tree_token(jsmn_parser* parser, int token_index, struct kowha
                 }
                 else if (token_string_match(parser, tok, COUNT))
                 {
-                    res = get_token_uint16(parser, tok + 1, &desc->count);
+                    res = get_token_count(parser, tok + 1, &desc->count);
                     if (res != KOW_STATUS_OK)
                         return -1;
                     INC;
@@ -1267,7 +1491,7 @@ static int process_nodes_token(jsmn_parser *parser, int src_size, struct kowhai_
     int t = 0;
     jsmntok_t *path_tok = NULL;
     uint16_t type = KOW_BRANCH_START;
-    uint16_t count = 0;
+    kowhai_count_t count = 0;
     uint16_t tag = 0;
 
     while (t < parser->num_tokens)
@@ -1307,7 +1531,7 @@ static int process_nodes_token(jsmn_parser *parser, int src_size, struct kowhai_
         // if this is a count token then store the count
         if (token_string_match(parser, tok, COUNT))
         {
-            res = get_token_uint16(parser, tok + 1, &count);
+            res = get_token_count(parser, tok + 1, &count);
             if (res != KOW_STATUS_OK)
                 return -1;
             t++;
@@ -2,6 +2,8 @@
 #define _KOWHAI_SERIALIZE_H_
 
 #include "kowhai.h"
+#include "kowhai_flat.h"
+#include "kowhai_query.h"
 
 /**
  * @brief callback used to convert a kowhai symbol id to its string representation
@@ -39,6 +41,19 @@ typedef int (*kowhai_node_not_found_t)(void* param, union kowhai_symbol_t *path,
  */
 int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbol_t *path, int *path_len, void *get_name_param, kowhai_get_symbol_t get_name);
 
+/**
+ * @brief convert a query string into a kowhai_query_symbol_t array (see kowhai_query_compile)
+ * @param path_str query string to convert, this is the same as kowhai_str_to_path but the array index may also be
+ * '[*]' for all items or a slice such as '[2:5]' (items 2, 3 and 4), '[2:]' or '[:5]'
+ * @param path_strlen number of chars in the above string
+ * @param query destination populated with kowhai_query_symbol_t to make the query path
+ * @param query_len size of query (number of kowhai_query_symbol_t allocated), updated on KOW_STATUS_OK to the number of symbols populated
+ * @param get_name_param passed to the callback below
+ * @param get_name called supplied callback, given a symbol string it returns the symbol ID
+ * @return standard kowhai returns (ie KOW_STATUS_OK on success, else error)
+ */
+int kowhai_str_to_query(const char *path_str, int path_strlen, struct kowhai_query_symbol_t *query, int *query_len, void *get_name_param, kowhai_get_symbol_t get_name);
+
 /**
  * Convert a kowhai tree to a json ascii string
  *
@@ -51,6 +66,17 @@ int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbo
  */
 int kowhai_serialize_tree(struct kowhai_tree_t tree, char* target_buffer, int* target_size, void* get_name_param, kowhai_get_symbol_name_t get_name);
 
+/**
+ * Same as kowhai_serialize_tree but uses a caller supplied walk stack
+ * @param tree, the tree to serialize
+ * @param target_buffer, the buffer to write the serialized tree to
+ * @param target_size, the size of target_buffer (returns the number of characters written on success)
+ * @param get_name_param argument for get_name
+ * @param get_name called to convert a symbol value to string
+ * @param stack, frames for the walk (KOW_STATUS_STACK_TOO_SMALL is returned if the tree is too deep)
+ */
+int kowhai_serialize_tree_ex(struct kowhai_tree_t tree, char* target_buffer, int* target_size, void* get_name_param, kowhai_get_symbol_name_t get_name, struct kowhai_walk_stack_t *stack);
+
 /**
  * Serialize all the nodes in a tree to a jason ascii string format
  * This differs from kowhai_serialize_tree in that it cannot create a new tree when de-serialized, 
@@ -65,6 +91,32 @@ int kowhai_serialize_tree(struct kowhai_tree_t tree, char* target_buffer, int* t
  */
 int kowhai_serialize_nodes(char *dst, int *dst_len, struct kowhai_tree_t *src_tree, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name);
 
+/**
+ * Same as kowhai_serialize_nodes but uses a caller supplied walk stack
+ * @param dst, put the serialized jason string here
+ * @param dst_len, size of dst in characters
+ * @param src_tree, tree to serialize
+ * @param path, working buffer to store the running path in (must be large enough to encode the whole tree)
+ * @param path_len, size of above path (if too small to encode the whole tree this will fail)
+ * @param get_name_param argument for above callback
+ * @param get_name called to convert path value to string
+ * @param stack, frames for the walk (KOW_STATUS_STACK_TOO_SMALL is returned if the tree is too deep)
+ */
+int kowhai_serialize_nodes_ex(char *dst, int *dst_len, struct kowhai_tree_t *src_tree, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name, struct kowhai_walk_stack_t *stack);
+
+/**
+ * Same as kowhai_serialize_nodes but takes node sizes and skip counts from a flat descriptor (see kowhai_flat_init)
+ * @param dst, put the serialized jason string here
+ * @param dst_len, size of dst in characters
+ * @param flat, flat descriptor of the tree to serialize
+ * @param data, data of the tree to serialize
+ * @param path, working buffer to store the running path in (must be large enough to encode the whole tree)
+ * @param path_len, size of above path (if too small to encode the whole tree this will fail)
+ * @param get_name_param argument for above callback
+ * @param get_name called to convert path value to string
+ */
+int kowhai_flat_serialize_nodes(char *dst, int *dst_len, const struct kowhai_flat_desc_t *flat, void *data, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name);
+
 /**
  * Convert a json ascii string to a kowhai tree
  *
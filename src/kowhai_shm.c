@@ -0,0 +1,153 @@
+#include "kowhai_shm.h"
+#include "kowhai_barrier.h"
+
+#include <string.h>
+
+#define ALIGN(x) (((x) + KOWHAI_SHM_ALIGN - 1) & ~(KOWHAI_SHM_ALIGN - 1))
+
+#ifdef KOWHAI_WIDE_NODES
+#define NODE_FLAGS KOWHAI_SHM_FLAG_WIDE_NODES
+#else
+#define NODE_FLAGS 0
+#endif
+
+// work out where each section of the segment goes
+static int init_header(struct kowhai_shm_header_t *header, const struct kowhai_node_t *desc, int num_locks)
+{
+    int num_nodes, data_size, status;
+
+    status = kowhai_get_node_count(desc, &num_nodes);
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = kowhai_get_node_size(desc, &data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (num_locks < 1)
+        return KOW_STATUS_BUFFER_INVALID;
+
+    memset(header, 0, sizeof(*header));
+    header->magic = KOWHAI_SHM_MAGIC;
+    header->version = KOWHAI_SHM_VERSION;
+    header->flags = NODE_FLAGS;
+    header->locks_offset = ALIGN(sizeof(struct kowhai_shm_header_t));
+    header->num_locks = num_locks;
+    header->desc_offset = ALIGN(header->locks_offset + num_locks * sizeof(struct kowhai_seqlock_t));
+    header->desc_size = num_nodes * sizeof(struct kowhai_node_t);
+    header->data_offset = ALIGN(header->desc_offset + header->desc_size);
+    header->data_size = data_size;
+    header->segment_size = header->data_offset + header->data_size;
+    return KOW_STATUS_OK;
+}
+
+// point the tree and locks at the sections of the segment
+static void init_shm(struct kowhai_shm_t *shm, struct kowhai_shm_header_t *header)
+{
+    char *base = (char*)header;
+    shm->header = header;
+    kowhai_tree_init(&shm->tree, (struct kowhai_node_t*)(base + header->desc_offset), base + header->data_offset);
+    shm->locks.locks = (struct kowhai_seqlock_t*)(base + header->locks_offset);
+    shm->locks.num_locks = header->num_locks;
+}
+
+int kowhai_shm_get_size(const struct kowhai_node_t *desc, int num_locks, int *size)
+{
+    struct kowhai_shm_header_t header;
+    int status = init_header(&header, desc, num_locks);
+    if (status != KOW_STATUS_OK)
+        return status;
+    *size = header.segment_size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_shm_create(void* segment, int segment_size, const struct kowhai_tree_t *tree, int num_locks, struct kowhai_shm_t *shm)
+{
+    struct kowhai_shm_header_t *header = (struct kowhai_shm_header_t*)segment;
+    struct kowhai_shm_header_t layout;
+    int status;
+
+    status = init_header(&layout, tree->desc, num_locks);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (segment_size < (int)layout.segment_size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+
+    // readers that attach while the segment is being laid out see no magic
+    header->magic = 0;
+    KOWHAI_BARRIER();
+    memset((char*)segment + sizeof(header->magic), 0, layout.data_offset - sizeof(header->magic));
+    memcpy((char*)segment + sizeof(header->magic), (char*)&layout + sizeof(layout.magic), sizeof(layout) - sizeof(layout.magic));
+    memcpy((char*)segment + layout.desc_offset, tree->desc, layout.desc_size);
+    memcpy((char*)segment + layout.data_offset, tree->data, layout.data_size);
+    init_shm(shm, header);
+    status = kowhai_seqlock_init(&shm->locks, shm->tree.desc, shm->locks.locks, num_locks);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    // publish the segment
+    KOWHAI_BARRIER();
+    header->magic = KOWHAI_SHM_MAGIC;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_shm_attach(void* segment, int segment_size, struct kowhai_shm_t *shm)
+{
+    struct kowhai_shm_header_t *header = (struct kowhai_shm_header_t*)segment;
+    struct kowhai_shm_header_t layout;
+    struct kowhai_shm_t attached;
+    int i, status;
+
+    if (segment_size < (int)sizeof(struct kowhai_shm_header_t))
+        return KOW_STATUS_BUFFER_INVALID;
+    if (header->magic != KOWHAI_SHM_MAGIC)
+        return KOW_STATUS_NOT_FOUND;
+    KOWHAI_BARRIER();
+    if (header->version != KOWHAI_SHM_VERSION || header->flags != NODE_FLAGS)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    if (header->segment_size > (uint32_t)segment_size ||
+        header->desc_offset > header->segment_size || header->desc_size > header->segment_size - header->desc_offset ||
+        header->desc_size < sizeof(struct kowhai_node_t) || header->desc_size % sizeof(struct kowhai_node_t) != 0 ||
+        header->num_locks < 1 || header->num_locks > header->segment_size / sizeof(struct kowhai_seqlock_t))
+        return KOW_STATUS_BUFFER_INVALID;
+
+    // the descriptor is checked inside its section before it is walked, then the rest of the header must
+    // match the layout of the descriptor it describes
+    init_shm(&attached, header);
+    status = kowhai_check_descriptor(attached.tree.desc, header->desc_size / sizeof(struct kowhai_node_t));
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = init_header(&layout, attached.tree.desc, header->num_locks);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (memcmp(header, &layout, sizeof(layout)) != 0)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    for (i = 0; i < attached.locks.num_locks; i++)
+    {
+        int32_t start = i > 0 ? attached.locks.locks[i - 1].end : 0;
+        if (attached.locks.locks[i].end < start)
+            return KOW_STATUS_BUFFER_INVALID;
+    }
+    if (attached.locks.locks[attached.locks.num_locks - 1].end != (int32_t)header->data_size)
+        return KOW_STATUS_BUFFER_INVALID;
+
+    *shm = attached;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_shm_publish(struct kowhai_shm_t *shm, const void* data, int offset, int size)
+{
+    if (offset < 0 || size < 0 || size > (int)shm->header->data_size - offset)
+        return KOW_STATUS_INVALID_OFFSET;
+    kowhai_seqlock_write_begin(&shm->locks, offset, size);
+    memcpy((char*)shm->tree.data + offset, (const char*)data + offset, size);
+    kowhai_seqlock_write_end(&shm->locks, offset, size);
+    return KOW_STATUS_OK;
+}
+
+uint32_t kowhai_shm_get_version(const struct kowhai_shm_t *shm)
+{
+    uint32_t sum = 0;
+    int i;
+    for (i = 0; i < shm->locks.num_locks; i++)
+        sum += shm->locks.locks[i].sequence;
+    return sum;
+}
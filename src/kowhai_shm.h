@@ -0,0 +1,92 @@
+#ifndef _KOWHAI_SHM_H_
+#define _KOWHAI_SHM_H_
+
+#include "kowhai.h"
+#include "kowhai_seqlock.h"
+
+/**
+ * @brief a tree hosted in shared memory is a header followed by the sequence locks, the descriptor and the tree data
+ * One process creates the segment and writes the tree data under the sequence locks, any number of processes attach
+ * to it (eg mapped read only) and read it with kowhai_seqlock_read without any copying or protocol round trips.
+ * This module only lays out memory the caller has mapped, see tools/shm.h for mapping a named POSIX segment.
+ */
+#define KOWHAI_SHM_MAGIC                0x534F574B  ///< "KOWS"
+#define KOWHAI_SHM_VERSION              1
+#define KOWHAI_SHM_ALIGN                8
+#define KOWHAI_SHM_FLAG_WIDE_NODES      0x0001      ///< the descriptor uses the KOWHAI_WIDE_NODES node format
+
+/**
+ * @brief the header at the start of a shared memory segment (offsets are from the start of the segment)
+ */
+struct kowhai_shm_header_t
+{
+    uint32_t magic;             ///< KOWHAI_SHM_MAGIC, written last so a segment is not attached before it is complete
+    uint16_t version;           ///< KOWHAI_SHM_VERSION
+    uint16_t flags;             ///< KOWHAI_SHM_FLAG_xxx
+    uint32_t segment_size;      ///< number of bytes in the whole segment
+    uint32_t locks_offset;      ///< offset of the sequence locks
+    uint32_t num_locks;         ///< number of sequence locks (see kowhai_seqlock_init)
+    uint32_t desc_offset;       ///< offset of the descriptor nodes
+    uint32_t desc_size;         ///< number of bytes of descriptor nodes
+    uint32_t data_offset;       ///< offset of the tree data
+    uint32_t data_size;         ///< number of bytes of tree data
+};
+
+/**
+ * @brief a tree in a shared memory segment
+ */
+struct kowhai_shm_t
+{
+    struct kowhai_shm_header_t *header; ///< the start of the segment
+    struct kowhai_tree_t tree;          ///< the tree in the segment (it has no dirty bitmap or snapshot)
+    struct kowhai_seqlock_set_t locks;  ///< the sequence locks in the segment
+};
+
+/**
+ * @brief get the number of bytes needed for the shared memory segment of a tree
+ * @param desc, the tree descriptor
+ * @param num_locks, number of sequence locks (see kowhai_seqlock_init)
+ * @param size, set to the segment size in bytes
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_shm_get_size(const struct kowhai_node_t *desc, int num_locks, int *size);
+
+/**
+ * @brief lay out a tree in a shared memory segment, copying its descriptor and data
+ * After this the tree data must only be changed with kowhai_seqlock_write or kowhai_shm_publish
+ * @param segment, the mapped segment (this should be KOWHAI_SHM_ALIGN aligned)
+ * @param segment_size, number of bytes in segment
+ * @param tree, the tree to host
+ * @param num_locks, 1 to lock the whole tree with a single lock or the count from kowhai_seqlock_get_branch_count
+ * @param shm, set to the tree in the segment
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_shm_create(void* segment, int segment_size, const struct kowhai_tree_t *tree, int num_locks, struct kowhai_shm_t *shm);
+
+/**
+ * @brief check a shared memory segment and make a tree that uses the descriptor and data in place
+ * @param segment, the mapped segment, it must remain mapped for the life of the tree
+ * @param segment_size, number of bytes in segment
+ * @param shm, set to the tree in the segment
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error (KOW_STATUS_NOT_FOUND if the segment is not ready yet)
+ */
+int kowhai_shm_attach(void* segment, int segment_size, struct kowhai_shm_t *shm);
+
+/**
+ * @brief copy a range of tree data into the segment under the sequence locks (eg the ranges found by kowhai_dirty_next)
+ * @param shm, the tree in the segment
+ * @param data, tree data with the same descriptor as the segment
+ * @param offset, offset of the first byte to copy
+ * @param size, number of bytes to copy
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_shm_publish(struct kowhai_shm_t *shm, const void* data, int offset, int size);
+
+/**
+ * @brief get a value that changes whenever the tree data in the segment is written (readers can poll this instead of reading the tree)
+ * @param shm, the tree in the segment
+ * @return the sum of the lock sequences
+ */
+uint32_t kowhai_shm_get_version(const struct kowhai_shm_t *shm);
+
+#endif
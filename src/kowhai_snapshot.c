@@ -0,0 +1,148 @@
+#include "kowhai_snapshot.h"
+#include "kowhai_barrier.h"
+
+#include <string.h>
+
+#define SHARED_PAGE -1
+
+int kowhai_snapshot_get_page_count(const struct kowhai_node_t *desc, int page_size, int *num_pages)
+{
+    int size;
+    int status;
+    if (page_size < 1)
+        return KOW_STATUS_BUFFER_INVALID;
+    status = kowhai_get_node_size(desc, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    *num_pages = (size + page_size - 1) / page_size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_snapshot_create(struct kowhai_snapshot_t *snapshot, struct kowhai_tree_t *tree, int page_size, int16_t *page_map, int num_pages, uint8_t *pool, int pool_size)
+{
+    int needed_pages, i;
+    int status = kowhai_snapshot_get_page_count(tree->desc, page_size, &needed_pages);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (num_pages < needed_pages)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    // pool pages are indexed by the 16 bit page map
+    if (pool_size / page_size > 0x7FFF)
+        return KOW_STATUS_BUFFER_INVALID;
+
+    status = kowhai_get_node_size(tree->desc, &snapshot->size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    snapshot->tree = tree;
+    snapshot->page_size = page_size;
+    snapshot->num_pages = needed_pages;
+    snapshot->page_map = page_map;
+    snapshot->pool = pool;
+    snapshot->pool_pages = pool_size / page_size;
+    snapshot->pool_used = 0;
+    snapshot->status = KOW_STATUS_OK;
+    for (i = 0; i < needed_pages; i++)
+        page_map[i] = SHARED_PAGE;
+    tree->snapshot = snapshot;
+    return KOW_STATUS_OK;
+}
+
+void kowhai_snapshot_release(struct kowhai_snapshot_t *snapshot)
+{
+    if (snapshot->tree->snapshot == snapshot)
+        snapshot->tree->snapshot = NULL;
+}
+
+// number of bytes in a page (the last page may be short)
+static int page_bytes(const struct kowhai_snapshot_t *snapshot, int page)
+{
+    int start = page * snapshot->page_size;
+    if (start + snapshot->page_size > snapshot->size)
+        return snapshot->size - start;
+    return snapshot->page_size;
+}
+
+void kowhai_snapshot_preserve(struct kowhai_snapshot_t *snapshot, int offset, int size)
+{
+    int page, last;
+
+    if (size <= 0 || offset < 0)
+        return;
+    page = offset / snapshot->page_size;
+    last = (offset + size - 1) / snapshot->page_size;
+    if (last >= snapshot->num_pages)
+        last = snapshot->num_pages - 1;
+
+    for (; page <= last; page++)
+    {
+        if (snapshot->page_map[page] != SHARED_PAGE)
+            continue;
+        if (snapshot->pool_used >= snapshot->pool_pages)
+        {
+            // the write goes ahead regardless, the snapshot is just no longer valid
+            snapshot->status = KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            KOWHAI_BARRIER();
+            return;
+        }
+        memcpy(snapshot->pool + snapshot->pool_used * snapshot->page_size,
+            (char*)snapshot->tree->data + page * snapshot->page_size, page_bytes(snapshot, page));
+        // publish the copy before the page map points at it, and the page map before the caller writes the page
+        KOWHAI_BARRIER();
+        ((volatile int16_t*)snapshot->page_map)[page] = (int16_t)snapshot->pool_used++;
+        KOWHAI_BARRIER();
+    }
+}
+
+int kowhai_snapshot_read(const struct kowhai_snapshot_t *snapshot, int offset, void* result, int size)
+{
+    char *dst = (char*)result;
+
+    if (snapshot->status != KOW_STATUS_OK)
+        return snapshot->status;
+    if (offset < 0 || size < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+    if (offset + size > snapshot->size)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+
+    // copy page by page from either the pool or the live data
+    while (size > 0)
+    {
+        int page = offset / snapshot->page_size;
+        int page_offset = offset - page * snapshot->page_size;
+        int copy_size = snapshot->page_size - page_offset;
+        int16_t pool_page;
+        if (copy_size > size)
+            copy_size = size;
+        pool_page = ((volatile int16_t*)snapshot->page_map)[page];
+        KOWHAI_BARRIER();
+        if (pool_page == SHARED_PAGE)
+        {
+            memcpy(dst, (const uint8_t*)snapshot->tree->data + offset, copy_size);
+            // a writer on another thread may have preserved the page and started changing it during the copy,
+            // if so the page it preserved first holds the snapshot data
+            KOWHAI_BARRIER();
+            pool_page = ((volatile int16_t*)snapshot->page_map)[page];
+        }
+        if (pool_page != SHARED_PAGE)
+            memcpy(dst, snapshot->pool + pool_page * snapshot->page_size + page_offset, copy_size);
+        dst += copy_size;
+        offset += copy_size;
+        size -= copy_size;
+    }
+
+    // a page that could not be preserved may have changed during the copy
+    KOWHAI_BARRIER();
+    return snapshot->status;
+}
+
+int kowhai_snapshot_get_tree(const struct kowhai_snapshot_t *snapshot, void* buffer, int buffer_size, struct kowhai_tree_t *tree)
+{
+    int status;
+    if (buffer_size < snapshot->size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    status = kowhai_snapshot_read(snapshot, 0, buffer, snapshot->size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    kowhai_tree_init(tree, snapshot->tree->desc, buffer);
+    return KOW_STATUS_OK;
+}
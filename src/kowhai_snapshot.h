@@ -0,0 +1,87 @@
+#ifndef _KOWHAI_SNAPSHOT_H_
+#define _KOWHAI_SNAPSHOT_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief a copy on write point in time view of the data of a tree
+ * Pages of tree data are shared with the live tree until the first write to them after the snapshot was taken,
+ * the write then copies the old page into the snapshot pool (see kowhai_snapshot_preserve) before changing it
+ */
+struct kowhai_snapshot_t
+{
+    struct kowhai_tree_t *tree;     ///< the live tree
+    int size;                       ///< size of the tree data in bytes
+    int page_size;                  ///< number of bytes in a page
+    int num_pages;                  ///< number of pages of tree data
+    int16_t *page_map;              ///< for each page of tree data the pool page holding its snapshot copy, or -1 if it is still shared (supplied by the caller)
+    uint8_t *pool;                  ///< storage for copied pages (supplied by the caller)
+    int pool_pages;                 ///< number of pages the pool holds
+    int pool_used;                  ///< number of pool pages used
+    int status;                     ///< KOW_STATUS_OK or KOW_STATUS_TARGET_BUFFER_TOO_SMALL if the pool overflowed and the snapshot is no longer consistent
+};
+
+/**
+ * @brief get the number of pages a snapshot of a tree has (the number of items in the page map)
+ * @param desc, the tree descriptor
+ * @param page_size, number of bytes in a page
+ * @param num_pages, set to the number of pages
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_snapshot_get_page_count(const struct kowhai_node_t *desc, int page_size, int *num_pages);
+
+/**
+ * @brief take a snapshot of a tree, no tree data is copied (sets tree->snapshot, only one snapshot per tree)
+ * The pool must hold a page for each page written while the snapshot is alive (up to num_pages for any pattern of writes)
+ * @param snapshot, the snapshot to initialise
+ * @param tree, the tree to snapshot
+ * @param page_size, number of bytes in a page
+ * @param page_map, storage for the page map
+ * @param num_pages, number of items in page_map (see kowhai_snapshot_get_page_count)
+ * @param pool, storage for copied pages
+ * @param pool_size, number of bytes in pool
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_snapshot_create(struct kowhai_snapshot_t *snapshot, struct kowhai_tree_t *tree, int page_size, int16_t *page_map, int num_pages, uint8_t *pool, int pool_size);
+
+/**
+ * @brief release a snapshot, the tree stops copying pages for it
+ * @param snapshot, the snapshot to release
+ */
+void kowhai_snapshot_release(struct kowhai_snapshot_t *snapshot);
+
+/**
+ * @brief copy the pages a range of tree data covers into the snapshot before the live tree changes them
+ * This is called by kowhai_write, kowhai_set_xxx etc, code that writes tree data directly must call it first
+ * @param snapshot, the snapshot
+ * @param offset, number of bytes from the start of the tree data to the first byte about to be written
+ * @param size, number of bytes about to be written
+ */
+void kowhai_snapshot_preserve(struct kowhai_snapshot_t *snapshot, int offset, int size);
+
+/**
+ * @brief read from the tree data as it was when the snapshot was taken
+ * This can run on another thread to a single writer of the live tree, each page is read from the live data and
+ * read again from the pool if the writer preserved it during the read
+ * @param snapshot, the snapshot
+ * @param offset, number of bytes from the start of the tree data to read from
+ * @param result, the buffer to read into
+ * @param size, number of bytes to read
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_snapshot_read(const struct kowhai_snapshot_t *snapshot, int offset, void* result, int size);
+
+/**
+ * @brief copy the snapshot data into a buffer and make a tree of it (for kowhai_serialize_nodes, kowhai_diff etc)
+ * This is a full copy of the tree data, the walkers read tree data directly rather than through the page map. The
+ * trade off is that the copy is made by the reader at leisure, writers to the live tree only pay for the pages they
+ * touch. Use kowhai_snapshot_read for parts of the tree to avoid the full copy.
+ * @param snapshot, the snapshot
+ * @param buffer, storage for the snapshot data (this must be as large as the tree data)
+ * @param buffer_size, number of bytes in buffer
+ * @param tree, set to the snapshot tree (its desc is the live tree desc, it has no dirty bitmap or snapshot)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_snapshot_get_tree(const struct kowhai_snapshot_t *snapshot, void* buffer, int buffer_size, struct kowhai_tree_t *tree);
+
+#endif
@@ -0,0 +1,189 @@
+#include "kowhai_subscribe.h"
+
+#include <stddef.h>
+
+int kowhai_subscriptions_init(struct kowhai_subscriptions_t *subscriptions, struct kowhai_tree_t *tree, struct kowhai_dirty_t *dirty, struct kowhai_subscription_t *subs, int max_subs, uint32_t window)
+{
+    int status;
+
+    if (tree->dirty == NULL || max_subs < 0)
+        return KOW_STATUS_BUFFER_INVALID;
+    if (dirty == NULL)
+        dirty = tree->dirty;
+    status = kowhai_dirty_chain(tree->dirty, dirty);
+    if (status != KOW_STATUS_OK)
+        return status;
+    subscriptions->tree = tree;
+    subscriptions->dirty = dirty;
+    subscriptions->subs = subs;
+    subscriptions->max_subs = max_subs;
+    subscriptions->num_subs = 0;
+    subscriptions->watch_start = 0;
+    subscriptions->watch_end = 0;
+    subscriptions->window = window;
+    subscriptions->pending_since = 0;
+    subscriptions->pending = 0;
+    return KOW_STATUS_OK;
+}
+
+// recalculate the range of tree data covered by any subscription
+static void update_watch_range(struct kowhai_subscriptions_t *subscriptions)
+{
+    int i;
+    subscriptions->watch_start = 0;
+    subscriptions->watch_end = 0;
+    for (i = 0; i < subscriptions->num_subs; i++)
+    {
+        struct kowhai_subscription_t *sub = &subscriptions->subs[i];
+        if (sub->on_change == NULL)
+            continue;
+        if (subscriptions->watch_end == 0 || sub->offset < subscriptions->watch_start)
+            subscriptions->watch_start = sub->offset;
+        if (sub->offset + sub->size > subscriptions->watch_end)
+            subscriptions->watch_end = sub->offset + sub->size;
+    }
+}
+
+int kowhai_subscribe_range(struct kowhai_subscriptions_t *subscriptions, int offset, int size, kowhai_on_change_t on_change, void* param, int *id)
+{
+    struct kowhai_subscription_t *sub;
+    int i;
+
+    if (on_change == NULL || offset < 0 || size <= 0)
+        return KOW_STATUS_BUFFER_INVALID;
+    if (offset + size > subscriptions->dirty->size)
+        return KOW_STATUS_INVALID_OFFSET;
+
+    // reuse the first free slot
+    for (i = 0; i < subscriptions->num_subs; i++)
+        if (subscriptions->subs[i].on_change == NULL)
+            break;
+    if (i == subscriptions->max_subs)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    if (i == subscriptions->num_subs)
+        subscriptions->num_subs++;
+
+    sub = &subscriptions->subs[i];
+    sub->offset = offset;
+    sub->size = size;
+    sub->on_change = on_change;
+    sub->param = param;
+    sub->changed_start = 0;
+    sub->changed_end = 0;
+    update_watch_range(subscriptions);
+    *id = i;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_subscribe(struct kowhai_subscriptions_t *subscriptions, int num_symbols, union kowhai_symbol_t* symbols, kowhai_on_change_t on_change, void* param, int *id)
+{
+    struct kowhai_node_t *node;
+    int offset, size;
+    int status;
+
+    if (num_symbols < 1)
+        return KOW_STATUS_BUFFER_INVALID;
+    status = kowhai_get_node(subscriptions->tree->desc, num_symbols, symbols, &offset, &node);
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = kowhai_get_node_size(node, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (node->count == 0)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+
+    // cover from the selected array item to the end of the array
+    size -= (size / node->count) * symbols[num_symbols - 1].parts.array_index;
+    return kowhai_subscribe_range(subscriptions, offset, size, on_change, param, id);
+}
+
+int kowhai_unsubscribe(struct kowhai_subscriptions_t *subscriptions, int id)
+{
+    if (id < 0 || id >= subscriptions->num_subs || subscriptions->subs[id].on_change == NULL)
+        return KOW_STATUS_NOT_FOUND;
+    subscriptions->subs[id].on_change = NULL;
+    // trim unused slots off the end
+    while (subscriptions->num_subs > 0 && subscriptions->subs[subscriptions->num_subs - 1].on_change == NULL)
+        subscriptions->num_subs--;
+    update_watch_range(subscriptions);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_subscriptions_watched(const struct kowhai_subscriptions_t *subscriptions, int offset, int size)
+{
+    int i;
+
+    if (offset >= subscriptions->watch_end || offset + size <= subscriptions->watch_start)
+        return 0;
+    for (i = 0; i < subscriptions->num_subs; i++)
+    {
+        const struct kowhai_subscription_t *sub = &subscriptions->subs[i];
+        if (sub->on_change != NULL && offset < sub->offset + sub->size && offset + size > sub->offset)
+            return 1;
+    }
+    return 0;
+}
+
+int kowhai_subscriptions_flush(struct kowhai_subscriptions_t *subscriptions)
+{
+    struct kowhai_dirty_t *dirty = subscriptions->dirty;
+    int offset = subscriptions->watch_start, size = 0;
+    int i;
+
+    subscriptions->pending = 0;
+
+    // collect the changed extent of each subscription over the dirty ranges that are subscribed to, clearing each
+    // range before calling back so writes made meanwhile (or by the callbacks) are dispatched next time
+    while (kowhai_dirty_next(dirty, offset + size, &offset, &size) == KOW_STATUS_OK)
+    {
+        if (offset >= subscriptions->watch_end)
+            break;
+        if (offset + size > subscriptions->watch_end)
+            size = subscriptions->watch_end - offset;
+        kowhai_dirty_clear(dirty, offset, size);
+        for (i = 0; i < subscriptions->num_subs; i++)
+        {
+            struct kowhai_subscription_t *sub = &subscriptions->subs[i];
+            int start = offset > sub->offset ? offset : sub->offset;
+            int end = offset + size < sub->offset + sub->size ? offset + size : sub->offset + sub->size;
+            if (sub->on_change == NULL || start >= end)
+                continue;
+            if (sub->changed_end == 0)
+                sub->changed_start = start;
+            sub->changed_end = end;
+        }
+    }
+
+    for (i = 0; i < subscriptions->num_subs; i++)
+    {
+        struct kowhai_subscription_t *sub = &subscriptions->subs[i];
+        int start = sub->changed_start;
+        int end = sub->changed_end;
+        if (end == 0)
+            continue;
+        sub->changed_end = 0;
+        // on_change may unsubscribe (itself or others) so it is checked again here
+        if (sub->on_change != NULL)
+            sub->on_change(sub->param, subscriptions->tree, start, end - start);
+    }
+
+    return KOW_STATUS_OK;
+}
+
+int kowhai_subscriptions_poll(struct kowhai_subscriptions_t *subscriptions, uint32_t now)
+{
+    int offset, size;
+
+    if (!subscriptions->pending)
+    {
+        // changes nobody is subscribed to are left for the other consumers of the bitmap
+        if (kowhai_dirty_next(subscriptions->dirty, subscriptions->watch_start, &offset, &size) != KOW_STATUS_OK ||
+            offset >= subscriptions->watch_end)
+            return KOW_STATUS_OK;
+        subscriptions->pending = 1;
+        subscriptions->pending_since = now;
+    }
+    if ((uint32_t)(now - subscriptions->pending_since) < subscriptions->window)
+        return KOW_STATUS_OK;
+    return kowhai_subscriptions_flush(subscriptions);
+}
@@ -0,0 +1,119 @@
+#ifndef _KOWHAI_SUBSCRIBE_H_
+#define _KOWHAI_SUBSCRIBE_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief called when data a subscription covers has changed
+ * @param param, application specific parameter given to kowhai_subscribe
+ * @param tree, the tree that changed
+ * @param offset, number of bytes from the start of the tree data to the first changed byte in the subscription
+ * @param size, number of bytes from the first to the last changed byte in the subscription
+ */
+typedef void (*kowhai_on_change_t)(void* param, struct kowhai_tree_t *tree, int offset, int size);
+
+/**
+ * @brief interest in a range of tree data
+ */
+struct kowhai_subscription_t
+{
+    int32_t offset;                 ///< number of bytes from the start of the tree data to the subscribed data
+    int32_t size;                   ///< number of bytes subscribed to
+    kowhai_on_change_t on_change;   ///< callback, or NULL if this slot is unused
+    void* param;                    ///< parameter passed to on_change
+    int32_t changed_start;          ///< first changed byte found while dispatching
+    int32_t changed_end;            ///< one past the last changed byte found while dispatching (0 if nothing changed)
+};
+
+/**
+ * @brief a registry of subscriptions to a tree
+ * Changes are read from the dirty bitmap of the tree (or one chained to it), so anything that marks it (kowhai_write,
+ * kowhai_set_xxx, the protocol server etc) feeds the subscriptions
+ */
+struct kowhai_subscriptions_t
+{
+    struct kowhai_tree_t *tree;             ///< the subscribed tree (tree->dirty must be set)
+    struct kowhai_dirty_t *dirty;           ///< the dirty bitmap the registry clears as it dispatches (tree->dirty or one chained to it)
+    struct kowhai_subscription_t *subs;     ///< subscription slots (supplied by the caller)
+    int max_subs;                           ///< number of subscription slots
+    int num_subs;                           ///< number of slots in use (including unsubscribed slots before the last used one)
+    int32_t watch_start;                    ///< first byte covered by any subscription
+    int32_t watch_end;                      ///< one past the last byte covered by any subscription (0 if there are none)
+    uint32_t window;                        ///< time to coalesce changes for before dispatching them
+    uint32_t pending_since;                 ///< time the oldest undispatched change was first polled
+    int pending;                            ///< non zero if there are undispatched changes
+};
+
+/**
+ * @brief initialise a subscription registry
+ * @param subscriptions, the registry to initialise
+ * @param tree, the tree to watch (tree->dirty must be set)
+ * @param dirty, the dirty bitmap the registry clears as changes are dispatched, if it is not tree->dirty it is chained to
+ * tree->dirty (see kowhai_dirty_chain) so other consumers (eg a journal) can clear their own bitmap, NULL to use tree->dirty
+ * @param subs, storage for the subscriptions
+ * @param max_subs, number of items in subs
+ * @param window, changes are coalesced for this long before being dispatched (in the units of the time passed to kowhai_subscriptions_poll)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_subscriptions_init(struct kowhai_subscriptions_t *subscriptions, struct kowhai_tree_t *tree, struct kowhai_dirty_t *dirty, struct kowhai_subscription_t *subs, int max_subs, uint32_t window);
+
+/**
+ * @brief subscribe to changes in a node, if it is a branch all the leaves in the subtree are covered
+ * The subscription covers the array item the path selects and all the array items after it
+ * @param subscriptions, the registry
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the node
+ * @param on_change, called with the changes in the node
+ * @param param, application specific parameter passed to on_change
+ * @param id, set to the id of the subscription (for kowhai_unsubscribe)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_subscribe(struct kowhai_subscriptions_t *subscriptions, int num_symbols, union kowhai_symbol_t* symbols, kowhai_on_change_t on_change, void* param, int *id);
+
+/**
+ * @brief subscribe to changes in a range of tree data
+ * @param subscriptions, the registry
+ * @param offset, number of bytes from the start of the tree data to the range
+ * @param size, number of bytes in the range
+ * @param on_change, called with the changes in the range
+ * @param param, application specific parameter passed to on_change
+ * @param id, set to the id of the subscription (for kowhai_unsubscribe)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_subscribe_range(struct kowhai_subscriptions_t *subscriptions, int offset, int size, kowhai_on_change_t on_change, void* param, int *id);
+
+/**
+ * @brief remove a subscription
+ * @param subscriptions, the registry
+ * @param id, the id of the subscription
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_unsubscribe(struct kowhai_subscriptions_t *subscriptions, int id);
+
+/**
+ * @brief test whether any subscription covers a range of tree data (cheap if there are no subscriptions nearby)
+ * @param subscriptions, the registry
+ * @param offset, number of bytes from the start of the tree data to the range
+ * @param size, number of bytes in the range
+ * @return non zero if the range is subscribed to
+ */
+int kowhai_subscriptions_watched(const struct kowhai_subscriptions_t *subscriptions, int offset, int size);
+
+/**
+ * @brief dispatch changes once they are older than the coalescing window
+ * Each subscription gets at most one call per dispatch covering all its changes
+ * @param subscriptions, the registry
+ * @param now, the current time (free running, it may wrap)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_subscriptions_poll(struct kowhai_subscriptions_t *subscriptions, uint32_t now);
+
+/**
+ * @brief dispatch all changes now regardless of the coalescing window
+ * Only the dirty ranges between the first and last subscribed bytes are cleared, each before it is dispatched
+ * @param subscriptions, the registry
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_subscriptions_flush(struct kowhai_subscriptions_t *subscriptions);
+
+#endif
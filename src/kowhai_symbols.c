@@ -0,0 +1,139 @@
+#include "kowhai_symbols.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define HASH_SEED  2166136261u
+#define HASH_PRIME 16777619u
+#define SEED_MULTIPLIER 0x9E3779B9u
+
+// fnv-1a over the chars of the name
+uint32_t kowhai_symbol_table_hash(const char *symbol, int len)
+{
+    uint32_t hash = HASH_SEED;
+    int i;
+    for (i = 0; i < len; i++)
+    {
+        hash ^= (uint8_t)symbol[i];
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+// pick the slot of a name in a minimal perfect hash, this must match symbol_gen.py
+static int perfect_slot(const struct kowhai_symbol_table_t *table, uint32_t hash)
+{
+    uint32_t h = hash ^ (table->seeds[hash % table->slot_count] * SEED_MULTIPLIER);
+    // murmur3 finaliser so every bit of the seed reaches the low bits
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h % table->slot_count;
+}
+
+// check a symbol id really has this name (and not just the same hash)
+static int name_matches(const struct kowhai_symbol_table_t *table, int symbol, const char *name, int len)
+{
+    const char *s = table->names[symbol];
+    return strncmp(s, name, len) == 0 && s[len] == 0;
+}
+
+int kowhai_symbol_table_init(struct kowhai_symbol_table_t *table, char** names, int name_count, struct kowhai_symbol_table_slot_t *slots, int slot_count)
+{
+    int i, s;
+
+    // there must be an empty slot left over to end unsuccessful lookups
+    if (name_count < 0 || slot_count <= name_count)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    if (name_count > 0xFFFF)
+        return KOW_STATUS_BUFFER_INVALID;
+
+    table->names = names;
+    table->name_count = name_count;
+    table->slots = slots;
+    table->slot_count = slot_count;
+    table->seeds = NULL;
+    for (i = 0; i < slot_count; i++)
+        slots[i].symbol = -1;
+
+    for (i = 0; i < name_count; i++)
+    {
+        int len = (int)strlen(names[i]);
+        uint32_t hash = kowhai_symbol_table_hash(names[i], len);
+        // linear probing, a duplicate name keeps the first id
+        for (s = hash % slot_count; slots[s].symbol >= 0; s = (s + 1) % slot_count)
+            if (slots[s].hash == hash && name_matches(table, slots[s].symbol, names[i], len))
+                break;
+        if (slots[s].symbol >= 0)
+            continue;
+        slots[s].hash = hash;
+        slots[s].symbol = i;
+    }
+    return KOW_STATUS_OK;
+}
+
+int kowhai_symbol_table_init_perfect(struct kowhai_symbol_table_t *table, char** names, int name_count, const struct kowhai_symbol_table_slot_t *slots, const uint16_t *seeds)
+{
+    if (name_count < 1 || name_count > 0xFFFF)
+        return KOW_STATUS_BUFFER_INVALID;
+    table->names = names;
+    table->name_count = name_count;
+    table->slots = slots;
+    table->slot_count = name_count;
+    table->seeds = seeds;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_symbol_table_split_list(char* list, int list_size, char** names, int *name_count)
+{
+    int count = 0;
+    int i = 0;
+
+    while (i < list_size)
+    {
+        if (count >= *name_count)
+            return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+        names[count++] = &list[i];
+        while (i < list_size && list[i] != 0)
+            i++;
+        // the last name must be terminated too
+        if (i == list_size)
+            return KOW_STATUS_BUFFER_INVALID;
+        i++;
+    }
+    *name_count = count;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_symbol_table_get_symbol(void* param, const char *symbol, int len)
+{
+    const struct kowhai_symbol_table_t *table = (const struct kowhai_symbol_table_t*)param;
+    uint32_t hash = kowhai_symbol_table_hash(symbol, len);
+    int s;
+
+    // a perfect hash has exactly one candidate
+    if (table->seeds != NULL)
+    {
+        s = perfect_slot(table, hash);
+        if (table->slots[s].hash == hash && name_matches(table, table->slots[s].symbol, symbol, len))
+            return table->slots[s].symbol;
+        return -1;
+    }
+
+    for (s = hash % table->slot_count; table->slots[s].symbol >= 0; s = (s + 1) % table->slot_count)
+    {
+        if (table->slots[s].hash == hash && name_matches(table, table->slots[s].symbol, symbol, len))
+            return table->slots[s].symbol;
+    }
+    return -1;
+}
+
+char* kowhai_symbol_table_get_name(void* param, uint16_t symbol)
+{
+    const struct kowhai_symbol_table_t *table = (const struct kowhai_symbol_table_t*)param;
+    if (symbol >= table->name_count)
+        return NULL;
+    return table->names[symbol];
+}
@@ -0,0 +1,89 @@
+#ifndef _KOWHAI_SYMBOLS_H_
+#define _KOWHAI_SYMBOLS_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief a single slot in a symbol table hash table
+ */
+struct kowhai_symbol_table_slot_t
+{
+    uint32_t hash;              ///< hash of the symbol name
+    int32_t symbol;             ///< the symbol id, or -1 if this slot is empty
+};
+
+/**
+ * @brief maps symbol names to ids (hashed) and ids to names (by array index)
+ * The lookup functions match kowhai_get_symbol_t and kowhai_get_symbol_name_t so a table can be passed
+ * straight to kowhai_str_to_path, kowhai_serialize_tree, kowhai_deserialize_nodes etc as the get_name_param.
+ * The hash table is either built at runtime (kowhai_symbol_table_init) or is a minimal perfect hash generated
+ * by tools/symbol_gen.py (kowhai_symbol_table_init_perfect) which can be const and live in flash
+ */
+struct kowhai_symbol_table_t
+{
+    char** names;                                   ///< symbol names indexed by symbol id (eg the symbols[] array from symbol_gen.py)
+    int name_count;                                 ///< number of items in names
+    const struct kowhai_symbol_table_slot_t *slots; ///< open addressing hash table slots (supplied by the caller)
+    int slot_count;                                 ///< number of slots in the slots table
+    const uint16_t *seeds;                          ///< per bucket seeds of a minimal perfect hash, or NULL if slots is an open addressing table
+};
+
+/**
+ * @brief hash a symbol name, this is the hash used to place names in the symbol table slots
+ * @param symbol, the symbol name (it does not need to be NULL terminated)
+ * @param len, number of chars in symbol
+ * @return the hash value
+ */
+uint32_t kowhai_symbol_table_hash(const char *symbol, int len);
+
+/**
+ * @brief build a symbol table from a list of symbol names
+ * If a name is in the list more than once the first id is used
+ * @param table, the symbol table to initialise
+ * @param names, symbol names indexed by symbol id (this must remain valid for the life of the table)
+ * @param name_count, number of items in names
+ * @param slots, storage for the hash table slots
+ * @param slot_count, number of slots (this must be more than name_count, around twice name_count is a good choice)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_symbol_table_init(struct kowhai_symbol_table_t *table, char** names, int name_count, struct kowhai_symbol_table_slot_t *slots, int slot_count);
+
+/**
+ * @brief use a minimal perfect hash generated by tools/symbol_gen.py as a symbol table (nothing is computed)
+ * @param table, the symbol table to initialise
+ * @param names, symbol names indexed by symbol id (eg symbols)
+ * @param name_count, number of items in names
+ * @param slots, the generated hash table slots, there is one slot for each name (eg symbols_hash_slots)
+ * @param seeds, the generated bucket seeds, there is one seed for each name (eg symbols_hash_seeds)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_symbol_table_init_perfect(struct kowhai_symbol_table_t *table, char** names, int name_count, const struct kowhai_symbol_table_slot_t *slots, const uint16_t *seeds);
+
+/**
+ * @brief split a symbol list received with KOW_CMD_GET_SYMBOL_LIST_ACK (NULL terminated names one after the other) into names for kowhai_symbol_table_init
+ * @param list, the symbol list
+ * @param list_size, number of bytes in list
+ * @param names, set to the start of each name in list
+ * @param name_count, the number of items in names, set to the number of names found
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_symbol_table_split_list(char* list, int list_size, char** names, int *name_count);
+
+/**
+ * @brief find the id of a symbol name (a kowhai_get_symbol_t callback)
+ * @param param, the symbol table
+ * @param symbol, the symbol name (it does not need to be NULL terminated)
+ * @param len, number of chars in symbol
+ * @return the symbol id or -1 if the symbol is not found
+ */
+int kowhai_symbol_table_get_symbol(void* param, const char *symbol, int len);
+
+/**
+ * @brief find the name of a symbol id (a kowhai_get_symbol_name_t callback)
+ * @param param, the symbol table
+ * @param symbol, the symbol id
+ * @return the symbol name or NULL if the symbol id is not in the table
+ */
+char* kowhai_symbol_table_get_name(void* param, uint16_t symbol);
+
+#endif
@@ -0,0 +1,124 @@
+#include "kowhai_transaction.h"
+#include "kowhai_snapshot.h"
+
+#include <string.h>
+
+int kowhai_transaction_begin(struct kowhai_transaction_t *transaction, struct kowhai_tree_t *tree, struct kowhai_transaction_write_t *writes, int max_writes, uint8_t *arena, int arena_size)
+{
+    if (max_writes < 0 || arena_size < 0)
+        return KOW_STATUS_BUFFER_INVALID;
+    transaction->tree = tree;
+    transaction->writes = writes;
+    transaction->max_writes = max_writes;
+    transaction->arena = arena;
+    transaction->arena_size = arena_size;
+    kowhai_transaction_rollback(transaction);
+    return KOW_STATUS_OK;
+}
+
+// stage a write, the first failure is kept so the commit fails too
+static int stage_write(struct kowhai_transaction_t *transaction, int num_symbols, union kowhai_symbol_t* symbols, int write_offset, void* value, int write_size)
+{
+    struct kowhai_transaction_write_t *write;
+    struct kowhai_node_t* node;
+    int offset;
+    int size;
+    int status;
+
+    // validate the write like kowhai_write does
+    status = kowhai_get_node(transaction->tree->desc, num_symbols, symbols, &offset, &node);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (write_offset < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+    status = kowhai_get_node_size(node, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (write_size + write_offset > size)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+
+    // copy the value into the arena
+    if (transaction->num_writes >= transaction->max_writes ||
+        transaction->arena_used + write_size > transaction->arena_size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    write = &transaction->writes[transaction->num_writes++];
+    write->offset = offset + write_offset;
+    write->size = write_size;
+    write->arena_offset = transaction->arena_used;
+    memcpy(transaction->arena + transaction->arena_used, value, write_size);
+    transaction->arena_used += write_size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_transaction_write(struct kowhai_transaction_t *transaction, int num_symbols, union kowhai_symbol_t* symbols, int write_offset, void* value, int write_size)
+{
+    int status = stage_write(transaction, num_symbols, symbols, write_offset, value, write_size);
+    if (status != KOW_STATUS_OK && transaction->status == KOW_STATUS_OK)
+        transaction->status = status;
+    return status;
+}
+
+int kowhai_transaction_commit(struct kowhai_transaction_t *transaction)
+{
+    struct kowhai_tree_t *tree = transaction->tree;
+    struct kowhai_transaction_write_t *writes = transaction->writes;
+    int status = transaction->status;
+    int i, j;
+
+    if (status != KOW_STATUS_OK)
+    {
+        kowhai_transaction_rollback(transaction);
+        return status;
+    }
+
+    // insertion sort by offset, related parameters are usually written nearly in order anyway
+    for (i = 1; i < transaction->num_writes; i++)
+    {
+        struct kowhai_transaction_write_t write = writes[i];
+        for (j = i; j > 0 && writes[j - 1].offset > write.offset; j--)
+            writes[j] = writes[j - 1];
+        writes[j] = write;
+    }
+
+    i = 0;
+    while (i < transaction->num_writes)
+    {
+        // once sorted, writes that overlap are next to each other, each run of overlapping writes is
+        // applied in the order the writes were staged (arena order) so the newest write to any byte wins
+        int end = writes[i].offset + writes[i].size;
+        int run = i + 1;
+        while (run < transaction->num_writes && writes[run].offset < end)
+        {
+            if (writes[run].offset + writes[run].size > end)
+                end = writes[run].offset + writes[run].size;
+            run++;
+        }
+        for (j = i + 1; j < run; j++)
+        {
+            struct kowhai_transaction_write_t write = writes[j];
+            int k;
+            for (k = j; k > i && writes[k - 1].arena_offset > write.arena_offset; k--)
+                writes[k] = writes[k - 1];
+            writes[k] = write;
+        }
+
+        for (; i < run; i++)
+        {
+            if (tree->snapshot != NULL)
+                kowhai_snapshot_preserve(tree->snapshot, writes[i].offset, writes[i].size);
+            memcpy((char*)tree->data + writes[i].offset, transaction->arena + writes[i].arena_offset, writes[i].size);
+            if (tree->dirty != NULL)
+                kowhai_dirty_mark(tree->dirty, writes[i].offset, writes[i].size);
+        }
+    }
+
+    kowhai_transaction_rollback(transaction);
+    return KOW_STATUS_OK;
+}
+
+void kowhai_transaction_rollback(struct kowhai_transaction_t *transaction)
+{
+    transaction->num_writes = 0;
+    transaction->arena_used = 0;
+    transaction->status = KOW_STATUS_OK;
+}
@@ -0,0 +1,70 @@
+#ifndef _KOWHAI_TRANSACTION_H_
+#define _KOWHAI_TRANSACTION_H_
+
+#include "kowhai.h"
+
+/**
+ * @brief a write staged in a transaction
+ */
+struct kowhai_transaction_write_t
+{
+    int32_t offset;             ///< number of bytes from the start of the tree data to write to
+    int32_t size;               ///< number of bytes to write
+    int32_t arena_offset;       ///< number of bytes from the start of the arena to the staged value
+};
+
+/**
+ * @brief a set of writes to a tree that are applied all together or not at all
+ * Writes are validated and copied into the arena as they are made, the tree is not touched until commit
+ */
+struct kowhai_transaction_t
+{
+    struct kowhai_tree_t *tree;                     ///< the tree to write to
+    struct kowhai_transaction_write_t *writes;      ///< staged writes (supplied by the caller)
+    int max_writes;                                 ///< number of items in writes
+    int num_writes;                                 ///< number of writes staged
+    uint8_t *arena;                                 ///< staged values (supplied by the caller)
+    int arena_size;                                 ///< number of bytes in arena
+    int arena_used;                                 ///< number of bytes of the arena used
+    int status;                                     ///< the first error from staging a write, the commit fails if this is not KOW_STATUS_OK
+};
+
+/**
+ * @brief start a transaction
+ * @param transaction, the transaction to initialise
+ * @param tree, the tree to write to
+ * @param writes, storage for the staged writes
+ * @param max_writes, number of items in writes
+ * @param arena, storage for the staged values
+ * @param arena_size, number of bytes in arena
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_transaction_begin(struct kowhai_transaction_t *transaction, struct kowhai_tree_t *tree, struct kowhai_transaction_write_t *writes, int max_writes, uint8_t *arena, int arena_size);
+
+/**
+ * @brief stage a write to a tree (see kowhai_write), if this fails the whole transaction fails to commit
+ * @param transaction, the transaction
+ * @param num_symbols, number of items in the symbols path
+ * @param symbols, the path of the item to write
+ * @param write_offset, offset into the item to write to
+ * @param value, the value to write (copied into the arena)
+ * @param write_size, number of bytes to write
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_transaction_write(struct kowhai_transaction_t *transaction, int num_symbols, union kowhai_symbol_t* symbols, int write_offset, void* value, int write_size);
+
+/**
+ * @brief apply all the staged writes to the tree in offset order (overlapping writes are applied in the order they were made so the newest write wins)
+ * The transaction is empty afterwards and can be reused
+ * @param transaction, the transaction
+ * @return kowhai status value, ie KOW_STATUS_OK on success or the first error from staging a write (nothing is written)
+ */
+int kowhai_transaction_commit(struct kowhai_transaction_t *transaction);
+
+/**
+ * @brief discard all the staged writes, the tree is unchanged and the transaction can be reused
+ * @param transaction, the transaction
+ */
+void kowhai_transaction_rollback(struct kowhai_transaction_t *transaction);
+
+#endif
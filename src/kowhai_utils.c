@@ -1,4 +1,5 @@
 #include "kowhai_utils.h"
+#include "kowhai_snapshot.h"
 
 #include <string.h>
 
@@ -58,17 +59,17 @@ static int compare_simple_node_contents(struct kowhai_tree_t *left, struct kowha
     return KOW_STATUS_OK;
 }
 
-static int increment_tree(struct kowhai_tree_t* tree, int in_union)
+static int increment_tree(struct kowhai_tree_t* tree, int in_union, struct kowhai_walk_stack_t *stack)
 {
     int res, size, count;
     if (!in_union)
     {
-        res = kowhai_get_node_size(tree->desc, &size);
+        res = kowhai_get_node_size_ex(tree->desc, &size, stack);
         if (res != KOW_STATUS_OK)
             return res;
         tree->data = (uint8_t*)tree->data + size;
     }
-    res = kowhai_get_node_count(tree->desc, &count);
+    res = kowhai_get_node_count_ex(tree->desc, &count, stack);
     if (res != KOW_STATUS_OK)
         return res;
     tree->desc = tree->desc + count;
@@ -79,99 +80,159 @@ static int increment_tree(struct kowhai_tree_t* tree, int in_union)
  * @brief diff_l2r diff left tree against right tree
  * If a node is found in the left tree that is not in the right tree (ie symbol path and types/array size match) call on_unique 
  * If a node is found in both left and right tree, but the values of the node items do not match call on_diff
+ * Matching branches are walked into by saving the position in the parent branch on the stack (rather than recursing)
  * @note unique items on the right tree are ignored
  * @param left, diff this tree against right
- * @param left_node_index, the index of the left node in the original descriptor (used in recursive calls, original caller should pass 0)
  * @param right, diff this tree against left
- * @param right_node_index, the index of the right node in the original descriptor (used in recursive calls, original caller should pass 0)
  * @param on_diff_param, application specific parameter passed through the on_diff callback
  * @param on_diff, call this when a unique node in the left tree is found... or a common node is found in both left and right trees and the values do not match
- * @param depth, how deep in the tree are we (0 root, 1 first branch, etc)
+ * @param stack, frames to save the position in each parent branch in (used from stack->depth up)
  */
-static int diff_l2r(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* on_diff_param, kowhai_on_diff_t on_diff, int depth)
+static int diff_l2r(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* on_diff_param, kowhai_on_diff_t on_diff, struct kowhai_walk_stack_t *stack)
 {
-    int ret;
+    int ret, i, left_size, right_size;
+    int base = stack->depth;
+    int depth = 0;
     int in_union = left->desc->type == KOW_BRANCH_U_START;
+    struct kowhai_tree_t right_branch = *right;
     struct kowhai_tree_t left_leafs, right_leafs;
+    struct kowhai_walk_frame_t *frame;
 
     // init left tree (first node to compare at this level)
     left_leafs.desc = left->desc + 1;
     left_leafs.data = left->data;
 
-    while (left_leafs.desc->type != KOW_BRANCH_END)
+    while (1)
     {
-        int found_node_match = 0;
+        // the frames above the current depth are free for the size calculations
+        stack->depth = base + depth;
 
-        // init right tree (compare against left tree at this level)
-        right_leafs.desc = right->desc + 1;
-        right_leafs.data = right->data;
+        if (left_leafs.desc->type == KOW_BRANCH_END)
+        {
+            // all the nodes in this branch array item have been compared
+            if (depth == 0)
+                break;
 
-        while (right_leafs.desc->type != KOW_BRANCH_END)
+            // go back to the parent branch and move on to its next array item
+            depth--;
+            frame = kowhai_walk_stack_frame(stack, base + depth);
+            left_leafs.desc = (struct kowhai_node_t*)frame->node;
+            left_leafs.data = frame->data;
+            right_leafs.desc = (struct kowhai_node_t*)frame->node2;
+            right_leafs.data = frame->data2;
+            i = frame->index + 1;
+            in_union = frame->value[0];
+            left_size = frame->value[1];
+            right_size = frame->value[2];
+            if (depth == 0)
+                right_branch = *right;
+            else
+            {
+                right_branch.desc = (struct kowhai_node_t*)kowhai_walk_stack_frame(stack, base + depth - 1)->node2;
+                right_branch.data = kowhai_walk_stack_frame(stack, base + depth - 1)->data2;
+            }
+            right_leafs.data = (uint8_t*)right_leafs.data + right_size / right_leafs.desc->count;
+            left_leafs.data = (uint8_t*)left_leafs.data + left_size / left_leafs.desc->count;
+        }
+        else
         {
-            if (check_nodes_match(left_leafs.desc, right_leafs.desc))
+            int found_node_match = 0;
+            int node_is_branch = 0;
+
+            // init right tree (compare against left tree at this level)
+            right_leafs.desc = right_branch.desc + 1;
+            right_leafs.data = right_branch.data;
+
+            while (right_leafs.desc->type != KOW_BRANCH_END)
             {
-                // node metadata matches, do data comparison
-                int node_is_union = left_leafs.desc->type == KOW_BRANCH_U_START;
-                int node_is_branch = node_is_union || left_leafs.desc->type == KOW_BRANCH_START;
-                found_node_match = 1;
-                if (node_is_branch)
+                if (check_nodes_match(left_leafs.desc, right_leafs.desc))
                 {
-                    // compare a complex (branch) node
-                    int left_size, right_size, i;
-                    ret = kowhai_get_node_size(left_leafs.desc, &left_size);
-                    if (ret != KOW_STATUS_OK)
-                        return ret;
-                    ret = kowhai_get_node_size(right_leafs.desc, &right_size);
-                    if (ret != KOW_STATUS_OK)
-                        return ret;
-                    for (i = 0; i < left_leafs.desc->count; i++)
-                    {
-                        // check for data diff in right branch array items
-                        if (i < right_leafs.desc->count)
-                        {
-                            ret = diff_l2r(&left_leafs, &right_leafs, on_diff_param, on_diff, depth + 1);
-                            if (ret != KOW_STATUS_OK)
-                                return ret;
-                            right_leafs.data = (uint8_t*)right_leafs.data + right_size / right_leafs.desc->count;
-                        }
-                        else if (on_diff != NULL)
-                            // missing array items from right branch
-                            on_diff(on_diff_param, left_leafs.desc, left_leafs.data, NULL, NULL, i, depth);
-                        left_leafs.data = (uint8_t*)left_leafs.data + left_size / left_leafs.desc->count;
-                    }
-                    // rewind as increment tree will increment the data pointer
-                    left_leafs.data = (uint8_t*)left_leafs.data - left_size;
-                    right_leafs.data = (uint8_t*)right_leafs.data - right_size;
+                    found_node_match = 1;
+                    break;
                 }
-                else
+                // node metadata does not match increment right tree
+                ret = increment_tree(&right_leafs, in_union, stack);
+                if (ret != KOW_STATUS_OK)
+                    goto done;
+            }
+
+            if (found_node_match)
+            {
+                // node metadata matches, do data comparison
+                node_is_branch = left_leafs.desc->type == KOW_BRANCH_U_START || left_leafs.desc->type == KOW_BRANCH_START;
+                if (!node_is_branch)
                 {
                     // compare a simple (non branch) node
                     ret = compare_simple_node_contents(&left_leafs, &right_leafs, on_diff_param, on_diff, depth + 1);
                     if (ret != KOW_STATUS_OK)
-                        return ret;
+                        goto done;
                 }
-                break;
             }
-            else
+            else if (on_diff != NULL)
+                // node not found in right tree, call on_diff
+                on_diff(on_diff_param, left_leafs.desc, left_leafs.data, NULL, NULL, 1, depth);
+
+            if (!node_is_branch)
             {
-                // node metadata does not match increment right tree
-                ret = increment_tree(&right_leafs, in_union);
+                // increment left tree (next node to compare at this level)
+                ret = increment_tree(&left_leafs, in_union, stack);
                 if (ret != KOW_STATUS_OK)
-                    return ret;
+                    goto done;
+                continue;
             }
-        }
 
-        if (!found_node_match && on_diff != NULL)
-            // node not found in right tree, call on_diff
-            on_diff(on_diff_param, left_leafs.desc, left_leafs.data, NULL, NULL, 1, depth);
+            // compare a complex (branch) node starting from the first array item
+            ret = kowhai_get_node_size_ex(left_leafs.desc, &left_size, stack);
+            if (ret != KOW_STATUS_OK)
+                goto done;
+            ret = kowhai_get_node_size_ex(right_leafs.desc, &right_size, stack);
+            if (ret != KOW_STATUS_OK)
+                goto done;
+            i = 0;
+        }
 
+        // check for data diff in right branch array items
+        if (i < left_leafs.desc->count && i < right_leafs.desc->count)
+        {
+            frame = kowhai_walk_stack_push(stack, base + depth);
+            if (frame == NULL)
+            {
+                ret = KOW_STATUS_STACK_TOO_SMALL;
+                goto done;
+            }
+            frame->node = left_leafs.desc;
+            frame->data = left_leafs.data;
+            frame->node2 = right_leafs.desc;
+            frame->data2 = right_leafs.data;
+            frame->index = i;
+            frame->value[0] = in_union;
+            frame->value[1] = left_size;
+            frame->value[2] = right_size;
+            depth++;
+            in_union = left_leafs.desc->type == KOW_BRANCH_U_START;
+            right_branch = right_leafs;
+            left_leafs.desc = left_leafs.desc + 1;
+            continue;
+        }
+        for (; i < left_leafs.desc->count; i++)
+        {
+            if (on_diff != NULL)
+                // missing array items from right branch
+                on_diff(on_diff_param, left_leafs.desc, left_leafs.data, NULL, NULL, i, depth);
+            left_leafs.data = (uint8_t*)left_leafs.data + left_size / left_leafs.desc->count;
+        }
+        // rewind as increment tree will increment the data pointer
+        left_leafs.data = (uint8_t*)left_leafs.data - left_size;
         // increment left tree (next node to compare at this level)
-        ret = increment_tree(&left_leafs, in_union);
+        ret = increment_tree(&left_leafs, in_union, stack);
         if (ret != KOW_STATUS_OK)
-            return ret;
+            goto done;
     }
+    ret = KOW_STATUS_OK;
 
-    return KOW_STATUS_OK;
+done:
+    stack->depth = base;
+    return ret;
 }
 
 /**
@@ -183,22 +244,134 @@ static int diff_l2r(struct kowhai_tree_t *left, struct kowhai_tree_t *right, voi
  * @param on_diff_param, application specific parameter passed through the on_diff callback
  * @param on_diff, call this when a unique (to left) node or common nodes that have different values are found
  */
+// the parameters of a diff walk run by kowhai_walk_default
+struct diff_walk_t
+{
+    struct kowhai_tree_t *left;
+    struct kowhai_tree_t *right;
+    void* on_diff_param;
+    kowhai_on_diff_t on_diff;
+};
+
+static int diff_walk(void *param, struct kowhai_walk_stack_t *stack)
+{
+    struct diff_walk_t *walk = (struct diff_walk_t*)param;
+    return kowhai_diff_ex(walk->left, walk->right, walk->on_diff_param, walk->on_diff, stack);
+}
+
 int kowhai_diff(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* on_diff_param, kowhai_on_diff_t on_diff)
 {
-    int ret;
+    struct diff_walk_t walk;
+    int depth = kowhai_get_node_depth(left->desc);
+    int right_depth = kowhai_get_node_depth(right->desc);
+    // on_diff is called as the trees are walked so the stack is made deep enough up front rather than walking again
+    if (right_depth > depth)
+        depth = right_depth;
+    walk.left = left;
+    walk.right = right;
+    walk.on_diff_param = on_diff_param;
+    walk.on_diff = on_diff;
+    return kowhai_walk_default(depth, diff_walk, &walk);
+}
 
+int kowhai_diff_ex(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* on_diff_param, kowhai_on_diff_t on_diff, struct kowhai_walk_stack_t *stack)
+{
     // we use diff_l2r to find nodes that are unique in the left tree, or nodes that differ in value between left and right first
     KOW_LOG(KOWHAI_UTILS_INFO "diff left against right\n");
-    ret = diff_l2r(left, right, on_diff_param, on_diff, 0);
-    if (ret != KOW_STATUS_OK)
-        return ret;
+    return diff_l2r(left, right, on_diff_param, on_diff, stack);
+}
 
-    return ret;
+// compare the array items of two matching leaf nodes in flat descriptors
+static int flat_compare_leaf(const struct kowhai_flat_desc_t *left, int l, uint8_t *left_data, const struct kowhai_flat_desc_t *right, int r, uint8_t *right_data, void* on_diff_param, kowhai_on_diff_t on_diff, int depth)
+{
+    int i, ret;
+    int left_size = left->element_size[l];
+    int right_size = right->element_size[r];
+
+    if (on_diff == NULL)
+        return KOW_STATUS_OK;
+
+    for (i = 0; i < left->count[l]; i++)
+    {
+        int offset = left_size * i;
+        if (i < right->count[r])
+        {
+            // these array elements differ if the sizes dont match or the values dont match
+            if (left_size == right_size && memcmp(left_data + offset, right_data + offset, left_size) == 0)
+                continue;
+            ret = on_diff(on_diff_param, &left->tables.desc[l], left_data + offset, &right->tables.desc[r], right_data + offset, i, depth);
+        }
+        else
+            // unique array items
+            ret = on_diff(on_diff_param, &left->tables.desc[l], left_data + offset, NULL, NULL, i, depth);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+    }
+
+    return KOW_STATUS_OK;
+}
+
+// same as diff_l2r but for flat descriptors, left_branch and right_branch are the node indices of the branches to compare
+static int flat_diff_l2r(const struct kowhai_flat_desc_t *left, int left_branch, uint8_t *left_data, const struct kowhai_flat_desc_t *right, int right_branch, uint8_t *right_data, void* on_diff_param, kowhai_on_diff_t on_diff, int depth)
+{
+    int l, r, i, ret;
+
+    for (l = left_branch + 1; left->type[l] != KOW_BRANCH_END; l += left->tables.node_count[l])
+    {
+        // the data offset of a child less the data offset of its branch is its offset within the branch array item
+        uint8_t *l_data = left_data + (left->tables.data_offset[l] - left->tables.data_offset[left_branch]);
+        int found_node_match = 0;
+
+        for (r = right_branch + 1; right->type[r] != KOW_BRANCH_END; r += right->tables.node_count[r])
+        {
+            uint8_t *r_data;
+            if (left->type[l] != right->type[r] || left->symbol[l] != right->symbol[r])
+                continue;
+
+            // node metadata matches, do data comparison
+            found_node_match = 1;
+            r_data = right_data + (right->tables.data_offset[r] - right->tables.data_offset[right_branch]);
+            if (left->type[l] == KOW_BRANCH_START || left->type[l] == KOW_BRANCH_U_START)
+            {
+                for (i = 0; i < left->count[l]; i++)
+                {
+                    if (i < right->count[r])
+                    {
+                        ret = flat_diff_l2r(left, l, l_data + i * left->element_size[l], right, r, r_data + i * right->element_size[r], on_diff_param, on_diff, depth + 1);
+                        if (ret != KOW_STATUS_OK)
+                            return ret;
+                    }
+                    else if (on_diff != NULL)
+                        // missing array items from right branch
+                        on_diff(on_diff_param, &left->tables.desc[l], l_data + i * left->element_size[l], NULL, NULL, i, depth);
+                }
+            }
+            else
+            {
+                ret = flat_compare_leaf(left, l, l_data, right, r, r_data, on_diff_param, on_diff, depth + 1);
+                if (ret != KOW_STATUS_OK)
+                    return ret;
+            }
+            break;
+        }
+
+        if (!found_node_match && on_diff != NULL)
+            // node not found in right tree, call on_diff
+            on_diff(on_diff_param, &left->tables.desc[l], l_data, NULL, NULL, 1, depth);
+    }
+
+    return KOW_STATUS_OK;
+}
+
+int kowhai_flat_diff(const struct kowhai_flat_desc_t *left, void *left_data, const struct kowhai_flat_desc_t *right, void *right_data, void* on_diff_param, kowhai_on_diff_t on_diff)
+{
+    KOW_LOG(KOWHAI_UTILS_INFO "flat diff left against right\n");
+    return flat_diff_l2r(left, 0, (uint8_t*)left_data, right, 0, (uint8_t*)right_data, on_diff_param, on_diff, 0);
 }
 
 /**
  * @brief called by diff when merging
- * @param param unused parameter
+ * @param param the destination tree (written nodes are preserved in its snapshot and marked in its dirty bitmap)
  * @param dst this is the destination node to merge common source nodes into, or NULL if node is unique to src
  * @param src this is the source node to merge into common destination nodes, or NULL if node is unique to dst
  * @param depth, how deep in the tree are we (0 root, 1 first branch, etc)
@@ -249,7 +422,18 @@ static int on_diff_merge(void* param, const struct kowhai_node_t *dst_node, void
         return KOW_STATUS_OK;
 
     KOW_LOG(KOWHAI_UTILS_INFO "(%d)%.*s merging %d bytes of %d[%d] from src into dst\n", depth, depth, KOWHAI_TABS, size, dst_node->symbol, index);
-    memcpy(dst_data, src_data, size);
+    if (param != NULL)
+    {
+        struct kowhai_tree_t *dst = (struct kowhai_tree_t*)param;
+        int offset = (int)((char*)dst_data - (char*)dst->data);
+        if (dst->snapshot != NULL)
+            kowhai_snapshot_preserve(dst->snapshot, offset, size);
+        memcpy(dst_data, src_data, size);
+        if (dst->dirty != NULL)
+            kowhai_dirty_mark(dst->dirty, offset, size);
+    }
+    else
+        memcpy(dst_data, src_data, size);
     
     return KOW_STATUS_OK;
 }
@@ -264,7 +448,7 @@ int kowhai_merge(struct kowhai_tree_t *dst, struct kowhai_tree_t *src)
         return KOW_STATUS_INVALID_DESCRIPTOR;
     
     // update all the notes in dst that are common to dst and src
-    return kowhai_diff(dst, src, NULL, on_diff_merge);
+    return kowhai_diff(dst, src, dst, on_diff_merge);
 }
 
 int kowhai_create_symbol_path(struct kowhai_node_t* descriptor, struct kowhai_node_t* node, union kowhai_symbol_t* target, int* target_size)
@@ -293,44 +477,83 @@ int kowhai_create_symbol_path(struct kowhai_node_t* descriptor, struct kowhai_no
     return KOW_STATUS_OK;
 }
 
-int _create_symbol_path2(struct kowhai_tree_t* tree, void* target_location, union kowhai_symbol_t* target, int* target_size, int symbol_path_length, int in_union)
+// find the symbol path of target_location, each branch array item walked into saves its branch on the stack
+static int create_symbol_path2(struct kowhai_tree_t* tree, void* target_location, union kowhai_symbol_t* target, int* target_size, int in_union, struct kowhai_walk_stack_t *stack)
 {
+    struct kowhai_walk_frame_t *frame;
+    const struct kowhai_node_t *node;
+    int base = stack->depth;
+    int depth = 0;
+    int top_in_union = in_union;
+    int symbol_path_length = 2;
+    int ret;
+
     if (*target_size < symbol_path_length)
         return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
     while (tree->data <= target_location)
     {
-        int ret;
+        stack->depth = base + depth;
         switch (tree->desc->type)
         {
             case KOW_BRANCH_START:
             case KOW_BRANCH_U_START:
-            {
-                int i;
-                struct kowhai_node_t* node = tree->desc;
-                for (i = 0; i < node->count; i++)
+                node = tree->desc;
+                if (node->count == 0)
+                    break;
+                // walk into the first array item of this branch
+                frame = kowhai_walk_stack_push(stack, base + depth);
+                if (frame == NULL)
+                {
+                    ret = KOW_STATUS_STACK_TOO_SMALL;
+                    goto done;
+                }
+                frame->node = node;
+                frame->data = tree->data;
+                frame->index = 0;
+                depth++;
+                target[symbol_path_length - 1].symbol = KOWHAI_SYMBOL(node->symbol, 0);
+                symbol_path_length++;
+                if (*target_size < symbol_path_length)
+                {
+                    ret = KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                    goto done;
+                }
+                in_union = node->type == KOW_BRANCH_U_START;
+                tree->desc = (struct kowhai_node_t*)node + 1;
+                continue;
+            case KOW_BRANCH_END:
+                if (depth == 0)
+                {
+                    ret = KOW_STATUS_NOT_FOUND;
+                    goto done;
+                }
+                // not found in this branch array item so try the next one
+                frame = kowhai_walk_stack_frame(stack, base + depth - 1);
+                node = frame->node;
+                if (node->type == KOW_BRANCH_U_START)
                 {
-                    void* p_original = tree->data;
-                    target[symbol_path_length - 1].symbol = KOWHAI_SYMBOL(node->symbol, i);
-                    tree->desc = node + 1;
-                    ret = _create_symbol_path2(tree, target_location, target, target_size, symbol_path_length + 1, node->type == KOW_BRANCH_U_START);
-                    if (ret == KOW_STATUS_OK)
-                        return ret;
-                    if (ret != KOW_STATUS_NOT_FOUND)
-                        return ret;
-                    if (node->type == KOW_BRANCH_U_START)
+                    int size;
+                    tree->data = frame->data;
+                    if (kowhai_get_node_size_ex(node, &size, stack) != KOW_STATUS_OK)
                     {
-                        int size;
-                        tree->data = p_original;
-                        if (kowhai_get_node_size(node, &size) == KOW_STATUS_OK)
-                            tree->data = (char*)tree->data + size / node->count;
-                        else
-                            return KOW_STATUS_INVALID_DESCRIPTOR;
+                        ret = KOW_STATUS_INVALID_DESCRIPTOR;
+                        goto done;
                     }
+                    tree->data = (char*)tree->data + size / node->count;
                 }
+                frame->index++;
+                if (frame->index < node->count)
+                {
+                    frame->data = tree->data;
+                    target[symbol_path_length - 2].symbol = KOWHAI_SYMBOL(node->symbol, frame->index);
+                    tree->desc = (struct kowhai_node_t*)node + 1;
+                    continue;
+                }
+                // all the array items have been walked, carry on after the branch in the parent
+                depth--;
+                symbol_path_length--;
+                in_union = depth > 0 ? kowhai_walk_stack_frame(stack, base + depth - 1)->node->type == KOW_BRANCH_U_START : top_in_union;
                 break;
-            }
-            case KOW_BRANCH_END:
-                return KOW_STATUS_NOT_FOUND;
             default:
             {
                 int i;
@@ -349,10 +572,39 @@ int _create_symbol_path2(struct kowhai_tree_t* tree, void* target_location, unio
         tree->desc++;
     }
     *target_size = symbol_path_length;
-    return KOW_STATUS_OK;
+    ret = KOW_STATUS_OK;
+
+done:
+    stack->depth = base;
+    return ret;
+}
+
+// the parameters of a create_symbol_path2 walk run by kowhai_walk_default
+struct symbol_path_walk_t
+{
+    struct kowhai_tree_t* tree;
+    void* target_location;
+    union kowhai_symbol_t* target;
+    int* target_size;
+};
+
+static int symbol_path_walk(void *param, struct kowhai_walk_stack_t *stack)
+{
+    struct symbol_path_walk_t *walk = (struct symbol_path_walk_t*)param;
+    return kowhai_create_symbol_path2_ex(walk->tree, walk->target_location, walk->target, walk->target_size, stack);
 }
 
 int kowhai_create_symbol_path2(struct kowhai_tree_t* tree, void* target_location, union kowhai_symbol_t* target, int* target_size)
+{
+    struct symbol_path_walk_t walk;
+    walk.tree = tree;
+    walk.target_location = target_location;
+    walk.target = target;
+    walk.target_size = target_size;
+    return kowhai_walk_default(kowhai_get_node_depth(tree->desc), symbol_path_walk, &walk);
+}
+
+int kowhai_create_symbol_path2_ex(struct kowhai_tree_t* tree, void* target_location, union kowhai_symbol_t* target, int* target_size, struct kowhai_walk_stack_t *stack)
 {
     struct kowhai_tree_t tmp_tree = *tree;
     // first node will be a branch
@@ -360,6 +612,6 @@ int kowhai_create_symbol_path2(struct kowhai_tree_t* tree, void* target_location
         return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
     target->symbol = tmp_tree.desc->symbol;
     tmp_tree.desc++;
-    return _create_symbol_path2(&tmp_tree, target_location, target, target_size, 2, tree->desc->type == KOW_BRANCH_U_START);
+    return create_symbol_path2(&tmp_tree, target_location, target, target_size, tree->desc->type == KOW_BRANCH_U_START, stack);
 }
 
@@ -2,6 +2,7 @@
 #define _KOWHAI_UTILS_H_
 
 #include "kowhai.h" 
+#include "kowhai_flat.h"
 
 /**
  * @brief called when a difference is found between two tree's
@@ -26,6 +27,27 @@ typedef int (*kowhai_on_diff_t)(void* param, const struct kowhai_node_t *left_no
  */
 int kowhai_diff(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* on_diff_param, kowhai_on_diff_t on_diff);
 
+/**
+ * @brief same as kowhai_diff but uses a caller supplied walk stack
+ * @param left, diff this tree against right
+ * @param right, diff this tree against left
+ * @param on_diff_param, application specific parameter passed through the on_diff callback
+ * @param on_diff, call this when a unique (to left) node or common nodes that have different values are found
+ * @param stack, frames for the walk (KOW_STATUS_STACK_TOO_SMALL is returned if the tree is too deep)
+ */
+int kowhai_diff_ex(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* on_diff_param, kowhai_on_diff_t on_diff, struct kowhai_walk_stack_t *stack);
+
+/**
+ * @brief same as kowhai_diff but walks flat descriptors (see kowhai_flat_init)
+ * @param left, flat descriptor of the tree to diff against right
+ * @param left_data, data of the left tree
+ * @param right, flat descriptor of the tree to diff against left
+ * @param right_data, data of the right tree
+ * @param on_diff_param, application specific parameter passed through the on_diff callback
+ * @param on_diff, call this when a unique (to left) node or common nodes that have different values are found
+ */
+int kowhai_flat_diff(const struct kowhai_flat_desc_t *left, void *left_data, const struct kowhai_flat_desc_t *right, void *right_data, void* on_diff_param, kowhai_on_diff_t on_diff);
+
 /**
  * @brief merge nodes that are common to src and dst from src into dst leaving unique nodes unchanged
  * @brief dst, destination tree (this is updated from the source tree)
@@ -54,5 +76,16 @@ int kowhai_create_symbol_path(struct kowhai_node_t* descriptor, struct kowhai_no
  */
 int kowhai_create_symbol_path2(struct kowhai_tree_t* tree, void* target_location, union kowhai_symbol_t* target, int* target_size);
 
+/**
+ * Same as kowhai_create_symbol_path2 but uses a caller supplied walk stack
+ * @param tree, the tree that we are making a symbol path from
+ * @param target_location, the memory location in the tree data that we want our symbol path to point to
+ * @param target, the target buffer for our created symbol path
+ * @param size, the size of target buffer
+ * @param stack, frames for the walk (KOW_STATUS_STACK_TOO_SMALL is returned if the tree is too deep)
+ * @return KOW_STATUS_OK on success (also update size param to actual size of symbol path created)
+ */
+int kowhai_create_symbol_path2_ex(struct kowhai_tree_t* tree, void* target_location, union kowhai_symbol_t* target, int* target_size, struct kowhai_walk_stack_t *stack);
+
 #endif
 
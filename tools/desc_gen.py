@@ -0,0 +1,214 @@
+# descriptor compiler, generates a kowhai descriptor, the matching packed data struct, offset and size
+# constants and precomputed node tables from a json schema so they cannot drift apart
+#
+# usage: python desc_gen.py schema.json [output.h]
+#
+# schema format:
+#   {
+#       "defines": {"COEFF_COUNT": 6},
+#       "trees": [
+#           {"name": "settings", "symbol": "Settings", "children": [
+#               {"symbol": "Gain", "type": "uint32"},
+#               {"symbol": "Coefficient", "type": "float", "count": "COEFF_COUNT"},
+#               {"symbol": "Oven", "children": [...]},
+#               {"symbol": "Union", "union": true, "children": [...]}
+#           ]}
+#       ]
+#   }
+#
+# symbols are the names from symbols.txt (SYM_xxx from symbols.h), the generated header expects
+# kowhai.h and symbols.h to be included before it
+import json
+import os
+import re
+import sys
+
+TYPES = {
+    "int8":   ("KOW_INT8",   "int8_t",   1),
+    "uint8":  ("KOW_UINT8",  "uint8_t",  1),
+    "int16":  ("KOW_INT16",  "int16_t",  2),
+    "uint16": ("KOW_UINT16", "uint16_t", 2),
+    "int32":  ("KOW_INT32",  "int32_t",  4),
+    "uint32": ("KOW_UINT32", "uint32_t", 4),
+    "float":  ("KOW_FLOAT",  "float",    4),
+    "char":   ("KOW_CHAR",   "char",     1),
+    "int64":  ("KOW_INT64",  "int64_t",  8),
+    "uint64": ("KOW_UINT64", "uint64_t", 8),
+    "double": ("KOW_DOUBLE", "double",   8),
+}
+
+C_KEYWORDS = set("""auto break case char const continue default do double else enum extern float for goto if
+    inline int long register restrict return short signed sizeof static struct switch typedef union unsigned
+    void volatile while""".split())
+
+def snake(symbol):
+    s = re.sub(r"([a-z0-9])([A-Z])", r"\1_\2", symbol)
+    s = re.sub(r"([A-Z]+)([A-Z][a-z])", r"\1_\2", s)
+    return s.lower()
+
+def member_name(symbol):
+    name = snake(symbol)
+    if name in C_KEYWORDS:
+        name += "_"
+    return name
+
+class Node:
+    def __init__(self, schema, defines, parent):
+        self.symbol = schema["symbol"]
+        self.tag = schema.get("tag", 0)
+        count = schema.get("count", 1)
+        if isinstance(count, str):
+            if count not in defines:
+                raise Exception("%s: count %s is not defined" % (self.symbol, count))
+            self.count_str = count
+            self.count = defines[count]
+        else:
+            self.count_str = str(count)
+            self.count = count
+        self.parent = parent
+        self.path = (parent.path if parent else []) + [self.symbol]
+        self.member = member_name(self.symbol)
+        if "children" in schema:
+            self.is_union = schema.get("union", False)
+            self.children = [Node(c, defines, self) for c in schema["children"]]
+            if not self.children:
+                raise Exception("%s: empty branch" % self.symbol)
+            names = [c.symbol for c in self.children]
+            for n in names:
+                if names.count(n) > 1:
+                    raise Exception("%s: duplicate child %s" % (self.symbol, n))
+            sizes = [c.size for c in self.children]
+            self.item_size = max(sizes) if self.is_union else sum(sizes)
+        else:
+            self.children = None
+            if schema.get("type") not in TYPES:
+                raise Exception("%s: unknown type %s" % (self.symbol, schema.get("type")))
+            self.kow_type, self.c_type, type_size = TYPES[schema["type"]]
+            self.item_size = type_size
+        self.size = self.item_size * self.count
+
+def layout(node, offset, rows):
+    # rows match kowhai_init_node_tables, (node, kowhai type, size, node count, data offset)
+    start = len(rows)
+    if node.children is None:
+        rows.append([node, node.kow_type, node.size, 1, offset])
+        return
+    rows.append([node, "KOW_BRANCH_U_START" if node.is_union else "KOW_BRANCH_START", node.size, 0, offset])
+    child_offset = offset
+    for c in node.children:
+        layout(c, child_offset, rows)
+        if not node.is_union:
+            child_offset += c.size
+    rows.append([node, "KOW_BRANCH_END", 0, 1, offset + node.item_size])
+    rows[start][3] = len(rows) - start
+
+def type_name(tree_name, node):
+    return "%s_%s_t" % (tree_name, "_".join(snake(s) for s in node.path[1:]))
+
+def write_types(f, tree_name, node):
+    # children first so the types are declared before they are used
+    for c in node.children:
+        if c.children is not None:
+            write_types(f, tree_name, c)
+    name = tree_name + "_t" if node.parent is None else type_name(tree_name, node)
+    f.write("%s %s\n{\n" % ("union" if node.is_union else "struct", name))
+    for c in node.children:
+        if c.children is None:
+            ctype = c.c_type
+        else:
+            ctype = "%s %s" % ("union" if c.is_union else "struct", type_name(tree_name, c))
+        if c.count_str == "1":
+            f.write("    %s %s;\n" % (ctype, c.member))
+        else:
+            f.write("    %s %s[%s];\n" % (ctype, c.member, c.count_str))
+    f.write("};\n\n")
+
+def macro_name(tree_name, node):
+    return "_".join([tree_name.upper()] + [snake(s).upper() for s in node.path[1:]])
+
+def member_path(node):
+    # the member designator from the root struct with all array indices 0 (for offsetof)
+    parts = []
+    while node.parent is not None:
+        parts.insert(0, node.member + ("[0]" if node.count_str != "1" else ""))
+        node = node.parent
+    # the array index of the last member is not wanted
+    parts[-1] = re.sub(r"\[0\]$", "", parts[-1])
+    return ".".join(parts)
+
+def write_tree(f, schema, defines):
+    root = Node(schema, defines, None)
+    if root.children is None or root.count != 1:
+        raise Exception("%s: the root of a tree must be a single branch" % root.symbol)
+    name = schema.get("name", snake(root.symbol))
+    upper = name.upper()
+    rows = []
+    layout(root, 0, rows)
+
+    f.write("//\n// %s tree\n//\n\n" % name)
+
+    # data struct
+    f.write("#pragma pack(1)\n\n")
+    write_types(f, name, root)
+    f.write("#pragma pack()\n\n")
+
+    # descriptor
+    f.write("static struct kowhai_node_t %s_descriptor[] =\n{\n" % name)
+    for node, kow_type, size, node_count, offset in rows:
+        count = "0" if kow_type == "KOW_BRANCH_END" else node.count_str
+        tag = "0" if kow_type == "KOW_BRANCH_END" else str(node.tag)
+        f.write("    { %-20s SYM_%-20s %-16s %s },\n" % (kow_type + ",", node.symbol.upper() + ",", count + ",", tag))
+    f.write("};\n\n")
+
+    # sizes and offsets (with all parent array indices 0)
+    f.write("#define %s_NUM_NODES %d\n" % (upper, len(rows)))
+    f.write("#define %s_SIZE %d\n" % (upper, root.size))
+    for node, kow_type, size, node_count, offset in rows[1:]:
+        if kow_type == "KOW_BRANCH_END":
+            continue
+        f.write("#define %s_OFFSET %d\n" % (macro_name(name, node), offset))
+        f.write("#define %s_SIZE %d\n" % (macro_name(name, node), size))
+    f.write("\n")
+
+    # check the compiler agrees with the layout
+    f.write("KOWHAI_STATIC_ASSERT(%s_size, sizeof(struct %s_t) == %s_SIZE);\n" % (name, name, upper))
+    for node, kow_type, size, node_count, offset in rows[1:]:
+        if kow_type == "KOW_BRANCH_END":
+            continue
+        macro = macro_name(name, node)
+        f.write("KOWHAI_STATIC_ASSERT(%s_offset, offsetof(struct %s_t, %s) == %s_OFFSET);\n" % (macro.lower(), name, member_path(node), macro))
+    f.write("\n")
+
+    # precomputed node tables (see kowhai_init_node_tables)
+    for table, column in (("node_size", 2), ("node_count", 3), ("data_offset", 4)):
+        f.write("static int32_t %s_%s[] = {%s};\n" % (name, table, ", ".join(str(r[column]) for r in rows)))
+    f.write("#define %s_NODE_TABLES {%s_descriptor, %s_NUM_NODES, %s_node_size, %s_node_count, %s_data_offset}\n\n" %
+        (upper, name, upper, name, name, name))
+
+def main():
+    schema_path = sys.argv[1]
+    if len(sys.argv) > 2:
+        out_path = sys.argv[2]
+    else:
+        out_path = os.path.splitext(schema_path)[0] + ".h"
+    schema = json.load(open(schema_path))
+    defines = schema.get("defines", {})
+    guard = "_%s_" % re.sub(r"[^A-Za-z0-9]", "_", os.path.basename(out_path)).upper()
+
+    f = open(out_path, "w")
+    f.write("// generated by desc_gen.py from %s, do not edit\n\n" % os.path.basename(schema_path))
+    f.write("#ifndef %s\n#define %s\n\n" % (guard, guard))
+    f.write("#include <stddef.h>\n\n")
+    f.write("#ifndef KOWHAI_STATIC_ASSERT\n")
+    f.write("#define KOWHAI_STATIC_ASSERT(name, cond) typedef char kowhai_static_assert_##name[(cond) ? 1 : -1]\n")
+    f.write("#endif\n\n")
+    for d in defines:
+        f.write("#define %s %d\n" % (d, defines[d]))
+    if defines:
+        f.write("\n")
+    for tree in schema["trees"]:
+        write_tree(f, tree, defines)
+    f.write("#endif\n")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,175 @@
+// generated by desc_gen.py from settings_desc.json, do not edit
+
+#ifndef _SETTINGS_DESC_H_
+#define _SETTINGS_DESC_H_
+
+#include <stddef.h>
+
+#ifndef KOWHAI_STATIC_ASSERT
+#define KOWHAI_STATIC_ASSERT(name, cond) typedef char kowhai_static_assert_##name[(cond) ? 1 : -1]
+#endif
+
+#define FLUX_CAP_COUNT 2
+#define COEFF_COUNT 6
+#define UNION_COUNT 2
+#define OWNER_MAX_LEN 12
+
+//
+// compiled_settings tree
+//
+
+#pragma pack(1)
+
+struct compiled_settings_flux_capacitor_t
+{
+    char owner[OWNER_MAX_LEN];
+    uint32_t frequency;
+    uint32_t gain;
+    float coefficient[COEFF_COUNT];
+};
+
+struct compiled_settings_oven_t
+{
+    int16_t temp;
+    uint16_t timeout;
+};
+
+struct compiled_settings_union_container_union_parts_t
+{
+    uint8_t part1;
+    uint8_t part2;
+};
+
+union compiled_settings_union_container_union_t
+{
+    int16_t temp;
+    uint16_t timeout;
+    uint8_t beep;
+    char owner[OWNER_MAX_LEN];
+    struct compiled_settings_union_container_union_parts_t parts;
+};
+
+struct compiled_settings_union_container_t
+{
+    union compiled_settings_union_container_union_t union_[UNION_COUNT];
+    uint32_t check;
+};
+
+struct compiled_settings_t
+{
+    struct compiled_settings_flux_capacitor_t flux_capacitor[FLUX_CAP_COUNT];
+    struct compiled_settings_oven_t oven;
+    struct compiled_settings_union_container_t union_container[UNION_COUNT];
+    int64_t check;
+    uint64_t timeout;
+    double temp;
+};
+
+#pragma pack()
+
+static struct kowhai_node_t compiled_settings_descriptor[] =
+{
+    { KOW_BRANCH_START,    SYM_SETTINGS,            1,               0 },
+    { KOW_BRANCH_START,    SYM_FLUXCAPACITOR,       FLUX_CAP_COUNT,  0 },
+    { KOW_CHAR,            SYM_OWNER,               OWNER_MAX_LEN,   0 },
+    { KOW_UINT32,          SYM_FREQUENCY,           1,               0 },
+    { KOW_UINT32,          SYM_GAIN,                1,               0 },
+    { KOW_FLOAT,           SYM_COEFFICIENT,         COEFF_COUNT,     0 },
+    { KOW_BRANCH_END,      SYM_FLUXCAPACITOR,       0,               0 },
+    { KOW_BRANCH_START,    SYM_OVEN,                1,               0 },
+    { KOW_INT16,           SYM_TEMP,                1,               0 },
+    { KOW_UINT16,          SYM_TIMEOUT,             1,               0 },
+    { KOW_BRANCH_END,      SYM_OVEN,                0,               0 },
+    { KOW_BRANCH_START,    SYM_UNIONCONTAINER,      UNION_COUNT,     0 },
+    { KOW_BRANCH_U_START,  SYM_UNION,               UNION_COUNT,     0 },
+    { KOW_INT16,           SYM_TEMP,                1,               0 },
+    { KOW_UINT16,          SYM_TIMEOUT,             1,               0 },
+    { KOW_UINT8,           SYM_BEEP,                1,               0 },
+    { KOW_CHAR,            SYM_OWNER,               OWNER_MAX_LEN,   0 },
+    { KOW_BRANCH_START,    SYM_PARTS,               1,               0 },
+    { KOW_UINT8,           SYM_PART1,               1,               0 },
+    { KOW_UINT8,           SYM_PART2,               1,               0 },
+    { KOW_BRANCH_END,      SYM_PARTS,               0,               0 },
+    { KOW_BRANCH_END,      SYM_UNION,               0,               0 },
+    { KOW_UINT32,          SYM_CHECK,               1,               0 },
+    { KOW_BRANCH_END,      SYM_UNIONCONTAINER,      0,               0 },
+    { KOW_INT64,           SYM_CHECK,               1,               0 },
+    { KOW_UINT64,          SYM_TIMEOUT,             1,               0 },
+    { KOW_DOUBLE,          SYM_TEMP,                1,               0 },
+    { KOW_BRANCH_END,      SYM_SETTINGS,            0,               0 },
+};
+
+#define COMPILED_SETTINGS_NUM_NODES 28
+#define COMPILED_SETTINGS_SIZE 172
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_OFFSET 0
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_SIZE 88
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_OWNER_OFFSET 0
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_OWNER_SIZE 12
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_FREQUENCY_OFFSET 12
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_FREQUENCY_SIZE 4
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_GAIN_OFFSET 16
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_GAIN_SIZE 4
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_OFFSET 20
+#define COMPILED_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_SIZE 24
+#define COMPILED_SETTINGS_OVEN_OFFSET 88
+#define COMPILED_SETTINGS_OVEN_SIZE 4
+#define COMPILED_SETTINGS_OVEN_TEMP_OFFSET 88
+#define COMPILED_SETTINGS_OVEN_TEMP_SIZE 2
+#define COMPILED_SETTINGS_OVEN_TIMEOUT_OFFSET 90
+#define COMPILED_SETTINGS_OVEN_TIMEOUT_SIZE 2
+#define COMPILED_SETTINGS_UNION_CONTAINER_OFFSET 92
+#define COMPILED_SETTINGS_UNION_CONTAINER_SIZE 56
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_OFFSET 92
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_SIZE 24
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_TEMP_OFFSET 92
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_TEMP_SIZE 2
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_OFFSET 92
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_SIZE 2
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_BEEP_OFFSET 92
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_BEEP_SIZE 1
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_OWNER_OFFSET 92
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_OWNER_SIZE 12
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_OFFSET 92
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_SIZE 2
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_OFFSET 92
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_SIZE 1
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_OFFSET 93
+#define COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_SIZE 1
+#define COMPILED_SETTINGS_UNION_CONTAINER_CHECK_OFFSET 116
+#define COMPILED_SETTINGS_UNION_CONTAINER_CHECK_SIZE 4
+#define COMPILED_SETTINGS_CHECK_OFFSET 148
+#define COMPILED_SETTINGS_CHECK_SIZE 8
+#define COMPILED_SETTINGS_TIMEOUT_OFFSET 156
+#define COMPILED_SETTINGS_TIMEOUT_SIZE 8
+#define COMPILED_SETTINGS_TEMP_OFFSET 164
+#define COMPILED_SETTINGS_TEMP_SIZE 8
+
+KOWHAI_STATIC_ASSERT(compiled_settings_size, sizeof(struct compiled_settings_t) == COMPILED_SETTINGS_SIZE);
+KOWHAI_STATIC_ASSERT(compiled_settings_flux_capacitor_offset, offsetof(struct compiled_settings_t, flux_capacitor) == COMPILED_SETTINGS_FLUX_CAPACITOR_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_flux_capacitor_owner_offset, offsetof(struct compiled_settings_t, flux_capacitor[0].owner) == COMPILED_SETTINGS_FLUX_CAPACITOR_OWNER_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_flux_capacitor_frequency_offset, offsetof(struct compiled_settings_t, flux_capacitor[0].frequency) == COMPILED_SETTINGS_FLUX_CAPACITOR_FREQUENCY_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_flux_capacitor_gain_offset, offsetof(struct compiled_settings_t, flux_capacitor[0].gain) == COMPILED_SETTINGS_FLUX_CAPACITOR_GAIN_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_flux_capacitor_coefficient_offset, offsetof(struct compiled_settings_t, flux_capacitor[0].coefficient) == COMPILED_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_oven_offset, offsetof(struct compiled_settings_t, oven) == COMPILED_SETTINGS_OVEN_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_oven_temp_offset, offsetof(struct compiled_settings_t, oven.temp) == COMPILED_SETTINGS_OVEN_TEMP_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_oven_timeout_offset, offsetof(struct compiled_settings_t, oven.timeout) == COMPILED_SETTINGS_OVEN_TIMEOUT_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_offset, offsetof(struct compiled_settings_t, union_container) == COMPILED_SETTINGS_UNION_CONTAINER_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_union_offset, offsetof(struct compiled_settings_t, union_container[0].union_) == COMPILED_SETTINGS_UNION_CONTAINER_UNION_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_union_temp_offset, offsetof(struct compiled_settings_t, union_container[0].union_[0].temp) == COMPILED_SETTINGS_UNION_CONTAINER_UNION_TEMP_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_union_timeout_offset, offsetof(struct compiled_settings_t, union_container[0].union_[0].timeout) == COMPILED_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_union_beep_offset, offsetof(struct compiled_settings_t, union_container[0].union_[0].beep) == COMPILED_SETTINGS_UNION_CONTAINER_UNION_BEEP_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_union_owner_offset, offsetof(struct compiled_settings_t, union_container[0].union_[0].owner) == COMPILED_SETTINGS_UNION_CONTAINER_UNION_OWNER_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_union_parts_offset, offsetof(struct compiled_settings_t, union_container[0].union_[0].parts) == COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_union_parts_part1_offset, offsetof(struct compiled_settings_t, union_container[0].union_[0].parts.part1) == COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_union_parts_part2_offset, offsetof(struct compiled_settings_t, union_container[0].union_[0].parts.part2) == COMPILED_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_union_container_check_offset, offsetof(struct compiled_settings_t, union_container[0].check) == COMPILED_SETTINGS_UNION_CONTAINER_CHECK_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_check_offset, offsetof(struct compiled_settings_t, check) == COMPILED_SETTINGS_CHECK_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_timeout_offset, offsetof(struct compiled_settings_t, timeout) == COMPILED_SETTINGS_TIMEOUT_OFFSET);
+KOWHAI_STATIC_ASSERT(compiled_settings_temp_offset, offsetof(struct compiled_settings_t, temp) == COMPILED_SETTINGS_TEMP_OFFSET);
+
+static int32_t compiled_settings_node_size[] = {172, 88, 12, 4, 4, 24, 0, 4, 2, 2, 0, 56, 24, 2, 2, 1, 12, 2, 1, 1, 0, 0, 4, 0, 8, 8, 8, 0};
+static int32_t compiled_settings_node_count[] = {28, 6, 1, 1, 1, 1, 1, 4, 1, 1, 1, 13, 10, 1, 1, 1, 1, 4, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+static int32_t compiled_settings_data_offset[] = {0, 0, 0, 12, 16, 20, 44, 88, 88, 90, 92, 92, 92, 92, 92, 92, 92, 92, 92, 93, 94, 104, 116, 120, 148, 156, 164, 172};
+#define COMPILED_SETTINGS_NODE_TABLES {compiled_settings_descriptor, COMPILED_SETTINGS_NUM_NODES, compiled_settings_node_size, compiled_settings_node_count, compiled_settings_data_offset}
+
+#endif
@@ -0,0 +1,149 @@
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "shm.h"
+
+struct shm_t
+{
+    void* address;
+    int size;
+    int owner;
+#ifdef WIN32
+    HANDLE mapping;
+#else
+    char name[256];
+#endif
+};
+
+static struct shm_t* shm_alloc(const char* name, int owner)
+{
+    struct shm_t* shm = (struct shm_t*)malloc(sizeof(struct shm_t));
+    if (shm == NULL)
+        return NULL;
+    memset(shm, 0, sizeof(struct shm_t));
+    shm->owner = owner;
+#ifndef WIN32
+    strncpy(shm->name, name, sizeof(shm->name) - 1);
+#endif
+    return shm;
+}
+
+// create (or replace) a named segment mapped read/write, the segment is removed when it is freed
+struct shm_t* shm_create(const char* name, int size)
+{
+    struct shm_t* shm = shm_alloc(name, 1);
+    if (shm == NULL)
+        return NULL;
+    shm->size = size;
+#ifdef WIN32
+    shm->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, name);
+    if (shm->mapping != NULL)
+        shm->address = MapViewOfFile(shm->mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (shm->address == NULL)
+    {
+        if (shm->mapping != NULL)
+            CloseHandle(shm->mapping);
+        free(shm);
+        return NULL;
+    }
+#else
+    {
+        int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+        if (fd < 0)
+        {
+            free(shm);
+            return NULL;
+        }
+        if (ftruncate(fd, size) == 0)
+            shm->address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (shm->address == NULL || shm->address == MAP_FAILED)
+        {
+            shm_unlink(name);
+            free(shm);
+            return NULL;
+        }
+    }
+#endif
+    return shm;
+}
+
+// map an existing named segment read only
+struct shm_t* shm_attach(const char* name)
+{
+    struct shm_t* shm = shm_alloc(name, 0);
+    if (shm == NULL)
+        return NULL;
+#ifdef WIN32
+    {
+        MEMORY_BASIC_INFORMATION info;
+        shm->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+        if (shm->mapping != NULL)
+            shm->address = MapViewOfFile(shm->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (shm->address == NULL)
+        {
+            if (shm->mapping != NULL)
+                CloseHandle(shm->mapping);
+            free(shm);
+            return NULL;
+        }
+        VirtualQuery(shm->address, &info, sizeof(info));
+        shm->size = (int)info.RegionSize;
+    }
+#else
+    {
+        struct stat st;
+        int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0)
+        {
+            free(shm);
+            return NULL;
+        }
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            shm->size = (int)st.st_size;
+            shm->address = mmap(NULL, shm->size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (shm->address == NULL || shm->address == MAP_FAILED)
+        {
+            free(shm);
+            return NULL;
+        }
+    }
+#endif
+    return shm;
+}
+
+void* shm_address(struct shm_t* shm)
+{
+    return shm->address;
+}
+
+int shm_size(struct shm_t* shm)
+{
+    return shm->size;
+}
+
+void shm_free(struct shm_t* shm)
+{
+#ifdef WIN32
+    UnmapViewOfFile(shm->address);
+    CloseHandle(shm->mapping);
+#else
+    munmap(shm->address, shm->size);
+    if (shm->owner)
+        shm_unlink(shm->name);
+#endif
+    free(shm);
+}
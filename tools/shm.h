@@ -0,0 +1,12 @@
+#ifndef _SHM_H_
+#define _SHM_H_
+
+struct shm_t;
+
+struct shm_t* shm_create(const char* name, int size);
+struct shm_t* shm_attach(const char* name);
+void* shm_address(struct shm_t* shm);
+int shm_size(struct shm_t* shm);
+void shm_free(struct shm_t* shm);
+
+#endif
@@ -19,6 +19,47 @@ for sym in syms:
         syms2.append(sym)
 syms = syms2
 
+# minimal perfect hash of the symbol names (this must match kowhai_symbols.c)
+HASH_SEED = 2166136261
+HASH_PRIME = 16777619
+SEED_MULTIPLIER = 0x9E3779B9
+def fnv1a(sym):
+    h = HASH_SEED
+    for c in sym.encode():
+        h = ((h ^ c) * HASH_PRIME) & 0xFFFFFFFF
+    return h
+def perfect_slot(h, seed, n):
+    h = (h ^ (seed * SEED_MULTIPLIER)) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h % n
+def make_perfect_hash(syms):
+    # hash and displace, place the biggest buckets first while most slots are free
+    n = len(syms)
+    hashes = [fnv1a(sym) for sym in syms]
+    buckets = [[] for i in range(n)]
+    for i in range(n):
+        buckets[hashes[i] % n].append(i)
+    seeds = [0] * n
+    slots = [None] * n
+    for b in sorted(range(n), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            break
+        for seed in range(0x10000):
+            pos = [perfect_slot(hashes[i], seed, n) for i in buckets[b]]
+            if len(set(pos)) == len(pos) and all(slots[p] is None for p in pos):
+                break
+        else:
+            raise Exception("no perfect hash seed found for %s" % [syms[i] for i in buckets[b]])
+        seeds[b] = seed
+        for i, p in zip(buckets[b], pos):
+            slots[p] = (hashes[i], i)
+    return seeds, slots
+seeds, slots = make_perfect_hash(syms)
+
 # write symbols.h
 f = open("symbols.h", "w")
 f.write("#ifndef _SYMBOLS_H_\n")
@@ -31,6 +72,17 @@ f.write("};\n\n")
 for i in range(len(syms)):
     sym = syms[i]
     f.write("#define SYM_%s\t\t%d\n" % (sym.upper(), i))
+# the perfect hash needs kowhai_symbols.h to be included first (see kowhai_symbol_table_init_perfect)
+f.write("\n#ifdef _KOWHAI_SYMBOLS_H_\n")
+f.write("static const uint16_t symbols_hash_seeds[] = {\n")
+for seed in seeds:
+    f.write("\t%d,\n" % seed)
+f.write("};\n\n")
+f.write("static const struct kowhai_symbol_table_slot_t symbols_hash_slots[] = {\n")
+for h, i in slots:
+    f.write("\t{0x%08X, SYM_%s},\n" % (h, syms[i].upper()))
+f.write("};\n")
+f.write("#endif\n")
 f.write("\n#endif\n");
 
 # write Symbols.cs
@@ -67,4 +67,74 @@ char* symbols[] = {
 #define SYM_DELAY		29
 #define SYM_TIME		30
 
+#ifdef _KOWHAI_SYMBOLS_H_
+static const uint16_t symbols_hash_seeds[] = {
+	0,
+	1,
+	0,
+	7,
+	1,
+	0,
+	0,
+	0,
+	0,
+	0,
+	1,
+	6,
+	0,
+	2,
+	3,
+	2,
+	5,
+	1,
+	0,
+	52,
+	0,
+	12,
+	0,
+	12,
+	0,
+	0,
+	0,
+	0,
+	1,
+	47,
+	0,
+};
+
+static const struct kowhai_symbol_table_slot_t symbols_hash_slots[] = {
+	{0x9B80731E, SYM_GAIN},
+	{0xB504857B, SYM_UNIONCONTAINER},
+	{0xA6241E4B, SYM_OVEN},
+	{0xB8D16159, SYM_BIG},
+	{0xDFE4E404, SYM_TIME},
+	{0x005EF20F, SYM_STATUS},
+	{0x4B058728, SYM_SETTINGS},
+	{0x819A4894, SYM_UNION},
+	{0x8D9206A1, SYM_FREQUENCY},
+	{0x592C8DE7, SYM_CHECK},
+	{0x78FC0FF2, SYM_FLUXCAPACITOR},
+	{0x3C0CB74C, SYM_PIXELS},
+	{0x9E85903F, SYM_UNSOLICITEDMODE},
+	{0x60315572, SYM_COEFFICIENT},
+	{0x20CC7478, SYM_DELAY},
+	{0xA0FA3C8D, SYM_FAIL},
+	{0xD4C7492D, SYM_DURATION},
+	{0x4B7F7705, SYM_STOP},
+	{0x0AE8097F, SYM_START},
+	{0x2CB28FC5, SYM_PARTS},
+	{0x63E6658B, SYM_SCOPE},
+	{0x452925EC, SYM_RUNNING},
+	{0x0B3C99BD, SYM_BEEP},
+	{0xEBB22972, SYM_PART2},
+	{0x82D97E28, SYM_TIMEOUT},
+	{0x9B22BE74, SYM_OWNER},
+	{0xEAB227DF, SYM_PART1},
+	{0xE65FB504, SYM_ACTIONS},
+	{0xD0D14114, SYM_UNSOLICITEDEVENT},
+	{0x82D1A881, SYM_SHADOW},
+	{0x40480BE7, SYM_TEMP},
+};
+#endif
+
 #endif
@@ -7,9 +7,24 @@
 #include "../src/kowhai_protocol.h"
 #include "../src/kowhai_protocol_server.h"
 #include "../src/kowhai_serialize.h"
+#include "../src/kowhai_index.h"
+#include "../src/kowhai_flat.h"
+#include "../src/kowhai_iter.h"
+#include "../src/kowhai_query.h"
+#include "../src/kowhai_seqlock.h"
+#include "../src/kowhai_rcu.h"
+#include "../src/kowhai_atomic.h"
+#include "../src/kowhai_subscribe.h"
+#include "../src/kowhai_transaction.h"
+#include "../src/kowhai_snapshot.h"
+#include "../src/kowhai_symbols.h"
+#include "../src/kowhai_image.h"
+#include "../src/kowhai_journal.h"
+#include "../src/kowhai_shm.h"
 #include "xpsocket.h"
 #include "beep.h"
 #include "timer.h"
+#include "shm.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,6 +41,7 @@
 //
 
 #include "symbols.h"
+#include "settings_desc.h"
 
 //
 // settings tree descriptor
@@ -322,6 +338,15 @@ union kowhai_symbol_t symbols19[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_UNIONCONTAI
 union kowhai_symbol_t symbols20[] = {SYM_SETTINGS, SYM_CHECK};
 union kowhai_symbol_t symbols21[] = {SYM_SETTINGS, SYM_TIMEOUT};
 union kowhai_symbol_t symbols22[] = {SYM_SETTINGS, SYM_TEMP};
+union kowhai_symbol_t symbols23[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 1), KOWHAI_SYMBOL(SYM_UNION, 1), SYM_PARTS, SYM_PART2};
+
+// all the valid settings tree paths above
+union kowhai_symbol_t* settings_paths[] = {symbols1, symbols2, symbols3, symbols6, symbols7, symbols8, symbols9, symbols10, symbols11, symbols12, symbols13,
+    symbols14, symbols15, symbols16, symbols17, symbols18, symbols19, symbols20, symbols21, symbols22, symbols23};
+int settings_path_lengths[] = {COUNT_OF(symbols1), COUNT_OF(symbols2), COUNT_OF(symbols3), COUNT_OF(symbols6), COUNT_OF(symbols7), COUNT_OF(symbols8),
+    COUNT_OF(symbols9), COUNT_OF(symbols10), COUNT_OF(symbols11), COUNT_OF(symbols12), COUNT_OF(symbols13), COUNT_OF(symbols14),
+    COUNT_OF(symbols15), COUNT_OF(symbols16), COUNT_OF(symbols17), COUNT_OF(symbols18), COUNT_OF(symbols19), COUNT_OF(symbols20),
+    COUNT_OF(symbols21), COUNT_OF(symbols22), COUNT_OF(symbols23)};
 
 void core_tests()
 {
@@ -342,7 +367,7 @@ void core_tests()
     struct flux_capacitor_t flux_capacitor = {"empty", 1, 2, 10, 20, 30, 40, 50, 60};
 
     // test version
-    assert(kowhai_version() == 6);
+    assert((kowhai_version() & 0xFFFF) == 7);
 
     // test tree parsing
     printf("test kowhai_get_node...\t\t\t");
@@ -655,10 +680,8 @@ void diff_tests()
     printf("kowhai_diff tests!\n");
 
     // init trees
-    tree_left.desc = test_descriptor;
-    tree_left.data = &settings1;
-    tree_right.desc = test_descriptor;
-    tree_right.data = &settings2;
+    kowhai_tree_init(&tree_left, test_descriptor, &settings1);
+    kowhai_tree_init(&tree_right, test_descriptor, &settings2);
 
     // tests
     memcpy(&settings2, &settings1, sizeof(struct test_settings_t));
@@ -859,6 +882,1640 @@ void create_symbol_path_tests()
     printf(" passed!\n");
 }
 
+void path_index_tests()
+{
+#define PATH_INDEX_SIZE 128
+    struct kowhai_path_index_entry_t entries[PATH_INDEX_SIZE];
+    struct kowhai_path_index_t index;
+    union kowhai_symbol_t bad_index[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, FLUX_CAP_COUNT), SYM_GAIN};
+    int i, count, offset, index_offset;
+    struct kowhai_node_t *node, *index_node;
+
+    printf("test kowhai_path_index...\t\t");
+
+    assert(kowhai_path_index_get_entry_count(settings_descriptor, &count) == KOW_STATUS_OK);
+    // settings + fluxcap + its leafs per item + oven and its leafs + unioncontainer + (union + its nodes per item + check) per item + root leafs
+    assert(count == 1 + 1 + 4 * FLUX_CAP_COUNT + 3 + 1 + (1 + (5 + 2) * UNION_COUNT + 1) * UNION_COUNT + 3);
+    assert(kowhai_path_index_init(&index, settings_descriptor, entries, count - 1) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_path_index_init(&index, settings_descriptor, entries, count) == KOW_STATUS_OK);
+    assert(index.used_count == count);
+    assert(kowhai_path_index_init(&index, settings_descriptor, entries, PATH_INDEX_SIZE) == KOW_STATUS_OK);
+
+    // every path should resolve exactly like kowhai_get_node
+    for (i = 0; i < COUNT_OF(settings_paths); i++)
+    {
+        assert(kowhai_get_node(settings_descriptor, settings_path_lengths[i], settings_paths[i], &offset, &node) == KOW_STATUS_OK);
+        assert(kowhai_path_index_get_node(&index, settings_path_lengths[i], settings_paths[i], &index_offset, &index_node) == KOW_STATUS_OK);
+        assert(offset == index_offset);
+        assert(node == index_node);
+    }
+    assert(kowhai_path_index_get_node(&index, 2, symbols4, &offset, &node) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_path_index_get_node(&index, 2, symbols5, &offset, &node) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_path_index_get_node(&index, COUNT_OF(bad_index), bad_index, &offset, &node) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_path_index_get_node(&index, 1, &symbols1[1], &offset, &node) == KOW_STATUS_INVALID_SYMBOL_PATH);
+
+    printf(" passed!\n");
+}
+
+void offset_index_tests()
+{
+#define OFFSET_INDEX_LEAVES 64
+#define OFFSET_INDEX_BRANCHES 32
+    struct kowhai_node_t union_descriptor[] =
+    {
+        { KOW_BRANCH_START,     SYM_SETTINGS,       1,                0 },
+        { KOW_BRANCH_U_START,   SYM_UNION,          1,                0 },
+        { KOW_BRANCH_START,     SYM_PARTS,          1,                0 },
+        { KOW_INT8,             SYM_PART1,          1,                0 },
+        { KOW_INT8,             SYM_PART2,          1,                0 },
+        { KOW_BRANCH_END,       SYM_PARTS,          0,                0 },
+        { KOW_INT8,             SYM_OWNER,          2,                0 },
+        { KOW_BRANCH_END,       SYM_UNION,          0,                0 },
+        { KOW_BRANCH_END,       SYM_SETTINGS,       0,                0 },
+    };
+    struct kowhai_offset_index_leaf_t leaves[OFFSET_INDEX_LEAVES];
+    struct kowhai_offset_index_branch_t branches[OFFSET_INDEX_BRANCHES];
+    struct kowhai_offset_index_t index;
+    union kowhai_symbol_t path[8], index_path[8];
+    int i, leaf_count, branch_count, offset, path_len, index_path_len;
+    struct kowhai_node_t *node;
+
+    printf("test kowhai_offset_index...\t\t");
+
+    assert(kowhai_offset_index_get_entry_count(settings_descriptor, &leaf_count, &branch_count) == KOW_STATUS_OK);
+    // fluxcap leafs per item + oven leafs + ((union leafs + parts leafs) per union item + check) per container item + root leafs
+    assert(leaf_count == 4 * FLUX_CAP_COUNT + 2 + ((4 + 2) * UNION_COUNT + 1) * UNION_COUNT + 3);
+    // settings + fluxcap items + oven + (container item + (union item + parts) per union item) per container item
+    assert(branch_count == 1 + FLUX_CAP_COUNT + 1 + (1 + 2 * UNION_COUNT) * UNION_COUNT);
+    assert(kowhai_offset_index_init(&index, settings_descriptor, leaves, leaf_count - 1, branches, branch_count) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_offset_index_init(&index, settings_descriptor, leaves, leaf_count, branches, branch_count - 1) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_offset_index_init(&index, settings_descriptor, leaves, leaf_count, branches, branch_count) == KOW_STATUS_OK);
+    assert(index.leaf_count == leaf_count && index.branch_count == branch_count);
+
+    // every byte maps to the item that covers it
+    for (i = 0; i < (int)sizeof(settings); i++)
+    {
+        index_path_len = COUNT_OF(index_path);
+        assert(kowhai_offset_index_get_path(&index, i, index_path, &index_path_len) == KOW_STATUS_OK);
+        assert(kowhai_get_node(settings_descriptor, index_path_len, index_path, &offset, &node) == KOW_STATUS_OK);
+        assert(offset <= i && i < offset + kowhai_get_node_type_size(node->type));
+        // kowhai_create_symbol_path2 gives the last union member starting before the location even if it is too short to cover it
+        if (index_path_len > 2 && index_path[2].parts.name == SYM_UNION)
+            continue;
+        path_len = COUNT_OF(path);
+        assert(kowhai_create_symbol_path2(&settings_tree, (char*)&settings + i, path, &path_len) == KOW_STATUS_OK);
+        assert(path_len == index_path_len && memcmp(path, index_path, path_len * sizeof(union kowhai_symbol_t)) == 0);
+    }
+
+    // union members overlap, the last member covering the offset is used
+    index_path_len = COUNT_OF(index_path);
+    assert(kowhai_offset_index_get_path(&index, (char*)&settings.union_container[1].union_[1].owner[5] - (char*)&settings, index_path, &index_path_len) == KOW_STATUS_OK);
+    assert(index_path_len == 4);
+    assert(index_path[1].symbol == KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 1));
+    assert(index_path[2].symbol == KOWHAI_SYMBOL(SYM_UNION, 1));
+    assert(index_path[3].symbol == KOWHAI_SYMBOL(SYM_OWNER, 5));
+    index_path_len = COUNT_OF(index_path);
+    assert(kowhai_offset_index_get_path(&index, (char*)&settings.union_container[0].union_[0] - (char*)&settings, index_path, &index_path_len) == KOW_STATUS_OK);
+    assert(index_path_len == 5);
+    assert(index_path[3].symbol == KOWHAI_SYMBOL(SYM_PARTS, 0));
+    assert(index_path[4].symbol == KOWHAI_SYMBOL(SYM_PART1, 0));
+
+    // a union member that is a branch has leaves that start after later members
+    assert(kowhai_offset_index_init(&index, union_descriptor, leaves, COUNT_OF(leaves), branches, COUNT_OF(branches)) == KOW_STATUS_OK);
+    for (i = 0; i < 2; i++)
+    {
+        index_path_len = COUNT_OF(index_path);
+        assert(kowhai_offset_index_get_path(&index, i, index_path, &index_path_len) == KOW_STATUS_OK);
+        assert(index_path_len == 3 && index_path[2].symbol == KOWHAI_SYMBOL(SYM_OWNER, i));
+    }
+    assert(kowhai_offset_index_init(&index, settings_descriptor, leaves, leaf_count, branches, branch_count) == KOW_STATUS_OK);
+
+    // outside the tree data
+    index_path_len = COUNT_OF(index_path);
+    assert(kowhai_offset_index_get_path(&index, sizeof(settings), index_path, &index_path_len) == KOW_STATUS_NOT_FOUND);
+    assert(kowhai_offset_index_get_path(&index, -1, index_path, &index_path_len) == KOW_STATUS_NOT_FOUND);
+    index_path_len = 3;
+    assert(kowhai_offset_index_get_path(&index, (char*)&settings.union_container[1].check - (char*)&settings, index_path, &index_path_len) == KOW_STATUS_OK);
+    index_path_len = 2;
+    assert(kowhai_offset_index_get_path(&index, (char*)&settings.union_container[1].union_[1].owner[5] - (char*)&settings, index_path, &index_path_len) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+
+    printf(" passed!\n");
+}
+
+void node_tables_tests()
+{
+#define NODE_TABLES_SIZE COUNT_OF(settings_descriptor)
+    int32_t sizes[NODE_TABLES_SIZE], node_counts[NODE_TABLES_SIZE], data_offsets[NODE_TABLES_SIZE];
+    struct kowhai_node_tables_t tables;
+    int i, size, count, offset, tables_size, tables_count, tables_offset;
+    struct kowhai_node_t *node, *tables_node;
+
+    printf("test kowhai_node_tables...\t\t");
+
+    assert(kowhai_init_node_tables(&tables, settings_descriptor, NODE_TABLES_SIZE - 1, sizes, node_counts, data_offsets) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_init_node_tables(&tables, settings_descriptor, NODE_TABLES_SIZE, sizes, node_counts, data_offsets) == KOW_STATUS_OK);
+    assert(tables.num_nodes == NODE_TABLES_SIZE);
+
+    // the tables should match the recursive calculations for every node
+    for (i = 0; i < NODE_TABLES_SIZE; i++)
+    {
+        if (settings_descriptor[i].type == KOW_BRANCH_END)
+            continue;
+        assert(kowhai_get_node_size(&settings_descriptor[i], &size) == KOW_STATUS_OK);
+        assert(kowhai_get_node_size_from_tables(&tables, &settings_descriptor[i], &tables_size) == KOW_STATUS_OK);
+        assert(size == tables_size);
+        assert(kowhai_get_node_count(&settings_descriptor[i], &count) == KOW_STATUS_OK);
+        assert(kowhai_get_node_count_from_tables(&tables, &settings_descriptor[i], &tables_count) == KOW_STATUS_OK);
+        assert(count == tables_count);
+    }
+    assert(kowhai_get_node_size_from_tables(&tables, &shadow_descriptor[0], &tables_size) == KOW_STATUS_INVALID_DESCRIPTOR);
+    assert(data_offsets[5] == offsetof(struct settings_data_t, flux_capacitor[0].coefficient));
+    assert(data_offsets[9] == offsetof(struct settings_data_t, oven.timeout));
+    assert(data_offsets[22] == offsetof(struct settings_data_t, union_container[0].check));
+
+    // and lookups should match kowhai_get_node
+    for (i = 0; i < COUNT_OF(settings_paths); i++)
+    {
+        assert(kowhai_get_node(settings_descriptor, settings_path_lengths[i], settings_paths[i], &offset, &node) == KOW_STATUS_OK);
+        assert(kowhai_get_node_from_tables(&tables, settings_path_lengths[i], settings_paths[i], &tables_offset, &tables_node) == KOW_STATUS_OK);
+        assert(offset == tables_offset);
+        assert(node == tables_node);
+    }
+    assert(kowhai_get_node_from_tables(&tables, 2, symbols4, &offset, &node) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_get_node_from_tables(&tables, 2, symbols5, &offset, &node) == KOW_STATUS_INVALID_SYMBOL_PATH);
+
+    printf(" passed!\n");
+}
+
+void handle_tests()
+{
+    struct kowhai_handle_t gain_handle, coeff_handle, owner_handle;
+    struct kowhai_tree_t other_tree = {shadow_descriptor, &settings};
+    uint32_t gain;
+    float coeff[COEFF_COUNT];
+    int8_t int8;
+
+    printf("test kowhai_handle_xxx...\t\t");
+
+    assert(kowhai_handle_resolve(&settings_tree, 2, symbols4, &gain_handle) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_handle_resolve(&settings_tree, COUNT_OF(symbols8), symbols8, &gain_handle) == KOW_STATUS_OK);
+    assert(kowhai_handle_resolve(&settings_tree, COUNT_OF(symbols9), symbols9, &coeff_handle) == KOW_STATUS_OK);
+    assert(kowhai_handle_resolve(&settings_tree, COUNT_OF(symbols13), symbols13, &owner_handle) == KOW_STATUS_OK);
+    assert(kowhai_handle_is_valid(&settings_tree, &gain_handle));
+
+    // typed get/set
+    assert(kowhai_handle_set_int32(&settings_tree, &gain_handle, 1234) == KOW_STATUS_OK);
+    assert(settings.flux_capacitor[1].gain == 1234);
+    assert(kowhai_handle_get_int32(&settings_tree, &gain_handle, &gain) == KOW_STATUS_OK);
+    assert(gain == 1234);
+    assert(kowhai_handle_set_float(&settings_tree, &coeff_handle, 12.5f) == KOW_STATUS_OK);
+    assert(settings.flux_capacitor[1].coefficient[3] == 12.5f);
+    assert(kowhai_handle_get_float(&settings_tree, &coeff_handle, &coeff[0]) == KOW_STATUS_OK);
+    assert(coeff[0] == 12.5f);
+    assert(kowhai_handle_set_char(&settings_tree, &owner_handle, 'D') == KOW_STATUS_OK);
+    assert(settings.flux_capacitor[0].owner[3] == 'D');
+    assert(kowhai_handle_get_int8(&settings_tree, &gain_handle, &int8) == KOW_STATUS_INVALID_NODE_TYPE);
+    assert(kowhai_handle_set_double(&settings_tree, &coeff_handle, 1.0) == KOW_STATUS_INVALID_NODE_TYPE);
+
+    // read/write are limited to the remaining items in the array
+    coeff[0] = 1.0f; coeff[1] = 2.0f; coeff[2] = 3.0f;
+    assert(kowhai_handle_write(&settings_tree, &coeff_handle, 0, coeff, sizeof(float) * 3) == KOW_STATUS_OK);
+    assert(settings.flux_capacitor[1].coefficient[5] == 3.0f);
+    assert(kowhai_handle_write(&settings_tree, &coeff_handle, 0, coeff, sizeof(float) * 4) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+    assert(kowhai_handle_write(&settings_tree, &coeff_handle, -1, coeff, 1) == KOW_STATUS_INVALID_OFFSET);
+    memset(coeff, 0, sizeof(coeff));
+    assert(kowhai_handle_read(&settings_tree, &coeff_handle, sizeof(float), coeff, sizeof(float) * 2) == KOW_STATUS_OK);
+    assert(coeff[0] == 2.0f && coeff[1] == 3.0f);
+
+    // handles are stale once the tree descriptor changes
+    assert(!kowhai_handle_is_valid(&other_tree, &gain_handle));
+    assert(kowhai_handle_get_int32(&other_tree, &gain_handle, &gain) == KOW_STATUS_STALE_HANDLE);
+    assert(kowhai_handle_set_int32(&other_tree, &gain_handle, 0) == KOW_STATUS_STALE_HANDLE);
+    assert(kowhai_handle_read(&other_tree, &coeff_handle, 0, coeff, 1) == KOW_STATUS_STALE_HANDLE);
+
+    printf(" passed!\n");
+}
+
+void batch_tests()
+{
+#define BATCH_SIZE COUNT_OF(settings_paths)
+    struct kowhai_batch_item_t items[BATCH_SIZE + 2];
+    char results[BATCH_SIZE][sizeof(struct settings_data_t)];
+    char expected[sizeof(struct settings_data_t)];
+    union kowhai_symbol_t bad_index[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, FLUX_CAP_COUNT), SYM_GAIN};
+    uint32_t gains[FLUX_CAP_COUNT] = {111, 222};
+    uint16_t temp = 0;
+    int i, size;
+    struct kowhai_node_t *node;
+
+    printf("test kowhai_read_many/kowhai_write_many...\t");
+
+    // read every test path in one go and compare it to kowhai_read
+    for (i = 0; i < BATCH_SIZE; i++)
+    {
+        assert(kowhai_get_node(settings_descriptor, settings_path_lengths[i], settings_paths[i], NULL, &node) == KOW_STATUS_OK);
+        kowhai_get_node_size(node, &size);
+        items[i].num_symbols = settings_path_lengths[i];
+        items[i].symbols = settings_paths[i];
+        items[i].offset = 0;
+        items[i].buffer = results[i];
+        items[i].size = size / node->count;
+    }
+    items[BATCH_SIZE].num_symbols = COUNT_OF(bad_index);
+    items[BATCH_SIZE].symbols = bad_index;
+    items[BATCH_SIZE].offset = 0;
+    items[BATCH_SIZE].buffer = &temp;
+    items[BATCH_SIZE].size = sizeof(temp);
+    items[BATCH_SIZE + 1].num_symbols = COUNT_OF(symbols1);
+    items[BATCH_SIZE + 1].symbols = symbols1;
+    items[BATCH_SIZE + 1].offset = 0;
+    items[BATCH_SIZE + 1].buffer = &temp;
+    items[BATCH_SIZE + 1].size = 100;
+    assert(kowhai_read_many(&settings_tree, items, BATCH_SIZE) == KOW_STATUS_OK);
+    for (i = 0; i < BATCH_SIZE; i++)
+    {
+        assert(items[i].status == KOW_STATUS_OK);
+        assert(kowhai_read(&settings_tree, items[i].num_symbols, items[i].symbols, 0, expected, items[i].size) == KOW_STATUS_OK);
+        assert(memcmp(items[i].buffer, expected, items[i].size) == 0);
+    }
+    assert(kowhai_read_many(&settings_tree, items, BATCH_SIZE + 2) != KOW_STATUS_OK);
+    for (i = 0; i < BATCH_SIZE + 2; i++)
+    {
+        if (items[i].symbols == bad_index)
+            assert(items[i].status == KOW_STATUS_INVALID_SYMBOL_PATH);
+        else if (items[i].size == 100)
+            assert(items[i].status == KOW_STATUS_NODE_DATA_TOO_SMALL);
+        else
+            assert(items[i].status == KOW_STATUS_OK);
+    }
+
+    // write both flux capacitor gains
+    items[0].num_symbols = COUNT_OF(symbols8);
+    items[0].symbols = symbols8;
+    items[0].offset = 0;
+    items[0].buffer = &gains[1];
+    items[0].size = sizeof(uint32_t);
+    items[1].num_symbols = COUNT_OF(symbols6);
+    items[1].symbols = symbols6;
+    items[1].offset = 0;
+    items[1].buffer = &gains[0];
+    items[1].size = sizeof(uint32_t);
+    assert(kowhai_write_many(&settings_tree, items, 2) == KOW_STATUS_OK);
+    assert(settings.flux_capacitor[0].gain == 111);
+    assert(settings.flux_capacitor[1].gain == 222);
+
+    printf(" passed!\n");
+}
+
+#define MAX_DIFF_RECORDS 64
+struct diff_record_t
+{
+    const struct kowhai_node_t *left_node;
+    void *left_data;
+    const struct kowhai_node_t *right_node;
+    void *right_data;
+    int index;
+    int depth;
+};
+struct diff_records_t
+{
+    struct diff_record_t records[MAX_DIFF_RECORDS];
+    int count;
+};
+
+int record_diff(void* param, const struct kowhai_node_t *left_node, void *left_data, const struct kowhai_node_t *right_node, void *right_data, int index, int depth)
+{
+    struct diff_records_t *diffs = (struct diff_records_t *)param;
+    struct diff_record_t *record;
+    assert(diffs->count < MAX_DIFF_RECORDS);
+    record = &diffs->records[diffs->count++];
+    record->left_node = left_node;
+    record->left_data = left_data;
+    record->right_node = right_node;
+    record->right_data = right_data;
+    record->index = index;
+    record->depth = depth;
+    return KOW_STATUS_OK;
+}
+
+void gather_tests()
+{
+    union kowhai_symbol_t gain_path[] = {SYM_SETTINGS, SYM_FLUXCAPACITOR, SYM_GAIN};
+    union kowhai_symbol_t coeff_path[] = {SYM_SETTINGS, SYM_FLUXCAPACITOR, KOWHAI_SYMBOL(SYM_COEFFICIENT, 3)};
+    union kowhai_symbol_t check_path[] = {SYM_SETTINGS, SYM_UNIONCONTAINER, SYM_CHECK};
+    union kowhai_symbol_t union_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 1), SYM_UNION, SYM_TEMP};
+    union kowhai_symbol_t second_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), SYM_FREQUENCY};
+    uint32_t gains[FLUX_CAP_COUNT] = {1234, 5678}, u32s[FLUX_CAP_COUNT];
+    float coeffs[FLUX_CAP_COUNT];
+    int16_t temps[UNION_COUNT] = {-5, 77};
+    int i;
+
+    printf("test kowhai_gather/kowhai_scatter...\t");
+
+    // scatter then gather one leaf across every flux capacitor
+    assert(kowhai_scatter(&settings_tree, COUNT_OF(gain_path), gain_path, 1, gains, FLUX_CAP_COUNT) == KOW_STATUS_OK);
+    for (i = 0; i < FLUX_CAP_COUNT; i++)
+        assert(settings.flux_capacitor[i].gain == gains[i]);
+    for (i = 0; i < FLUX_CAP_COUNT; i++)
+        settings.flux_capacitor[i].gain = i + 1;
+    assert(kowhai_gather(&settings_tree, COUNT_OF(gain_path), gain_path, 1, u32s, FLUX_CAP_COUNT) == KOW_STATUS_OK);
+    for (i = 0; i < FLUX_CAP_COUNT; i++)
+        assert(u32s[i] == (uint32_t)(i + 1));
+
+    // an item of a leaf array and a gather starting part way through the branch array
+    for (i = 0; i < FLUX_CAP_COUNT; i++)
+        settings.flux_capacitor[i].coefficient[3] = 0.5f * i;
+    assert(kowhai_gather(&settings_tree, COUNT_OF(coeff_path), coeff_path, 1, coeffs, FLUX_CAP_COUNT) == KOW_STATUS_OK);
+    for (i = 0; i < FLUX_CAP_COUNT; i++)
+        assert(coeffs[i] == 0.5f * i);
+    settings.flux_capacitor[1].frequency = 99;
+    assert(kowhai_gather(&settings_tree, COUNT_OF(second_path), second_path, 1, u32s, 1) == KOW_STATUS_OK);
+    assert(u32s[0] == 99);
+    assert(kowhai_gather(&settings_tree, COUNT_OF(second_path), second_path, 1, u32s, 2) == KOW_STATUS_INVALID_OFFSET);
+
+    // stepping through union arrays and deeper branches
+    assert(kowhai_scatter(&settings_tree, COUNT_OF(union_path), union_path, 2, temps, UNION_COUNT) == KOW_STATUS_OK);
+    for (i = 0; i < UNION_COUNT; i++)
+        assert(settings.union_container[1].union_[i].temp == temps[i]);
+    for (i = 0; i < UNION_COUNT; i++)
+        settings.union_container[i].check = 10 * i;
+    assert(kowhai_gather(&settings_tree, COUNT_OF(check_path), check_path, 1, u32s, UNION_COUNT) == KOW_STATUS_OK);
+    for (i = 0; i < UNION_COUNT; i++)
+        assert(u32s[i] == (uint32_t)(10 * i));
+
+    // the branch index must pick a branch above the leaf
+    assert(kowhai_gather(&settings_tree, COUNT_OF(gain_path), gain_path, 2, u32s, 1) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_gather(&settings_tree, COUNT_OF(gain_path), gain_path, -1, u32s, 1) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_gather(&settings_tree, 2, gain_path, 1, u32s, 1) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_gather(&settings_tree, COUNT_OF(gain_path), gain_path, 1, u32s, FLUX_CAP_COUNT + 1) == KOW_STATUS_INVALID_OFFSET);
+
+    printf(" passed!\n");
+}
+
+void query_tests()
+{
+#define QUERY_RUNS 8
+    const char *coeffs_str = "Settings.FluxCapacitor[*].Coefficient[2:5]";
+    const char *checks_str = "Settings.UnionContainer[:].Check";
+    const char *temps_str = "Settings.UnionContainer[1:].Union[*].Temp";
+    struct kowhai_query_symbol_t query_path[8];
+    struct kowhai_query_run_t runs[QUERY_RUNS];
+    struct kowhai_query_t query;
+    float coeffs[FLUX_CAP_COUNT * 3];
+    uint32_t checks[UNION_COUNT];
+    int16_t temps[UNION_COUNT] = {321, -123};
+    int i, j, len;
+
+    printf("test kowhai_query...\t\t\t");
+
+    // parsing
+    len = COUNT_OF(query_path);
+    assert(kowhai_str_to_query(coeffs_str, strlen(coeffs_str), query_path, &len, NULL, get_symbol_index) == KOW_STATUS_OK);
+    assert(len == 3);
+    assert(query_path[0].name == SYM_SETTINGS && query_path[0].start == 0 && query_path[0].end == 1);
+    assert(query_path[1].name == SYM_FLUXCAPACITOR && query_path[1].start == 0 && query_path[1].end == KOWHAI_QUERY_END);
+    assert(query_path[2].name == SYM_COEFFICIENT && query_path[2].start == 2 && query_path[2].end == 5);
+    len = 2;
+    assert(kowhai_str_to_query(coeffs_str, strlen(coeffs_str), query_path, &len, NULL, get_symbol_index) == KOW_STATUS_PATH_TOO_SMALL);
+
+    // a slice of a leaf array in every branch array item is a contiguous run per branch item
+    len = COUNT_OF(query_path);
+    assert(kowhai_str_to_query(coeffs_str, strlen(coeffs_str), query_path, &len, NULL, get_symbol_index) == KOW_STATUS_OK);
+    assert(kowhai_query_compile(&query, settings_descriptor, query_path, len, runs, 1) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(query.num_runs == 1 && query.runs_needed == FLUX_CAP_COUNT);
+    assert(kowhai_query_read(&query, &settings_tree, coeffs, sizeof(coeffs)) == KOW_STATUS_INVALID_SEQUENCE);
+    assert(kowhai_query_write(&query, &settings_tree, coeffs, sizeof(coeffs)) == KOW_STATUS_INVALID_SEQUENCE);
+    assert(kowhai_query_compile(&query, settings_descriptor, query_path, len, runs, QUERY_RUNS) == KOW_STATUS_OK);
+    assert(query.num_runs == FLUX_CAP_COUNT && query.size == sizeof(coeffs));
+    for (i = 0; i < FLUX_CAP_COUNT; i++)
+    {
+        assert(runs[i].count == 3 && runs[i].type == KOW_FLOAT);
+        for (j = 0; j < COEFF_COUNT; j++)
+            settings.flux_capacitor[i].coefficient[j] = 10.0f * i + j;
+    }
+    assert(kowhai_query_read(&query, &settings_tree, coeffs, sizeof(coeffs) - 1) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_query_read(&query, &settings_tree, coeffs, sizeof(coeffs)) == KOW_STATUS_OK);
+    for (i = 0; i < FLUX_CAP_COUNT; i++)
+        for (j = 0; j < 3; j++)
+            assert(coeffs[i * 3 + j] == 10.0f * i + j + 2);
+
+    // a single leaf in every branch array item is one strided run
+    len = COUNT_OF(query_path);
+    assert(kowhai_str_to_query(checks_str, strlen(checks_str), query_path, &len, NULL, get_symbol_index) == KOW_STATUS_OK);
+    assert(kowhai_query_compile(&query, settings_descriptor, query_path, len, runs, QUERY_RUNS) == KOW_STATUS_OK);
+    assert(query.num_runs == 1 && runs[0].count == UNION_COUNT && runs[0].stride == sizeof(struct union_container_t));
+    for (i = 0; i < UNION_COUNT; i++)
+        checks[i] = 1000 + i;
+    assert(kowhai_query_write(&query, &settings_tree, checks, sizeof(checks)) == KOW_STATUS_OK);
+    for (i = 0; i < UNION_COUNT; i++)
+        assert(settings.union_container[i].check == (uint32_t)(1000 + i));
+
+    // union arrays
+    len = COUNT_OF(query_path);
+    assert(kowhai_str_to_query(temps_str, strlen(temps_str), query_path, &len, NULL, get_symbol_index) == KOW_STATUS_OK);
+    assert(kowhai_query_compile(&query, settings_descriptor, query_path, len, runs, QUERY_RUNS) == KOW_STATUS_OK);
+    assert(kowhai_query_write(&query, &settings_tree, temps, sizeof(temps)) == KOW_STATUS_OK);
+    for (i = 0; i < UNION_COUNT; i++)
+        assert(settings.union_container[1].union_[i].temp == temps[i]);
+
+    // bad queries
+    query_path[1].end = UNION_COUNT + 1;
+    assert(kowhai_query_compile(&query, settings_descriptor, query_path, len, runs, QUERY_RUNS) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    query_path[1].start = 1;
+    query_path[1].end = 1;
+    assert(kowhai_query_compile(&query, settings_descriptor, query_path, len, runs, QUERY_RUNS) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    query_path[1].end = KOWHAI_QUERY_END;
+    assert(kowhai_query_compile(&query, settings_descriptor, query_path, 2, runs, QUERY_RUNS) == KOW_STATUS_INVALID_NODE_TYPE);
+    assert(kowhai_query_read(&query, &settings_tree, temps, sizeof(temps)) == KOW_STATUS_INVALID_SEQUENCE);
+    assert(kowhai_query_compile(&query, settings_descriptor, query_path, len, runs, QUERY_RUNS) == KOW_STATUS_OK);
+    assert(kowhai_query_read(&query, &shadow_tree, temps, sizeof(temps)) == KOW_STATUS_INVALID_DESCRIPTOR);
+
+    printf(" passed!\n");
+}
+
+void seqlock_tests()
+{
+    struct kowhai_seqlock_t locks[8];
+    struct kowhai_seqlock_set_t set;
+    union kowhai_symbol_t gain_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), SYM_GAIN};
+    int oven_offset = offsetof(struct settings_data_t, oven);
+    uint32_t gain = 4321, result;
+    uint32_t sequence;
+    int count;
+
+    printf("test kowhai_seqlock...\t\t\t");
+
+    // settings has a lock for each of fluxcapacitor, oven, unioncontainer, check, timeout and temp
+    assert(kowhai_seqlock_get_branch_count(settings_descriptor, &count) == KOW_STATUS_OK);
+    assert(count == 6);
+    assert(kowhai_seqlock_init(&set, settings_descriptor, locks, 2) == KOW_STATUS_BUFFER_INVALID);
+    assert(kowhai_seqlock_init(&set, settings_descriptor, locks, count) == KOW_STATUS_OK);
+    assert(locks[0].end == sizeof(settings.flux_capacitor));
+    assert(locks[count - 1].end == sizeof(settings));
+
+    // a write makes readers of the same branch retry but not readers of other branches
+    sequence = kowhai_seqlock_read_begin(&set, oven_offset, sizeof(settings.oven));
+    kowhai_seqlock_write_begin(&set, 0, sizeof(settings.flux_capacitor[0]));
+    assert(locks[0].sequence & 1);
+    kowhai_seqlock_write_end(&set, 0, sizeof(settings.flux_capacitor[0]));
+    assert(!kowhai_seqlock_read_retry(&set, oven_offset, sizeof(settings.oven), sequence));
+    kowhai_seqlock_write_begin(&set, oven_offset - 1, 2);
+    assert((locks[0].sequence & 1) && (locks[1].sequence & 1) && !(locks[2].sequence & 1));
+    kowhai_seqlock_write_end(&set, oven_offset - 1, 2);
+    assert(kowhai_seqlock_read_retry(&set, oven_offset, sizeof(settings.oven), sequence));
+
+    // locked reads and writes behave like kowhai_read and kowhai_write
+    assert(kowhai_seqlock_write(&set, &settings_tree, COUNT_OF(gain_path), gain_path, 0, &gain, sizeof(gain)) == KOW_STATUS_OK);
+    assert(settings.flux_capacitor[1].gain == gain);
+    assert(kowhai_seqlock_read(&set, &settings_tree, COUNT_OF(gain_path), gain_path, 0, &result, sizeof(result)) == KOW_STATUS_OK);
+    assert(result == gain);
+    assert(!(locks[0].sequence & 1));
+    assert(kowhai_seqlock_read(&set, &settings_tree, COUNT_OF(gain_path), gain_path, 1, &result, sizeof(result)) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+
+    // a single lock for the whole tree
+    assert(kowhai_seqlock_init(&set, settings_descriptor, locks, 1) == KOW_STATUS_OK);
+    assert(locks[0].end == sizeof(settings));
+    sequence = kowhai_seqlock_read_begin(&set, oven_offset, sizeof(settings.oven));
+    assert(kowhai_seqlock_write(&set, &settings_tree, COUNT_OF(gain_path), gain_path, 0, &gain, sizeof(gain)) == KOW_STATUS_OK);
+    assert(kowhai_seqlock_read_retry(&set, oven_offset, sizeof(settings.oven), sequence));
+
+    printf(" passed!\n");
+}
+
+int rcu_send_packet(pkowhai_protocol_server_t server, void* param, void* packet, size_t packet_size, struct kowhai_protocol_t* protocol)
+{
+    *(int*)param = protocol->header.command;
+    return 0;
+}
+
+static uint32_t rcu_function_gain;
+int rcu_function_called(pkowhai_protocol_server_t server, void* param, uint16_t function_id)
+{
+    // the function sees all of its input at once
+    struct settings_data_t *data = kowhai_rcu_get_data((struct kowhai_rcu_tree_t*)param);
+    rcu_function_gain = data->flux_capacitor[1].gain;
+    return 1;
+}
+
+void rcu_tests()
+{
+    static struct settings_data_t buffers[3];
+    void* buffer_list[3] = {&buffers[0], &buffers[1], &buffers[2]};
+    volatile uint32_t readers[2];
+    struct kowhai_rcu_tree_t rcu;
+    struct settings_data_t *data, *old_data, *shadow;
+    union kowhai_symbol_t gain_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), SYM_GAIN};
+    struct kowhai_protocol_server_tree_item_t rcu_tree_list[] = {
+        { KOW_TREE_ID(SYM_SETTINGS), settings_descriptor, sizeof(settings_descriptor), NULL, NULL, &rcu },
+    };
+    struct kowhai_protocol_id_list_item_t rcu_tree_id_list[COUNT_OF(rcu_tree_list)];
+    struct kowhai_protocol_server_function_item_t rcu_function_list[] = {
+        { KOW_FUNCTION_ID(SYM_START),           {SYM_SETTINGS, KOW_UNDEFINED_SYMBOL} },
+    };
+    struct kowhai_protocol_id_list_item_t rcu_function_id_list[COUNT_OF(rcu_function_list)];
+    struct settings_data_t input;
+    struct kowhai_protocol_server_t server;
+    char packet_buffer[MAX_PACKET_SIZE], packet[MAX_PACKET_SIZE];
+    struct kowhai_protocol_t prot;
+    uint32_t gain = 0x11223344;
+    int i, command, bytes_required;
+
+    printf("test kowhai_rcu...\t\t\t");
+
+    memset(buffers, 0, sizeof(buffers));
+    assert(kowhai_rcu_init(&rcu, settings_descriptor, buffer_list, 1, readers, COUNT_OF(readers)) == KOW_STATUS_BUFFER_INVALID);
+    assert(kowhai_rcu_init(&rcu, settings_descriptor, buffer_list, 3, readers, COUNT_OF(readers)) == KOW_STATUS_OK);
+    assert(kowhai_rcu_publish(&rcu) == KOW_STATUS_INVALID_SEQUENCE);
+
+    // writes to the shadow copy are not seen until they are published
+    old_data = kowhai_rcu_read_lock(&rcu, 0);
+    assert(old_data == &buffers[0]);
+    old_data->oven.temp = 10;
+    assert(kowhai_rcu_write_begin(&rcu, (void**)&shadow) == KOW_STATUS_OK);
+    assert(shadow != old_data && shadow->oven.temp == 10);
+    shadow->oven.temp = 20;
+    assert(kowhai_rcu_write_begin(&rcu, (void**)&data) == KOW_STATUS_OK && data == shadow);
+    data = kowhai_rcu_read_lock(&rcu, 1);
+    assert(data == old_data);
+    kowhai_rcu_read_unlock(&rcu, 1);
+    assert(kowhai_rcu_publish(&rcu) == KOW_STATUS_OK);
+    data = kowhai_rcu_read_lock(&rcu, 1);
+    assert(data == shadow && data->oven.temp == 20);
+    kowhai_rcu_read_unlock(&rcu, 1);
+
+    // the buffer reader 0 is still using is not reused
+    assert(kowhai_rcu_write_begin(&rcu, (void**)&shadow) == KOW_STATUS_OK);
+    assert(shadow != old_data && shadow != kowhai_rcu_get_data(&rcu));
+    kowhai_rcu_abort(&rcu);
+    assert(old_data->oven.temp == 10);
+    kowhai_rcu_read_unlock(&rcu, 0);
+
+    // a protocol write sequence is published by KOW_CMD_WRITE_DATA_END
+    kowhai_server_init(&server, MAX_PACKET_SIZE, packet_buffer, NULL, NULL, NULL, rcu_send_packet, &command,
+        COUNT_OF(rcu_tree_list), rcu_tree_list, rcu_tree_id_list, 0, NULL, NULL, NULL, NULL, COUNT_OF(symbols), symbols);
+    old_data = kowhai_rcu_get_data(&rcu);
+    POPULATE_PROTOCOL_WRITE(prot, KOW_CMD_WRITE_DATA, SYM_SETTINGS, COUNT_OF(gain_path), gain_path, KOW_UINT32, 0, 2, &gain);
+    assert(kowhai_protocol_create(packet, MAX_PACKET_SIZE, &prot, &bytes_required) == KOW_STATUS_OK);
+    kowhai_server_process_packet(&server, packet, bytes_required);
+    assert(command == KOW_CMD_WRITE_DATA_ACK);
+    data = kowhai_rcu_get_data(&rcu);
+    assert(data == old_data && data->flux_capacitor[1].gain == 0);
+    POPULATE_PROTOCOL_WRITE(prot, KOW_CMD_WRITE_DATA_END, SYM_SETTINGS, COUNT_OF(gain_path), gain_path, KOW_UINT32, 2, 2, (char*)&gain + 2);
+    assert(kowhai_protocol_create(packet, MAX_PACKET_SIZE, &prot, &bytes_required) == KOW_STATUS_OK);
+    kowhai_server_process_packet(&server, packet, bytes_required);
+    assert(command == KOW_CMD_WRITE_DATA_ACK);
+    data = kowhai_rcu_get_data(&rcu);
+    assert(data != old_data && data->flux_capacitor[1].gain == gain && data->oven.temp == 20);
+
+    // function input in an rcu tree is published once it has all arrived
+    kowhai_server_init(&server, MAX_PACKET_SIZE, packet_buffer, NULL, NULL, NULL, rcu_send_packet, &command,
+        COUNT_OF(rcu_tree_list), rcu_tree_list, rcu_tree_id_list, COUNT_OF(rcu_function_list), rcu_function_list, rcu_function_id_list,
+        rcu_function_called, &rcu, COUNT_OF(symbols), symbols);
+    memcpy(&input, data, sizeof(input));
+    input.flux_capacitor[1].gain = gain + 1;
+    old_data = kowhai_rcu_get_data(&rcu);
+    for (i = 0; i < (int)sizeof(input); i += 32)
+    {
+        int size = sizeof(input) - i < 32 ? sizeof(input) - i : 32;
+        POPULATE_PROTOCOL_CALL_FUNCTION(prot, SYM_START, i, size, (char*)&input + i);
+        assert(kowhai_protocol_create(packet, MAX_PACKET_SIZE, &prot, &bytes_required) == KOW_STATUS_OK);
+        kowhai_server_process_packet(&server, packet, bytes_required);
+        if (i + size < (int)sizeof(input))
+        {
+            assert(command == KOW_CMD_CALL_FUNCTION_ACK);
+            assert(kowhai_rcu_get_data(&rcu) == old_data && old_data->flux_capacitor[1].gain == gain);
+        }
+    }
+    assert(command == KOW_CMD_CALL_FUNCTION_RESULT_END);
+    assert(rcu_function_gain == gain + 1);
+    data = kowhai_rcu_get_data(&rcu);
+    assert(data != old_data && memcmp(data, &input, sizeof(input)) == 0);
+
+    printf(" passed!\n");
+}
+
+void protocol32_tests()
+{
+    union kowhai_symbol_t gain_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), SYM_GAIN};
+    struct kowhai_protocol_t prot;
+    char packet[MAX_PACKET_SIZE];
+    uint32_t gain = 0x11223344;
+    int bytes_required, overhead16, overhead32;
+
+    printf("test kowhai_protocol 32 bit...\t\t");
+
+    assert(kowhai_protocol_get_command32(KOW_CMD_READ_DATA) == KOW_CMD_READ_DATA32);
+    assert(kowhai_protocol_get_command32(KOW_CMD_WRITE_DATA_END) == KOW_CMD_WRITE_DATA32_END);
+    assert(kowhai_protocol_get_command16(KOW_CMD_CALL_FUNCTION32_RESULT) == KOW_CMD_CALL_FUNCTION_RESULT);
+    assert(kowhai_protocol_get_command32(KOW_CMD_GET_TREE_LIST) == KOW_CMD_GET_TREE_LIST);
+
+    // offsets past 64 KB only fit the 32 bit commands
+    POPULATE_PROTOCOL_WRITE(prot, KOW_CMD_WRITE_DATA, SYM_SETTINGS, COUNT_OF(gain_path), gain_path, KOW_UINT32, 0x12345, sizeof(gain), &gain);
+    assert(kowhai_protocol_create(packet, MAX_PACKET_SIZE, &prot, &bytes_required) == KOW_STATUS_OUT_OF_RANGE);
+    assert(kowhai_protocol_get_overhead(&prot, &overhead16) == KOW_STATUS_OK);
+    prot.header.command = KOW_CMD_WRITE_DATA32;
+    assert(kowhai_protocol_get_overhead(&prot, &overhead32) == KOW_STATUS_OK);
+    assert(overhead32 == overhead16 + 4);
+    assert(kowhai_protocol_create(packet, MAX_PACKET_SIZE, &prot, &bytes_required) == KOW_STATUS_OK);
+    assert(bytes_required == overhead32 + (int)sizeof(gain));
+    memset(&prot, 0, sizeof(prot));
+    assert(kowhai_protocol_parse(packet, bytes_required, &prot) == KOW_STATUS_OK);
+    assert(prot.header.command == KOW_CMD_WRITE_DATA32 && prot.header.id == SYM_SETTINGS);
+    assert(prot.payload.spec.data.symbols.count == COUNT_OF(gain_path));
+    assert(prot.payload.spec.data.memory.offset == 0x12345);
+    assert(prot.payload.spec.data.memory.size == sizeof(gain));
+    assert(memcmp(prot.payload.buffer, &gain, sizeof(gain)) == 0);
+
+    printf(" passed!\n");
+}
+
+void atomic_tests()
+{
+    struct kowhai_node_t counters_descriptor[] =
+    {
+        { KOW_BRANCH_START,     SYM_STATUS,         1,                0 },
+        { KOW_INT32,            SYM_RUNNING,        1,                0 },
+        { KOW_UINT32,           SYM_DELAY,          1,                0 },
+        { KOW_INT64,            SYM_TIME,           1,                0 },
+        { KOW_UINT8,            SYM_BEEP,           1,                0 },
+        { KOW_INT32,            SYM_CHECK,          1,                0 },
+        { KOW_BRANCH_END,       SYM_STATUS,         0,                0 },
+    };
+    uint64_t counters[3];
+    struct kowhai_tree_t counters_tree = {counters_descriptor, counters};
+    union kowhai_symbol_t running_path[] = {SYM_STATUS, SYM_RUNNING};
+    union kowhai_symbol_t delay_path[] = {SYM_STATUS, SYM_DELAY};
+    union kowhai_symbol_t time_path[] = {SYM_STATUS, SYM_TIME};
+    union kowhai_symbol_t beep_path[] = {SYM_STATUS, SYM_BEEP};
+    union kowhai_symbol_t check_path[] = {SYM_STATUS, SYM_CHECK};
+    struct kowhai_snapshot_t snapshot;
+    int16_t page_map[3];
+    uint8_t pool[3 * 8];
+    struct kowhai_dirty_t dirty;
+    uint8_t dirty_bits[1];
+    int32_t i32;
+    int64_t i64;
+    int offset, size;
+
+    printf("test kowhai_atomic_xxx...\t\t");
+
+    memset(counters, 0, sizeof(counters));
+    assert(kowhai_atomic_store_int32(&counters_tree, COUNT_OF(running_path), running_path, 5) == KOW_STATUS_OK);
+    assert(kowhai_atomic_fetch_add_int32(&counters_tree, COUNT_OF(running_path), running_path, 3, &i32) == KOW_STATUS_OK);
+    assert(i32 == 5);
+    assert(kowhai_atomic_fetch_add_int32(&counters_tree, COUNT_OF(delay_path), delay_path, -1, NULL) == KOW_STATUS_OK);
+    assert(kowhai_atomic_load_int32(&counters_tree, COUNT_OF(running_path), running_path, &i32) == KOW_STATUS_OK);
+    assert(i32 == 8);
+    assert(kowhai_atomic_load_int32(&counters_tree, COUNT_OF(delay_path), delay_path, &i32) == KOW_STATUS_OK);
+    assert((uint32_t)i32 == 0xFFFFFFFF);
+    assert(kowhai_atomic_store_int64(&counters_tree, COUNT_OF(time_path), time_path, 0x100000000LL) == KOW_STATUS_OK);
+    assert(kowhai_atomic_fetch_add_int64(&counters_tree, COUNT_OF(time_path), time_path, 2, &i64) == KOW_STATUS_OK);
+    assert(i64 == 0x100000000LL);
+    assert(kowhai_atomic_load_int64(&counters_tree, COUNT_OF(time_path), time_path, &i64) == KOW_STATUS_OK);
+    assert(i64 == 0x100000002LL);
+
+    // wrong types and packed leaves that are not aligned
+    assert(kowhai_atomic_load_int32(&counters_tree, COUNT_OF(time_path), time_path, &i32) == KOW_STATUS_INVALID_NODE_TYPE);
+    assert(kowhai_atomic_load_int64(&counters_tree, COUNT_OF(running_path), running_path, &i64) == KOW_STATUS_INVALID_NODE_TYPE);
+    assert(kowhai_atomic_store_int32(&counters_tree, COUNT_OF(beep_path), beep_path, 1) == KOW_STATUS_INVALID_NODE_TYPE);
+    assert(kowhai_atomic_store_int32(&counters_tree, COUNT_OF(check_path), check_path, 1) == KOW_STATUS_MISALIGNED);
+    assert(kowhai_atomic_load_int32(&counters_tree, COUNT_OF(check_path), check_path, &i32) == KOW_STATUS_MISALIGNED);
+
+    // writes preserve the snapshot pages they change like kowhai_write
+    assert(kowhai_snapshot_create(&snapshot, &counters_tree, 8, page_map, COUNT_OF(page_map), pool, sizeof(pool)) == KOW_STATUS_OK);
+    assert(kowhai_atomic_store_int32(&counters_tree, COUNT_OF(running_path), running_path, 99) == KOW_STATUS_OK);
+    assert(snapshot.pool_used == 1);
+    assert(kowhai_snapshot_read(&snapshot, 0, &i32, sizeof(i32)) == KOW_STATUS_OK && i32 == 8);
+    assert(kowhai_atomic_fetch_add_int64(&counters_tree, COUNT_OF(time_path), time_path, 1, NULL) == KOW_STATUS_OK);
+    assert(snapshot.pool_used == 2);
+    assert(kowhai_snapshot_read(&snapshot, 8, &i64, sizeof(i64)) == KOW_STATUS_OK && i64 == 0x100000002LL);
+    kowhai_snapshot_release(&snapshot);
+
+    // and mark the blocks they change dirty
+    assert(kowhai_dirty_init(&dirty, counters_descriptor, 4, dirty_bits, sizeof(dirty_bits)) == KOW_STATUS_OK);
+    counters_tree.dirty = &dirty;
+    assert(kowhai_atomic_load_int32(&counters_tree, COUNT_OF(running_path), running_path, &i32) == KOW_STATUS_OK);
+    assert(kowhai_dirty_next(&dirty, 0, &offset, &size) == KOW_STATUS_NOT_FOUND);
+    assert(kowhai_atomic_store_int32(&counters_tree, COUNT_OF(delay_path), delay_path, 1) == KOW_STATUS_OK);
+    assert(kowhai_dirty_next(&dirty, 0, &offset, &size) == KOW_STATUS_OK && offset == 4 && size == 4);
+    assert(kowhai_atomic_fetch_add_int64(&counters_tree, COUNT_OF(time_path), time_path, 1, NULL) == KOW_STATUS_OK);
+    assert(kowhai_dirty_next(&dirty, 0, &offset, &size) == KOW_STATUS_OK && offset == 4 && size == 12);
+    counters_tree.dirty = NULL;
+
+    printf(" passed!\n");
+}
+
+void dirty_tests()
+{
+    uint8_t bits[64], chained_bits[64];
+    struct settings_data_t copy;
+    struct kowhai_dirty_t dirty, chained;
+    struct kowhai_tree_t tree = {settings_descriptor, &settings, &dirty};
+    struct kowhai_node_t *node;
+    int size, offset, temp_offset, timeout_offset, range_offset, range_size;
+    int16_t temp = 33;
+    uint16_t timeout = 0x1234;
+
+    printf("test kowhai_dirty_xxx...\t\t");
+
+    kowhai_get_node(settings_descriptor, COUNT_OF(symbols1), symbols1, &temp_offset, &node);
+    kowhai_get_node(settings_descriptor, COUNT_OF(symbols2), symbols2, &timeout_offset, &node);
+
+    // byte granularity
+    assert(kowhai_dirty_get_size(settings_descriptor, 0, &size) == KOW_STATUS_BUFFER_INVALID);
+    assert(kowhai_dirty_get_size(settings_descriptor, 1, &size) == KOW_STATUS_OK);
+    assert(size == (sizeof(settings) + 7) / 8);
+    assert(kowhai_dirty_init(&dirty, settings_descriptor, 1, bits, size - 1) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_dirty_init(&dirty, settings_descriptor, 1, bits, sizeof(bits)) == KOW_STATUS_OK);
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_NOT_FOUND);
+
+    // writes mark their leaves, adjacent leaves merge into one range
+    assert(kowhai_write(&tree, COUNT_OF(symbols1), symbols1, 0, &temp, sizeof(temp)) == KOW_STATUS_OK);
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset == temp_offset && range_size == sizeof(temp));
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, timeout) == KOW_STATUS_OK);
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset == temp_offset && range_size == sizeof(temp) + sizeof(timeout));
+    assert(kowhai_dirty_next(&dirty, range_offset + range_size, &range_offset, &range_size) == KOW_STATUS_NOT_FOUND);
+
+    // searching from inside a range and clearing part of a range
+    assert(kowhai_dirty_next(&dirty, timeout_offset, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset == timeout_offset && range_size == sizeof(timeout));
+    kowhai_dirty_clear(&dirty, temp_offset, sizeof(temp));
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset == timeout_offset && range_size == sizeof(timeout));
+    kowhai_dirty_clear(&dirty, 0, sizeof(settings));
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_NOT_FOUND);
+
+    // marking the whole tree
+    kowhai_dirty_mark(&dirty, 0, sizeof(settings));
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset == 0 && range_size == sizeof(settings));
+
+    // block granularity rounds ranges out to whole blocks (clipped to the tree size)
+    assert(kowhai_dirty_init(&dirty, settings_descriptor, 16, bits, sizeof(bits)) == KOW_STATUS_OK);
+    assert(dirty.num_blocks == (sizeof(settings) + 15) / 16);
+    offset = sizeof(settings) - 1;
+    kowhai_dirty_mark(&dirty, offset, 1);
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset == (offset / 16) * 16 && range_offset + range_size == sizeof(settings));
+    kowhai_dirty_clear(&dirty, 0, sizeof(settings));
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, timeout) == KOW_STATUS_OK);
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset <= timeout_offset && range_offset + range_size >= timeout_offset + (int)sizeof(timeout));
+    assert(range_size <= 32);
+
+    // merge marks the nodes it copies into the destination
+    assert(kowhai_dirty_init(&dirty, settings_descriptor, 1, bits, sizeof(bits)) == KOW_STATUS_OK);
+    memcpy(&copy, &settings, sizeof(settings));
+    settings.oven.temp = temp + 1;
+    {
+        struct kowhai_tree_t src = {settings_descriptor, &copy};
+        assert(kowhai_merge(&tree, &src) == KOW_STATUS_OK);
+    }
+    assert(settings.oven.temp == temp);
+    assert(kowhai_dirty_next(&dirty, 0, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset == temp_offset && range_size == sizeof(temp));
+
+    // chained bitmaps see the marks made from then on and are cleared independently
+    assert(kowhai_dirty_init(&chained, settings_descriptor, 16, chained_bits, sizeof(chained_bits)) == KOW_STATUS_OK);
+    assert(kowhai_dirty_chain(&dirty, &chained) == KOW_STATUS_OK);
+    assert(kowhai_dirty_chain(&dirty, &chained) == KOW_STATUS_OK && chained.next == NULL);
+    assert(kowhai_dirty_chain(&chained, &dirty) == KOW_STATUS_BUFFER_INVALID);
+    assert(kowhai_dirty_next(&chained, 0, &range_offset, &range_size) == KOW_STATUS_NOT_FOUND);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, timeout) == KOW_STATUS_OK);
+    kowhai_dirty_clear(&dirty, 0, sizeof(settings));
+    assert(kowhai_dirty_next(&chained, 0, &range_offset, &range_size) == KOW_STATUS_OK);
+    assert(range_offset <= timeout_offset && range_offset + range_size >= timeout_offset + (int)sizeof(timeout));
+    kowhai_dirty_clear(&chained, 0, sizeof(settings));
+    assert(kowhai_dirty_unchain(&dirty, &chained) == KOW_STATUS_OK);
+    assert(kowhai_dirty_unchain(&dirty, &chained) == KOW_STATUS_NOT_FOUND);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, timeout) == KOW_STATUS_OK);
+    assert(kowhai_dirty_next(&chained, 0, &range_offset, &range_size) == KOW_STATUS_NOT_FOUND);
+
+    printf(" passed!\n");
+}
+
+struct change_record_t
+{
+    int calls;
+    int offset;
+    int size;
+};
+
+void on_change_record(void* param, struct kowhai_tree_t *tree, int offset, int size)
+{
+    struct change_record_t *record = (struct change_record_t*)param;
+    record->calls++;
+    record->offset = offset;
+    record->size = size;
+}
+
+void subscribe_tests()
+{
+    uint8_t bits[64];
+    struct kowhai_dirty_t dirty;
+    struct kowhai_tree_t tree = {settings_descriptor, &settings, &dirty};
+    struct kowhai_subscription_t subs[2];
+    struct kowhai_subscriptions_t subscriptions;
+    struct change_record_t oven = {0}, flux = {0};
+    union kowhai_symbol_t flux_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1)};
+    union kowhai_symbol_t gain_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), SYM_GAIN};
+    union kowhai_symbol_t gain0_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 0), SYM_GAIN};
+    int oven_id, flux_id, id, offset;
+
+    printf("test kowhai_subscribe...\t\t");
+
+    assert(kowhai_subscriptions_init(&subscriptions, &settings_tree, NULL, subs, COUNT_OF(subs), 10) == KOW_STATUS_BUFFER_INVALID);
+    assert(kowhai_dirty_init(&dirty, settings_descriptor, 1, bits, sizeof(bits)) == KOW_STATUS_OK);
+    assert(kowhai_subscriptions_init(&subscriptions, &tree, NULL, subs, COUNT_OF(subs), 10) == KOW_STATUS_OK);
+    assert(!kowhai_subscriptions_watched(&subscriptions, 0, sizeof(settings)));
+
+    // subscribe to a subtree and to the second item of a branch array
+    assert(kowhai_subscribe(&subscriptions, COUNT_OF(symbols11), symbols11, on_change_record, &oven, &oven_id) == KOW_STATUS_OK);
+    assert(kowhai_subscribe(&subscriptions, COUNT_OF(flux_path), flux_path, on_change_record, &flux, &flux_id) == KOW_STATUS_OK);
+    assert(kowhai_subscribe(&subscriptions, COUNT_OF(symbols11), symbols11, on_change_record, &oven, &id) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_subscriptions_watched(&subscriptions, offsetof(struct settings_data_t, oven.timeout), 1));
+    assert(kowhai_subscriptions_watched(&subscriptions, offsetof(struct settings_data_t, flux_capacitor[1].gain), 4));
+    assert(!kowhai_subscriptions_watched(&subscriptions, offsetof(struct settings_data_t, flux_capacitor[0].gain), 4));
+    assert(!kowhai_subscriptions_watched(&subscriptions, offsetof(struct settings_data_t, check), 8));
+
+    // changes are coalesced until the window has passed
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols1), symbols1, 1) == KOW_STATUS_OK);
+    assert(kowhai_set_int32(&tree, COUNT_OF(gain0_path), gain0_path, 2) == KOW_STATUS_OK);
+    assert(kowhai_subscriptions_poll(&subscriptions, 100) == KOW_STATUS_OK);
+    assert(oven.calls == 0 && flux.calls == 0);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, 3) == KOW_STATUS_OK);
+    assert(kowhai_set_int32(&tree, COUNT_OF(gain_path), gain_path, 4) == KOW_STATUS_OK);
+    assert(kowhai_subscriptions_poll(&subscriptions, 109) == KOW_STATUS_OK);
+    assert(oven.calls == 0 && flux.calls == 0);
+    assert(kowhai_subscriptions_poll(&subscriptions, 110) == KOW_STATUS_OK);
+    assert(oven.calls == 1 && oven.offset == offsetof(struct settings_data_t, oven) && oven.size == sizeof(struct oven_t));
+    offset = offsetof(struct settings_data_t, flux_capacitor[1].gain);
+    assert(flux.calls == 1 && flux.offset == offset && flux.size == sizeof(uint32_t));
+
+    // nothing changed so no calls, and the window restarts with the next change
+    assert(kowhai_subscriptions_poll(&subscriptions, 200) == KOW_STATUS_OK);
+    assert(oven.calls == 1 && flux.calls == 1);
+    assert(kowhai_write(&tree, COUNT_OF(symbols1), symbols1, 0, &settings.oven.temp, sizeof(settings.oven.temp)) == KOW_STATUS_OK);
+    assert(kowhai_subscriptions_poll(&subscriptions, 300) == KOW_STATUS_OK);
+    assert(oven.calls == 1);
+    assert(kowhai_subscriptions_flush(&subscriptions) == KOW_STATUS_OK);
+    assert(oven.calls == 2 && oven.size == sizeof(settings.oven.temp));
+
+    // unsubscribed slots are reused
+    assert(kowhai_unsubscribe(&subscriptions, oven_id) == KOW_STATUS_OK);
+    assert(kowhai_unsubscribe(&subscriptions, oven_id) == KOW_STATUS_NOT_FOUND);
+    assert(!kowhai_subscriptions_watched(&subscriptions, offsetof(struct settings_data_t, oven), sizeof(struct oven_t)));
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols1), symbols1, 5) == KOW_STATUS_OK);
+    assert(kowhai_subscriptions_flush(&subscriptions) == KOW_STATUS_OK);
+    assert(oven.calls == 2);
+    assert(kowhai_subscribe_range(&subscriptions, 0, sizeof(settings) + 1, on_change_record, &oven, &id) == KOW_STATUS_INVALID_OFFSET);
+    assert(kowhai_subscribe_range(&subscriptions, 0, sizeof(settings), on_change_record, &oven, &id) == KOW_STATUS_OK);
+    assert(id == oven_id);
+
+    printf(" passed!\n");
+}
+
+void transaction_tests()
+{
+    struct kowhai_transaction_write_t writes[4];
+    uint8_t arena[16];
+    struct kowhai_transaction_t transaction;
+    struct settings_data_t before;
+    union kowhai_symbol_t gain_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), SYM_GAIN};
+    union kowhai_symbol_t bad_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, FLUX_CAP_COUNT), SYM_GAIN};
+    union kowhai_symbol_t owner_path[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 0), SYM_OWNER};
+    int16_t temp = 1234, temp2 = 4321;
+    uint16_t timeout = 99;
+    uint32_t gain = 0xC0FFEE;
+    double big[4] = {0};
+
+    printf("test kowhai_transaction_xxx...\t\t");
+
+    assert(kowhai_transaction_begin(&transaction, &settings_tree, writes, COUNT_OF(writes), arena, sizeof(arena)) == KOW_STATUS_OK);
+    memcpy(&before, &settings, sizeof(settings));
+
+    // nothing is written until commit, writes are applied in offset order but the same item keeps the last write
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(symbols1), symbols1, 0, &temp, sizeof(temp)) == KOW_STATUS_OK);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(gain_path), gain_path, 0, &gain, sizeof(gain)) == KOW_STATUS_OK);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(symbols2), symbols2, 0, &timeout, sizeof(timeout)) == KOW_STATUS_OK);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(symbols1), symbols1, 0, &temp2, sizeof(temp2)) == KOW_STATUS_OK);
+    assert(memcmp(&before, &settings, sizeof(settings)) == 0);
+    assert(kowhai_transaction_commit(&transaction) == KOW_STATUS_OK);
+    assert(settings.oven.temp == temp2);
+    assert(settings.oven.timeout == timeout);
+    assert(settings.flux_capacitor[1].gain == gain);
+    assert(transaction.num_writes == 0 && transaction.arena_used == 0);
+
+    // rollback leaves the tree untouched
+    memcpy(&before, &settings, sizeof(settings));
+    temp = 1;
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(symbols1), symbols1, 0, &temp, sizeof(temp)) == KOW_STATUS_OK);
+    kowhai_transaction_rollback(&transaction);
+    assert(kowhai_transaction_commit(&transaction) == KOW_STATUS_OK);
+    assert(memcmp(&before, &settings, sizeof(settings)) == 0);
+
+    // any failed write fails the commit and nothing is applied
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(symbols1), symbols1, 0, &temp, sizeof(temp)) == KOW_STATUS_OK);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(bad_path), bad_path, 0, &gain, sizeof(gain)) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(symbols2), symbols2, 0, &timeout, sizeof(timeout)) == KOW_STATUS_OK);
+    assert(kowhai_transaction_commit(&transaction) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    assert(memcmp(&before, &settings, sizeof(settings)) == 0);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(symbols1), symbols1, 1, &temp, sizeof(temp)) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+    assert(kowhai_transaction_commit(&transaction) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(symbols3), symbols3, 0, big, sizeof(big)) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_transaction_commit(&transaction) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(memcmp(&before, &settings, sizeof(settings)) == 0);
+
+    // overlapping writes that start at different offsets still keep the newest write
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(owner_path), owner_path, 2, "1", 1) == KOW_STATUS_OK);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(owner_path), owner_path, 0, "99999999999", OWNER_MAX_LEN) == KOW_STATUS_OK);
+    assert(kowhai_transaction_commit(&transaction) == KOW_STATUS_OK);
+    assert(memcmp(settings.flux_capacitor[0].owner, "99999999999", OWNER_MAX_LEN) == 0);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(owner_path), owner_path, 0, "aaaaaaaaaaa", OWNER_MAX_LEN) == KOW_STATUS_OK);
+    assert(kowhai_transaction_write(&transaction, COUNT_OF(owner_path), owner_path, 2, "b", 1) == KOW_STATUS_OK);
+    assert(kowhai_transaction_commit(&transaction) == KOW_STATUS_OK);
+    assert(memcmp(settings.flux_capacitor[0].owner, "aabaaaaaaaa", OWNER_MAX_LEN) == 0);
+    memcpy(&settings, &before, sizeof(before));
+
+    printf(" passed!\n");
+}
+
+void snapshot_tests()
+{
+    int16_t page_map[32];
+    uint8_t pool[2 * 16];
+    struct kowhai_snapshot_t snapshot;
+    struct kowhai_tree_t tree = {settings_descriptor, &settings};
+    struct kowhai_tree_t frozen;
+    struct settings_data_t before, copy;
+    union kowhai_symbol_t check_path[] = {SYM_SETTINGS, SYM_CHECK};
+    int num_pages;
+    int16_t temp;
+    int64_t check = 0x0123456789ABCDEFLL;
+
+    printf("test kowhai_snapshot_xxx...\t\t");
+
+    memcpy(&before, &settings, sizeof(settings));
+    assert(kowhai_snapshot_get_page_count(settings_descriptor, 16, &num_pages) == KOW_STATUS_OK);
+    assert(num_pages == (sizeof(settings) + 15) / 16);
+    assert(kowhai_snapshot_create(&snapshot, &tree, 16, page_map, num_pages - 1, pool, sizeof(pool)) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_snapshot_create(&snapshot, &tree, 16, page_map, COUNT_OF(page_map), pool, sizeof(pool)) == KOW_STATUS_OK);
+    assert(tree.snapshot == &snapshot && snapshot.pool_used == 0);
+
+    // writes copy the pages they touch once, the snapshot still sees the old data
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols1), symbols1, before.oven.temp + 1) == KOW_STATUS_OK);
+    assert(snapshot.pool_used == 1);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols1), symbols1, before.oven.temp + 2) == KOW_STATUS_OK);
+    assert(snapshot.pool_used == 1);
+    assert(kowhai_snapshot_read(&snapshot, offsetof(struct settings_data_t, oven.temp), &temp, sizeof(temp)) == KOW_STATUS_OK);
+    assert(temp == before.oven.temp);
+    assert(settings.oven.temp == before.oven.temp + 2);
+
+    // the frozen tree works with the normal api
+    assert(kowhai_snapshot_get_tree(&snapshot, &copy, sizeof(copy) - 1, &frozen) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_snapshot_get_tree(&snapshot, &copy, sizeof(copy), &frozen) == KOW_STATUS_OK);
+    assert(memcmp(&copy, &before, sizeof(before)) == 0);
+    assert(kowhai_get_int16(&frozen, COUNT_OF(symbols1), symbols1, &temp) == KOW_STATUS_OK);
+    assert(temp == before.oven.temp);
+
+    // running out of pool invalidates the snapshot but not the writes
+    assert(kowhai_write(&tree, COUNT_OF(check_path), check_path, 0, &check, sizeof(check)) == KOW_STATUS_OK);
+    assert(snapshot.status == KOW_STATUS_OK && snapshot.pool_used == 2);
+    kowhai_snapshot_preserve(&snapshot, 0, sizeof(settings));
+    assert(snapshot.status == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_snapshot_read(&snapshot, 0, &temp, sizeof(temp)) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(settings.check == check);
+
+    kowhai_snapshot_release(&snapshot);
+    assert(tree.snapshot == NULL);
+    memcpy(&settings, &before, sizeof(settings));
+
+    printf(" passed!\n");
+}
+
+void symbol_table_tests()
+{
+    struct kowhai_symbol_table_t table, remote_table;
+    struct kowhai_symbol_table_slot_t slots[COUNT_OF(symbols) * 2], remote_slots[8];
+    char* dup_names[] = {"Oven", "Temp", "Oven"};
+    char list[] = "Oven\0Temp\0Gain";
+    char* names[4];
+    union kowhai_symbol_t path[4];
+    int i, path_len, name_count;
+
+    printf("test kowhai_symbol_table...\t\t");
+
+    assert(kowhai_symbol_table_init(&table, symbols, COUNT_OF(symbols), slots, COUNT_OF(symbols)) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_symbol_table_init(&table, symbols, COUNT_OF(symbols), slots, COUNT_OF(slots)) == KOW_STATUS_OK);
+    for (i = 0; i < COUNT_OF(symbols); i++)
+    {
+        assert(kowhai_symbol_table_get_symbol(&table, symbols[i], (int)strlen(symbols[i])) == i);
+        assert(kowhai_symbol_table_get_name(&table, (uint16_t)i) == symbols[i]);
+    }
+    assert(kowhai_symbol_table_get_symbol(&table, "Oven.Temp", 4) == SYM_OVEN);
+    assert(kowhai_symbol_table_get_symbol(&table, "Ove", 3) == -1);
+    assert(kowhai_symbol_table_get_symbol(&table, "Moo", 3) == -1);
+    assert(kowhai_symbol_table_get_name(&table, COUNT_OF(symbols)) == NULL);
+
+    // the perfect hash generated by symbol_gen.py finds the same ids
+    assert(kowhai_symbol_table_init_perfect(&table, symbols, COUNT_OF(symbols), symbols_hash_slots, symbols_hash_seeds) == KOW_STATUS_OK);
+    for (i = 0; i < COUNT_OF(symbols); i++)
+        assert(kowhai_symbol_table_get_symbol(&table, symbols[i], (int)strlen(symbols[i])) == i);
+    assert(kowhai_symbol_table_get_symbol(&table, "Ove", 3) == -1);
+    assert(kowhai_symbol_table_get_symbol(&table, "Moo", 3) == -1);
+
+    // the table plugs straight into the path parser
+    path_len = COUNT_OF(path);
+    assert(kowhai_str_to_path("Settings.FluxCapacitor[1].Gain", 30, path, &path_len, &table, kowhai_symbol_table_get_symbol) == KOW_STATUS_OK);
+    assert(path_len == 3 && path[0].parts.name == SYM_SETTINGS && path[2].parts.name == SYM_GAIN);
+    assert(path[1].parts.name == SYM_FLUXCAPACITOR && path[1].parts.array_index == 1);
+
+    // duplicates keep the first id
+    assert(kowhai_symbol_table_init(&remote_table, dup_names, COUNT_OF(dup_names), remote_slots, COUNT_OF(remote_slots)) == KOW_STATUS_OK);
+    assert(kowhai_symbol_table_get_symbol(&remote_table, "Oven", 4) == 0);
+
+    // a symbol list from KOW_CMD_GET_SYMBOL_LIST
+    name_count = 2;
+    assert(kowhai_symbol_table_split_list(list, sizeof(list), names, &name_count) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    name_count = COUNT_OF(names);
+    assert(kowhai_symbol_table_split_list(list, sizeof(list) - 1, names, &name_count) == KOW_STATUS_BUFFER_INVALID);
+    name_count = COUNT_OF(names);
+    assert(kowhai_symbol_table_split_list(list, sizeof(list), names, &name_count) == KOW_STATUS_OK);
+    assert(name_count == 3 && strcmp(names[2], "Gain") == 0);
+    assert(kowhai_symbol_table_init(&remote_table, names, name_count, remote_slots, COUNT_OF(remote_slots)) == KOW_STATUS_OK);
+    assert(kowhai_symbol_table_get_symbol(&remote_table, "Temp", 4) == 1);
+
+    printf(" passed!\n");
+}
+
+void desc_gen_tests()
+{
+    int32_t sizes[COMPILED_SETTINGS_NUM_NODES], node_counts[COMPILED_SETTINGS_NUM_NODES], data_offsets[COMPILED_SETTINGS_NUM_NODES];
+    struct kowhai_node_tables_t tables, compiled_tables = COMPILED_SETTINGS_NODE_TABLES;
+    struct compiled_settings_t compiled_settings;
+    struct kowhai_tree_t compiled_tree = {compiled_settings_descriptor, &compiled_settings};
+    struct kowhai_node_t *node;
+    int offset;
+    int16_t temp = -5;
+
+    printf("test desc_gen...\t\t\t");
+
+    // the compiled schema is the same as the hand written settings tree
+    assert(sizeof(compiled_settings_descriptor) == sizeof(settings_descriptor));
+    assert(memcmp(compiled_settings_descriptor, settings_descriptor, sizeof(settings_descriptor)) == 0);
+    assert(sizeof(struct compiled_settings_t) == sizeof(struct settings_data_t));
+    assert(COMPILED_SETTINGS_UNION_CONTAINER_CHECK_OFFSET == offsetof(struct settings_data_t, union_container[0].check));
+
+    // the precomputed tables need no initialisation
+    assert(kowhai_init_node_tables(&tables, settings_descriptor, COMPILED_SETTINGS_NUM_NODES, sizes, node_counts, data_offsets) == KOW_STATUS_OK);
+    assert(compiled_tables.num_nodes == tables.num_nodes);
+    assert(memcmp(compiled_settings_node_size, sizes, sizeof(sizes)) == 0);
+    assert(memcmp(compiled_settings_node_count, node_counts, sizeof(node_counts)) == 0);
+    assert(memcmp(compiled_settings_data_offset, data_offsets, sizeof(data_offsets)) == 0);
+    assert(kowhai_get_node_from_tables(&compiled_tables, 3, symbols1, &offset, &node) == KOW_STATUS_OK);
+    assert(offset == COMPILED_SETTINGS_OVEN_TEMP_OFFSET && node == &compiled_settings_descriptor[8]);
+
+    // fixed fields can be used directly
+    memset(&compiled_settings, 0, sizeof(compiled_settings));
+    assert(kowhai_write(&compiled_tree, 3, symbols1, 0, &temp, sizeof(temp)) == KOW_STATUS_OK);
+    assert(compiled_settings.oven.temp == temp);
+
+    printf(" passed!\n");
+}
+
+void image_tests()
+{
+    static uint64_t image[256];
+    struct kowhai_image_header_t *header = (struct kowhai_image_header_t*)image;
+    struct kowhai_tree_t tree;
+    struct kowhai_symbol_table_t table;
+    struct kowhai_symbol_table_slot_t slots[COUNT_OF(symbols) * 2];
+    char* names[COUNT_OF(symbols)];
+    char *symbol_list;
+    int size, image_size, symbol_list_size, name_count = COUNT_OF(names);
+    int16_t timeout;
+
+    printf("test kowhai_image...\t\t\t");
+
+    assert(kowhai_crc32(0, "123456789", 9) == 0xCBF43926);
+
+    settings.oven.timeout = 1234;
+    assert(kowhai_image_get_size(&settings_tree, symbols, COUNT_OF(symbols), &image_size) == KOW_STATUS_OK);
+    assert(image_size <= (int)sizeof(image));
+    assert(kowhai_image_create(image, image_size - 1, &settings_tree, symbols, COUNT_OF(symbols), &size) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_image_create(image, sizeof(image), &settings_tree, symbols, COUNT_OF(symbols), &size) == KOW_STATUS_OK);
+    assert(size == image_size && header->data_size == sizeof(settings));
+
+    // the loaded tree points into the image
+    assert(kowhai_image_load(image, size - 1, KOWHAI_IMAGE_VERIFY_DATA, &tree, NULL, NULL) == KOW_STATUS_BUFFER_INVALID);
+    assert(kowhai_image_load(image, size, KOWHAI_IMAGE_VERIFY_DATA, &tree, &symbol_list, &symbol_list_size) == KOW_STATUS_OK);
+    assert((char*)tree.desc == (char*)image + header->desc_offset && (char*)tree.data == (char*)image + header->data_offset);
+    assert(memcmp(tree.desc, settings_descriptor, sizeof(settings_descriptor)) == 0);
+    assert(kowhai_get_int16(&tree, COUNT_OF(symbols2), symbols2, &timeout) == KOW_STATUS_OK && timeout == 1234);
+    assert(kowhai_symbol_table_split_list(symbol_list, symbol_list_size, names, &name_count) == KOW_STATUS_OK);
+    assert(name_count == COUNT_OF(symbols));
+    assert(kowhai_symbol_table_init(&table, names, name_count, slots, COUNT_OF(slots)) == KOW_STATUS_OK);
+    assert(kowhai_symbol_table_get_symbol(&table, "Oven", 4) == SYM_OVEN);
+
+    // changing the data in place needs the data checksum updated, the layout check does not read the data
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, 4321) == KOW_STATUS_OK);
+    assert(kowhai_image_load(image, size, KOWHAI_IMAGE_VERIFY_DATA, &tree, NULL, NULL) == KOW_STATUS_CHECKSUM_MISMATCH);
+    assert(kowhai_image_load(image, size, KOWHAI_IMAGE_VERIFY_LAYOUT, &tree, NULL, NULL) == KOW_STATUS_OK);
+    assert(kowhai_image_update_checksum(image) == KOW_STATUS_OK);
+    assert(kowhai_image_load(image, size, KOWHAI_IMAGE_VERIFY_DATA, &tree, NULL, NULL) == KOW_STATUS_OK);
+
+    // a corrupt descriptor is always caught
+    ((struct kowhai_node_t*)((char*)image + header->desc_offset))[2].count++;
+    assert(kowhai_image_load(image, size, KOWHAI_IMAGE_VERIFY_LAYOUT, &tree, NULL, NULL) == KOW_STATUS_CHECKSUM_MISMATCH);
+    header->magic = 0;
+    assert(kowhai_image_load(image, size, KOWHAI_IMAGE_VERIFY_LAYOUT, &tree, NULL, NULL) == KOW_STATUS_BUFFER_INVALID);
+
+    printf(" passed!\n");
+}
+
+struct journal_log_t
+{
+    uint8_t data[1024];
+    int size;
+    int syncs;
+    int fail_syncs;
+    int fail_append;
+};
+
+static int journal_append(void* param, const void* buffer, int size)
+{
+    struct journal_log_t *log = (struct journal_log_t*)param;
+    // fail_append counts down to the append that fails
+    if (log->fail_append > 0 && --log->fail_append == 0)
+        return KOW_STATUS_UNKNOWN_ERROR;
+    if (log->size + size > (int)sizeof(log->data))
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    memcpy(&log->data[log->size], buffer, size);
+    log->size += size;
+    return KOW_STATUS_OK;
+}
+
+static int journal_sync(void* param)
+{
+    struct journal_log_t *log = (struct journal_log_t*)param;
+    if (log->fail_syncs > 0)
+    {
+        log->fail_syncs--;
+        return KOW_STATUS_UNKNOWN_ERROR;
+    }
+    log->syncs++;
+    return KOW_STATUS_OK;
+}
+
+static int journal_truncate(void* param)
+{
+    ((struct journal_log_t*)param)->size = 0;
+    return KOW_STATUS_OK;
+}
+
+void journal_tests()
+{
+    static struct journal_log_t log;
+    static struct settings_data_t before, replayed;
+    uint8_t bits[64], subs_bits[64], buffer[32];
+    struct kowhai_dirty_t dirty, subs_dirty;
+    struct kowhai_tree_t tree = {settings_descriptor, &settings, &dirty};
+    struct kowhai_tree_t replay_tree = {settings_descriptor, &replayed};
+    struct kowhai_journal_t journal;
+    struct kowhai_subscription_t subs[1];
+    struct kowhai_subscriptions_t subscriptions;
+    struct change_record_t oven = {0};
+    int valid_size, first_group, id, offset, size;
+    int16_t temp;
+
+    printf("test kowhai_journal...\t\t\t");
+
+    memcpy(&before, &settings, sizeof(settings));
+    assert(kowhai_dirty_init(&dirty, settings_descriptor, 1, bits, sizeof(bits)) == KOW_STATUS_OK);
+    // a small buffer so records overflow it
+    assert(kowhai_journal_init(&journal, &tree, NULL, buffer, sizeof(buffer), 10, journal_append, journal_sync, journal_truncate, &log) == KOW_STATUS_OK);
+
+    // writes are grouped for the window then committed with one sync
+    assert(kowhai_journal_poll(&journal, 0) == KOW_STATUS_OK && log.size == 0);
+    assert(kowhai_write(&tree, COUNT_OF(symbols11), symbols11, 0, &before.oven, sizeof(before.oven) / 2) == KOW_STATUS_OK);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols1), symbols1, 55) == KOW_STATUS_OK);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, 600) == KOW_STATUS_OK);
+    assert(kowhai_journal_poll(&journal, 100) == KOW_STATUS_OK && log.syncs == 0);
+    assert(kowhai_journal_poll(&journal, 109) == KOW_STATUS_OK && log.syncs == 0);
+    assert(kowhai_journal_poll(&journal, 110) == KOW_STATUS_OK && log.syncs == 1);
+    assert(log.size > 0 && log.size == (int)journal.log_size);
+    assert(kowhai_journal_poll(&journal, 200) == KOW_STATUS_OK && log.syncs == 1);
+    first_group = log.size;
+
+    // replaying over the old data gives the new data
+    memcpy(&replayed, &before, sizeof(before));
+    assert(kowhai_journal_replay(&replay_tree, log.data, log.size, &valid_size) == KOW_STATUS_OK);
+    assert(valid_size == log.size && memcmp(&replayed, &settings, sizeof(settings)) == 0);
+
+    // a group torn by a crash is not applied
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols1), symbols1, 77) == KOW_STATUS_OK);
+    assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK && log.syncs == 2);
+    memcpy(&replayed, &before, sizeof(before));
+    assert(kowhai_journal_replay(&replay_tree, log.data, log.size - 1, &valid_size) == KOW_STATUS_OK);
+    assert(valid_size == first_group);
+    assert(kowhai_get_int16(&replay_tree, COUNT_OF(symbols1), symbols1, &temp) == KOW_STATUS_OK && temp == 55);
+    log.data[first_group + sizeof(struct kowhai_journal_record_t)] ^= 1;
+    assert(kowhai_journal_replay(&replay_tree, log.data, log.size, &valid_size) == KOW_STATUS_OK);
+    assert(valid_size == first_group);
+    log.data[0] ^= 1;
+    assert(kowhai_journal_replay(&replay_tree, log.data, log.size, &valid_size) == KOW_STATUS_OK && valid_size == 0);
+
+    // the log is only emptied once everything in it is committed
+    assert(kowhai_journal_record(&journal, sizeof(settings), 1) == KOW_STATUS_INVALID_OFFSET);
+    assert(kowhai_journal_record(&journal, 0, 1) == KOW_STATUS_OK);
+    assert(kowhai_journal_truncate(&journal) == KOW_STATUS_INVALID_SEQUENCE);
+    assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK);
+    assert(kowhai_journal_truncate(&journal) == KOW_STATUS_OK && log.size == 0 && journal.log_size == 0);
+
+    // a failed sync is retried without writing another commit record, later groups still replay
+    log.fail_syncs = 1;
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols1), symbols1, 88) == KOW_STATUS_OK);
+    assert(kowhai_journal_commit(&journal) == KOW_STATUS_UNKNOWN_ERROR);
+    first_group = log.size;
+    assert(kowhai_journal_truncate(&journal) == KOW_STATUS_INVALID_SEQUENCE);
+    assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK && log.syncs == 4 && log.size == first_group);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, 601) == KOW_STATUS_OK);
+    assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK && log.syncs == 5);
+    memcpy(&replayed, &before, sizeof(before));
+    assert(kowhai_journal_replay(&replay_tree, log.data, log.size, &valid_size) == KOW_STATUS_OK && valid_size == log.size);
+    assert(replayed.oven.temp == 88 && replayed.oven.timeout == 601);
+
+    // subscriptions with their own bitmap chained to the tree bitmap do not take changes from the journal
+    assert(kowhai_dirty_init(&subs_dirty, settings_descriptor, 1, subs_bits, sizeof(subs_bits)) == KOW_STATUS_OK);
+    assert(kowhai_subscriptions_init(&subscriptions, &tree, &subs_dirty, subs, COUNT_OF(subs), 10) == KOW_STATUS_OK);
+    assert(kowhai_subscribe(&subscriptions, COUNT_OF(symbols1), symbols1, on_change_record, &oven, &id) == KOW_STATUS_OK);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols1), symbols1, 99) == KOW_STATUS_OK);
+    assert(kowhai_set_int16(&tree, COUNT_OF(symbols2), symbols2, 602) == KOW_STATUS_OK);
+    assert(kowhai_subscriptions_flush(&subscriptions) == KOW_STATUS_OK);
+    assert(oven.calls == 1 && oven.size == sizeof(temp));
+    first_group = log.size;
+    assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK && log.size > first_group);
+    memcpy(&replayed, &before, sizeof(before));
+    assert(kowhai_journal_replay(&replay_tree, log.data, log.size, &valid_size) == KOW_STATUS_OK && valid_size == log.size);
+    assert(replayed.oven.temp == 99 && replayed.oven.timeout == 602);
+    // the change nobody subscribed to is left dirty in the subscription bitmap only
+    assert(kowhai_dirty_next(&dirty, 0, &offset, &size) == KOW_STATUS_NOT_FOUND);
+    assert(kowhai_dirty_next(&subs_dirty, 0, &offset, &size) == KOW_STATUS_OK);
+    assert(kowhai_subscriptions_poll(&subscriptions, 0) == KOW_STATUS_OK && !subscriptions.pending);
+    assert(kowhai_dirty_unchain(&dirty, &subs_dirty) == KOW_STATUS_OK);
+
+    // a record that fails before reaching the log is dropped, one that is torn stops logging until the log is truncated
+    first_group = log.size;
+    log.fail_append = 1;
+    assert(kowhai_journal_record(&journal, 0, sizeof(buffer) + 1) == KOW_STATUS_UNKNOWN_ERROR);
+    assert(journal.buffer_used == 0 && journal.group_records == 0 && log.size == first_group);
+    log.fail_append = 2;
+    assert(kowhai_journal_record(&journal, 0, sizeof(buffer) + 1) == KOW_STATUS_UNKNOWN_ERROR);
+    assert(log.size == first_group + (int)sizeof(struct kowhai_journal_record_t));
+    assert(kowhai_journal_record(&journal, 0, 1) == KOW_STATUS_INVALID_SEQUENCE);
+    assert(kowhai_journal_commit(&journal) == KOW_STATUS_INVALID_SEQUENCE);
+    assert(kowhai_journal_replay(&replay_tree, log.data, log.size, &valid_size) == KOW_STATUS_OK && valid_size == first_group);
+    assert(kowhai_journal_truncate(&journal) == KOW_STATUS_OK && log.size == 0);
+    assert(kowhai_journal_record(&journal, 0, sizeof(buffer) + 1) == KOW_STATUS_OK);
+    assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK);
+    assert(kowhai_journal_replay(&replay_tree, log.data, log.size, &valid_size) == KOW_STATUS_OK && valid_size == log.size);
+
+    memcpy(&settings, &before, sizeof(before));
+    printf(" passed!\n");
+}
+
+void shm_tests()
+{
+    static uint64_t segment[256];
+    struct kowhai_shm_t host, reader;
+    struct shm_t *host_map, *reader_map;
+    uint32_t version;
+    static struct settings_data_t before;
+    int size, count;
+    int16_t temp, value;
+
+    printf("test kowhai_shm...\t\t\t");
+
+    memcpy(&before, &settings, sizeof(settings));
+
+    // lay out the segment in any memory
+    assert(kowhai_seqlock_get_branch_count(settings_descriptor, &count) == KOW_STATUS_OK);
+    assert(kowhai_shm_get_size(settings_descriptor, count, &size) == KOW_STATUS_OK);
+    assert(size <= (int)sizeof(segment));
+    assert(kowhai_shm_create(segment, size - 1, &settings_tree, count, &host) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_shm_create(segment, sizeof(segment), &settings_tree, count, &host) == KOW_STATUS_OK);
+    assert(memcmp(host.tree.desc, settings_descriptor, sizeof(settings_descriptor)) == 0);
+    assert(memcmp(host.tree.data, &settings, sizeof(settings)) == 0);
+    assert(kowhai_shm_attach(segment, size - 1, &reader) == KOW_STATUS_BUFFER_INVALID);
+    assert(kowhai_shm_attach(segment, size, &reader) == KOW_STATUS_OK);
+    assert(reader.tree.desc == host.tree.desc && reader.tree.data == host.tree.data && reader.locks.num_locks == count);
+
+    // the host writes under the locks and readers see the version change
+    version = kowhai_shm_get_version(&reader);
+    value = 91;
+    assert(kowhai_seqlock_write(&host.locks, &host.tree, COUNT_OF(symbols1), symbols1, 0, &value, sizeof(value)) == KOW_STATUS_OK);
+    assert(kowhai_shm_get_version(&reader) == version + 2);
+    assert(kowhai_seqlock_read(&reader.locks, &reader.tree, COUNT_OF(symbols1), symbols1, 0, &temp, sizeof(temp)) == KOW_STATUS_OK && temp == 91);
+    settings.oven.temp = 92;
+    assert(kowhai_shm_publish(&host, &settings, 0, sizeof(settings) + 1) == KOW_STATUS_INVALID_OFFSET);
+    assert(kowhai_shm_publish(&host, &settings, 0, sizeof(settings)) == KOW_STATUS_OK);
+    assert(kowhai_seqlock_read(&reader.locks, &reader.tree, COUNT_OF(symbols1), symbols1, 0, &temp, sizeof(temp)) == KOW_STATUS_OK && temp == 92);
+
+    // a descriptor that does not end inside its section or has unknown node types is not walked
+    reader.tree.desc[COUNT_OF(settings_descriptor) - 1].type = KOW_BRANCH_START;
+    assert(kowhai_shm_attach(segment, size, &reader) == KOW_STATUS_INVALID_DESCRIPTOR);
+    reader.tree.desc[COUNT_OF(settings_descriptor) - 1].type = KOW_BRANCH_END;
+    reader.tree.desc[2].type = 0xFF;
+    assert(kowhai_shm_attach(segment, size, &reader) == KOW_STATUS_INVALID_NODE_TYPE);
+    reader.tree.desc[2].type = settings_descriptor[2].type;
+    assert(kowhai_shm_attach(segment, size, &reader) == KOW_STATUS_OK);
+
+    // a segment that is not ready or does not match its descriptor is not attached
+    ((struct kowhai_shm_header_t*)segment)->data_size++;
+    assert(kowhai_shm_attach(segment, size, &reader) == KOW_STATUS_INVALID_DESCRIPTOR);
+    ((struct kowhai_shm_header_t*)segment)->magic = 0;
+    assert(kowhai_shm_attach(segment, size, &reader) == KOW_STATUS_NOT_FOUND);
+
+    // a named segment shared with a read only mapping
+    host_map = shm_create("/kowhai_test", size);
+    assert(host_map != NULL);
+    assert(kowhai_shm_create(shm_address(host_map), shm_size(host_map), &settings_tree, 1, &host) == KOW_STATUS_OK);
+    reader_map = shm_attach("/kowhai_test");
+    assert(reader_map != NULL && shm_size(reader_map) >= size);
+    assert(kowhai_shm_attach(shm_address(reader_map), shm_size(reader_map), &reader) == KOW_STATUS_OK);
+    assert((void*)reader.tree.data != (void*)host.tree.data);
+    value = 93;
+    assert(kowhai_seqlock_write(&host.locks, &host.tree, COUNT_OF(symbols1), symbols1, 0, &value, sizeof(value)) == KOW_STATUS_OK);
+    assert(kowhai_seqlock_read(&reader.locks, &reader.tree, COUNT_OF(symbols1), symbols1, 0, &temp, sizeof(temp)) == KOW_STATUS_OK && temp == 93);
+    assert(kowhai_get_int16(&reader.tree, COUNT_OF(symbols1), symbols1, &temp) == KOW_STATUS_OK && temp == 93);
+    shm_free(reader_map);
+    shm_free(host_map);
+
+    memcpy(&settings, &before, sizeof(before));
+    printf(" passed!\n");
+}
+
+void flat_tests()
+{
+    static char flat_buffer[COUNT_OF(settings_descriptor) * 32];
+    static char flat_buffer2[COUNT_OF(settings_descriptor) * 32];
+    static char js[BUF_SIZE], flat_js[BUF_SIZE];
+    static struct diff_records_t diffs, flat_diffs;
+    struct kowhai_node_t right_descriptor[COUNT_OF(settings_descriptor)];
+    struct settings_data_t right;
+    struct kowhai_tree_t right_tree = {right_descriptor, &right};
+    struct kowhai_flat_desc_t flat, flat2;
+    union kowhai_symbol_t path[32];
+    union kowhai_symbol_t bad_index[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, FLUX_CAP_COUNT), SYM_GAIN};
+    int i, size, offset, flat_offset, js_len, flat_js_len;
+    struct kowhai_node_t *node, *flat_node;
+
+    printf("test flat descriptors...\t\t\t");
+
+    assert(kowhai_flat_get_buffer_size(settings_descriptor, &size) == KOW_STATUS_OK);
+    assert(size <= (int)sizeof(flat_buffer));
+    assert(kowhai_flat_init(&flat, settings_descriptor, flat_buffer, size - 1) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+    assert(kowhai_flat_init(&flat, settings_descriptor, flat_buffer, size) == KOW_STATUS_OK);
+    assert(flat.type[11] == KOW_BRANCH_START && flat.symbol[11] == SYM_UNIONCONTAINER && flat.count[11] == UNION_COUNT);
+    assert(flat.element_size[11] == sizeof(struct union_container_t));
+    assert(flat.element_size[16] == 1 && flat.tables.size[16] == OWNER_MAX_LEN);
+
+    // lookups match kowhai_get_node for every path in the tree
+    for (i = 0; i < COUNT_OF(settings_paths); i++)
+    {
+        assert(kowhai_get_node(settings_descriptor, settings_path_lengths[i], settings_paths[i], &offset, &node) == KOW_STATUS_OK);
+        assert(kowhai_flat_get_node(&flat, settings_path_lengths[i], settings_paths[i], &flat_offset, &flat_node) == KOW_STATUS_OK);
+        assert(flat_node == node);
+        assert(flat_offset == offset);
+    }
+    assert(kowhai_flat_get_node(&flat, COUNT_OF(bad_index), bad_index, &flat_offset, &flat_node) == KOW_STATUS_INVALID_SYMBOL_PATH);
+
+    // serializing over the flat descriptor gives the same result
+    js_len = BUF_SIZE;
+    flat_js_len = BUF_SIZE;
+    assert(kowhai_serialize_nodes(js, &js_len, &settings_tree, path, COUNT_OF(path), NULL, get_symbol_name) == KOW_STATUS_OK);
+    assert(kowhai_flat_serialize_nodes(flat_js, &flat_js_len, &flat, &settings, path, COUNT_OF(path), NULL, get_symbol_name) == KOW_STATUS_OK);
+    assert(flat_js_len == js_len);
+    assert(memcmp(js, flat_js, js_len) == 0);
+
+    // diffing over the flat descriptors finds the same differences, the right tree has one less flux capacitor,
+    // a different oven temp type and a few changed values
+    memcpy(right_descriptor, settings_descriptor, sizeof(settings_descriptor));
+    right_descriptor[1].count = 1;
+    right_descriptor[8].type = KOW_UINT16;
+    memcpy(&right, &settings, sizeof(right));
+    right.flux_capacitor[1].gain++;
+    right.union_container[1].check++;
+    right.temp += 1.0;
+    assert(kowhai_flat_init(&flat2, right_descriptor, flat_buffer2, sizeof(flat_buffer2)) == KOW_STATUS_OK);
+    diffs.count = 0;
+    flat_diffs.count = 0;
+    assert(kowhai_diff(&settings_tree, &right_tree, &diffs, record_diff) == KOW_STATUS_OK);
+    assert(kowhai_flat_diff(&flat, &settings, &flat2, &right, &flat_diffs, record_diff) == KOW_STATUS_OK);
+    assert(diffs.count > 3);
+    assert(flat_diffs.count == diffs.count);
+    assert(memcmp(flat_diffs.records, diffs.records, diffs.count * sizeof(struct diff_record_t)) == 0);
+
+    printf(" passed!\n");
+}
+
+#define DEEP_LEVELS (KOWHAI_WALK_STACK_DEPTH + 4)
+
+void deep_walk_tests()
+{
+    static struct kowhai_node_t deep_descriptor[DEEP_LEVELS * 2 + 1];
+    static union kowhai_symbol_t deep_path[DEEP_LEVELS + 1], found_path[DEEP_LEVELS + 1];
+    static struct kowhai_query_symbol_t deep_query[DEEP_LEVELS + 1];
+    static char js[BUF_SIZE];
+    struct kowhai_query_run_t run;
+    struct kowhai_query_t query;
+    struct kowhai_walk_frame_t frames[KOWHAI_WALK_STACK_DEPTH];
+    struct kowhai_walk_stack_t stack;
+    struct kowhai_tree_t deep_tree;
+    struct kowhai_node_t *node;
+    uint32_t deep_data[2], value;
+    int i, offset, size, js_len;
+
+    // DEEP_LEVELS nested branches around a uint32[2]
+    for (i = 0; i < DEEP_LEVELS; i++)
+    {
+        deep_descriptor[i].type = KOW_BRANCH_START;
+        deep_descriptor[i].symbol = i + 1;
+        deep_descriptor[i].count = 1;
+        deep_descriptor[DEEP_LEVELS * 2 - i].type = KOW_BRANCH_END;
+        deep_descriptor[DEEP_LEVELS * 2 - i].symbol = i + 1;
+        deep_path[i].symbol = i + 1;
+        deep_query[i].name = i + 1;
+        deep_query[i].start = 0;
+        deep_query[i].end = KOWHAI_QUERY_END;
+    }
+    deep_descriptor[DEEP_LEVELS].type = KOW_UINT32;
+    deep_descriptor[DEEP_LEVELS].symbol = DEEP_LEVELS + 1;
+    deep_descriptor[DEEP_LEVELS].count = 2;
+    deep_path[DEEP_LEVELS].symbol = KOWHAI_SYMBOL(DEEP_LEVELS + 1, 1);
+    deep_query[DEEP_LEVELS].name = DEEP_LEVELS + 1;
+    deep_query[DEEP_LEVELS].start = 1;
+    deep_query[DEEP_LEVELS].end = 2;
+    kowhai_tree_init(&deep_tree, deep_descriptor, deep_data);
+    deep_data[0] = 0;
+    deep_data[1] = 0;
+
+    assert(kowhai_get_node_depth(deep_descriptor) == DEEP_LEVELS);
+    assert(kowhai_get_node_depth(&deep_descriptor[DEEP_LEVELS]) == 0);
+    assert(kowhai_get_node_size(deep_descriptor, &size) == KOW_STATUS_OK && size == sizeof(deep_data));
+    assert(kowhai_get_node_count(deep_descriptor, &size) == KOW_STATUS_OK && size == COUNT_OF(deep_descriptor));
+    assert(kowhai_get_node(deep_descriptor, COUNT_OF(deep_path), deep_path, &offset, &node) == KOW_STATUS_OK);
+    assert(offset == sizeof(uint32_t) && node == &deep_descriptor[DEEP_LEVELS]);
+    value = 7;
+    assert(kowhai_write(&deep_tree, COUNT_OF(deep_path), deep_path, 0, &value, sizeof(value)) == KOW_STATUS_OK);
+    assert(deep_data[1] == 7);
+    js_len = BUF_SIZE;
+    assert(kowhai_serialize_tree(deep_tree, js, &js_len, NULL, get_symbol_name) == KOW_STATUS_OK);
+    assert(kowhai_diff(&deep_tree, &deep_tree, NULL, NULL) == KOW_STATUS_OK);
+    size = COUNT_OF(found_path);
+    assert(kowhai_create_symbol_path2(&deep_tree, &deep_data[1], found_path, &size) == KOW_STATUS_OK);
+    assert(size == COUNT_OF(deep_path) && memcmp(found_path, deep_path, sizeof(deep_path)) == 0);
+    assert(kowhai_query_compile(&query, deep_descriptor, deep_query, COUNT_OF(deep_query), &run, 1) == KOW_STATUS_OK);
+    assert(query.num_runs == 1 && run.offset == sizeof(uint32_t) && run.count == 1);
+
+    // the _ex functions are still bounded by the stack they are given
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    assert(kowhai_get_node_size_ex(deep_descriptor, &size, &stack) == KOW_STATUS_STACK_TOO_SMALL);
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    assert(kowhai_get_node_ex(deep_descriptor, COUNT_OF(deep_path), deep_path, &offset, &node, &stack) == KOW_STATUS_STACK_TOO_SMALL);
+}
+
+void walk_stack_tests()
+{
+    static char js[BUF_SIZE], stack_js[BUF_SIZE];
+    struct kowhai_walk_frame_t frames[KOWHAI_WALK_STACK_DEPTH];
+    struct kowhai_walk_stack_t stack;
+    union kowhai_symbol_t symbol_path[8], stack_symbol_path[8];
+    struct kowhai_node_t *node, *stack_node;
+    int offset, stack_offset, depth, size, js_len, stack_js_len;
+
+    printf("test walk stacks...\t\t\t");
+
+    // the deepest path needs a frame for each branch it walks into
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    assert(kowhai_get_node_ex(settings_descriptor, COUNT_OF(symbols23), symbols23, &stack_offset, &stack_node, &stack) == KOW_STATUS_OK);
+    assert(kowhai_get_node(settings_descriptor, COUNT_OF(symbols23), symbols23, &offset, &node) == KOW_STATUS_OK);
+    assert(stack_offset == offset && stack_node == node);
+    assert(stack.depth == 0);
+    depth = stack.max_depth;
+    assert(depth >= COUNT_OF(symbols23) - 1);
+    kowhai_walk_stack_init(&stack, frames, depth - 1);
+    assert(kowhai_get_node_ex(settings_descriptor, COUNT_OF(symbols23), symbols23, &stack_offset, &stack_node, &stack) == KOW_STATUS_STACK_TOO_SMALL);
+    kowhai_walk_stack_init(&stack, frames, depth);
+    assert(kowhai_get_node_ex(settings_descriptor, COUNT_OF(symbols23), symbols23, &stack_offset, &stack_node, &stack) == KOW_STATUS_OK);
+    assert(stack_offset == offset);
+
+    // sizes
+    kowhai_walk_stack_init(&stack, frames, 1);
+    assert(kowhai_get_node_size_ex(settings_descriptor, &size, &stack) == KOW_STATUS_STACK_TOO_SMALL);
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    assert(kowhai_get_node_size_ex(settings_descriptor, &size, &stack) == KOW_STATUS_OK);
+    assert(size == sizeof(struct settings_data_t));
+    assert(stack.max_depth == 3);
+
+    // serializing with a caller stack gives the same result
+    js_len = BUF_SIZE;
+    stack_js_len = BUF_SIZE;
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    assert(kowhai_serialize_tree(settings_tree, js, &js_len, NULL, get_symbol_name) == KOW_STATUS_OK);
+    assert(kowhai_serialize_tree_ex(settings_tree, stack_js, &stack_js_len, NULL, get_symbol_name, &stack) == KOW_STATUS_OK);
+    assert(js_len == stack_js_len && memcmp(js, stack_js, js_len) == 0);
+    kowhai_walk_stack_init(&stack, frames, 2);
+    stack_js_len = BUF_SIZE;
+    assert(kowhai_serialize_tree_ex(settings_tree, stack_js, &stack_js_len, NULL, get_symbol_name, &stack) == KOW_STATUS_STACK_TOO_SMALL);
+    kowhai_walk_stack_init(&stack, frames, 2);
+    stack_js_len = BUF_SIZE;
+    assert(kowhai_serialize_nodes_ex(stack_js, &stack_js_len, &settings_tree, symbol_path, COUNT_OF(symbol_path), NULL, get_symbol_name, &stack) == KOW_STATUS_STACK_TOO_SMALL);
+
+    // diff and symbol paths
+    kowhai_walk_stack_init(&stack, frames, 1);
+    assert(kowhai_diff_ex(&settings_tree, &settings_tree, NULL, NULL, &stack) == KOW_STATUS_STACK_TOO_SMALL);
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    assert(kowhai_diff_ex(&settings_tree, &settings_tree, NULL, NULL, &stack) == KOW_STATUS_OK);
+    size = COUNT_OF(symbol_path);
+    assert(kowhai_create_symbol_path2(&settings_tree, &settings.union_container[1].union_[1].owner[2], symbol_path, &size) == KOW_STATUS_OK);
+    depth = size;
+    size = COUNT_OF(stack_symbol_path);
+    assert(kowhai_create_symbol_path2_ex(&settings_tree, &settings.union_container[1].union_[1].owner[2], stack_symbol_path, &size, &stack) == KOW_STATUS_OK);
+    assert(size == depth && memcmp(symbol_path, stack_symbol_path, size * sizeof(union kowhai_symbol_t)) == 0);
+    kowhai_walk_stack_init(&stack, frames, 1);
+    size = COUNT_OF(stack_symbol_path);
+    assert(kowhai_create_symbol_path2_ex(&settings_tree, &settings.union_container[1].union_[1].owner[2], stack_symbol_path, &size, &stack) == KOW_STATUS_STACK_TOO_SMALL);
+
+    // the functions that do not take a stack walk trees deeper than KOWHAI_WALK_STACK_DEPTH
+    deep_walk_tests();
+
+    printf(" passed!\n");
+}
+
+void iter_tests()
+{
+#define ITER_TABLES_SIZE COUNT_OF(settings_descriptor)
+    int32_t sizes[ITER_TABLES_SIZE], node_counts[ITER_TABLES_SIZE], data_offsets[ITER_TABLES_SIZE];
+    struct kowhai_node_tables_t tables;
+    struct kowhai_walk_frame_t frames[KOWHAI_WALK_STACK_DEPTH];
+    struct kowhai_walk_stack_t stack;
+    struct kowhai_iter_t iter;
+    union kowhai_symbol_t path[8];
+    struct kowhai_node_t *node;
+    int offset, items, pass, ret;
+
+    printf("test kowhai_iter...\t\t\t");
+
+    assert(kowhai_init_node_tables(&tables, settings_descriptor, ITER_TABLES_SIZE, sizes, node_counts, data_offsets) == KOW_STATUS_OK);
+
+    // every item is where kowhai_get_node says it is, with and without tables
+    for (pass = 0; pass < 2; pass++)
+    {
+        kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+        assert(kowhai_iter_init(&iter, &settings_tree, pass ? &tables : NULL, &stack, path, COUNT_OF(path)) == KOW_STATUS_OK);
+        items = 0;
+        while ((ret = kowhai_iter_next(&iter)) == KOW_STATUS_OK)
+        {
+            assert(kowhai_get_node(settings_descriptor, iter.depth + 1, path, &offset, &node) == KOW_STATUS_OK);
+            assert(node == iter.node);
+            assert((char*)iter.data == (char*)&settings + offset);
+            items++;
+        }
+        assert(ret == KOW_STATUS_NOT_FOUND);
+        assert(kowhai_iter_next(&iter) == KOW_STATUS_NOT_FOUND);
+        assert(items == FLUX_CAP_COUNT * (OWNER_MAX_LEN + 2 + COEFF_COUNT) + 2 +
+            UNION_COUNT * (UNION_COUNT * (3 + OWNER_MAX_LEN + 2) + 1) + 3);
+    }
+
+    // skipping
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    assert(kowhai_iter_init(&iter, &settings_tree, &tables, &stack, path, COUNT_OF(path)) == KOW_STATUS_OK);
+    assert(kowhai_iter_next(&iter) == KOW_STATUS_OK);
+    assert(iter.data == &settings.flux_capacitor[0].owner[0] && iter.depth == 2);
+    assert(kowhai_iter_skip(&iter, 2) == KOW_STATUS_OK);
+    assert(kowhai_iter_next(&iter) == KOW_STATUS_OK);
+    assert(iter.data == &settings.flux_capacitor[0].frequency);
+    assert(kowhai_iter_skip(&iter, 1) == KOW_STATUS_OK);
+    assert(kowhai_iter_next(&iter) == KOW_STATUS_OK);
+    assert(iter.data == &settings.oven.temp && iter.depth == 2);
+    assert(kowhai_iter_skip(&iter, 3) == KOW_STATUS_INVALID_OFFSET);
+    assert(kowhai_iter_skip(&iter, 0) == KOW_STATUS_OK);
+    assert(kowhai_iter_next(&iter) == KOW_STATUS_NOT_FOUND);
+
+    // the path and stack must be deep enough
+    kowhai_walk_stack_init(&stack, frames, KOWHAI_WALK_STACK_DEPTH);
+    assert(kowhai_iter_init(&iter, &settings_tree, &tables, &stack, path, 2) == KOW_STATUS_OK);
+    assert(kowhai_iter_next(&iter) == KOW_STATUS_PATH_TOO_SMALL);
+    kowhai_walk_stack_init(&stack, frames, 1);
+    assert(kowhai_iter_init(&iter, &settings_tree, &tables, &stack, path, COUNT_OF(path)) == KOW_STATUS_OK);
+    assert(kowhai_iter_next(&iter) == KOW_STATUS_STACK_TOO_SMALL);
+
+    printf(" passed!\n");
+}
+
 void node_pre_write(pkowhai_protocol_server_t server, void* param, uint16_t tree_id, struct kowhai_node_t* node, int offset)
 {
     printf("node_pre_write: tree_id: %d, node: %p, offset: %d\n", tree_id, node, offset);
@@ -1584,6 +3241,29 @@ int main(int argc, char* argv[])
     diff_tests();
     merge_tests();
     create_symbol_path_tests();
+    path_index_tests();
+    offset_index_tests();
+    node_tables_tests();
+    handle_tests();
+    batch_tests();
+    gather_tests();
+    query_tests();
+    seqlock_tests();
+    rcu_tests();
+    protocol32_tests();
+    atomic_tests();
+    dirty_tests();
+    subscribe_tests();
+    transaction_tests();
+    snapshot_tests();
+    symbol_table_tests();
+    desc_gen_tests();
+    image_tests();
+    journal_tests();
+    shm_tests();
+    flat_tests();
+    walk_stack_tests();
+    iter_tests();
     // test server protocol
     if (test_command == TEST_PROTOCOL_SERVER)
         test_server_protocol();
@@ -0,0 +1,156 @@
+#include "../src/kowhai.hpp"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <assert.h>
+
+#define SYM_SETTINGS        0
+#define SYM_FLUXCAPACITOR   12
+#define SYM_COEFFICIENT     14
+#define SYM_GAIN            15
+#define SYM_OVEN            16
+#define SYM_TEMP            17
+#define SYM_TIMEOUT         18
+#define SYM_UNIONCONTAINER  19
+#define SYM_UNION           20
+#define SYM_BEEP            8
+#define SYM_CHECK           25
+
+#define FLUX_CAP_COUNT 2
+#define COEFF_COUNT    6
+#define UNION_COUNT    2
+
+static constexpr kowhai_node_t settings_descriptor[] =
+{
+    { KOW_BRANCH_START,     SYM_SETTINGS,       1,                0 },
+
+    { KOW_BRANCH_START,     SYM_FLUXCAPACITOR,  FLUX_CAP_COUNT,   0 },
+    { KOW_UINT32,           SYM_GAIN,           1,                0 },
+    { KOW_FLOAT,            SYM_COEFFICIENT,    COEFF_COUNT,      0 },
+    { KOW_BRANCH_END,       SYM_FLUXCAPACITOR,  0,                0 },
+
+    { KOW_BRANCH_START,     SYM_OVEN,           1,                0 },
+    { KOW_INT16,            SYM_TEMP,           1,                0 },
+    { KOW_UINT16,           SYM_TIMEOUT,        1,                0 },
+    { KOW_BRANCH_END,       SYM_OVEN,           0,                0 },
+
+    { KOW_BRANCH_START,     SYM_UNIONCONTAINER, UNION_COUNT,      0 },
+    { KOW_BRANCH_U_START,   SYM_UNION,          UNION_COUNT,      0 },
+    { KOW_INT16,            SYM_TEMP,           1,                0 },
+    { KOW_UINT8,            SYM_BEEP,           1,                0 },
+    { KOW_BRANCH_END,       SYM_UNION,          0,                0 },
+    { KOW_UINT32,           SYM_CHECK,          1,                0 },
+    { KOW_BRANCH_END,       SYM_UNIONCONTAINER, 0,                0 },
+
+    { KOW_DOUBLE,           SYM_TEMP,           1,                0 },
+
+    { KOW_BRANCH_END,       SYM_SETTINGS,       0,                0 },
+};
+
+#pragma pack(1)
+
+struct flux_capacitor_t
+{
+    uint32_t gain;
+    float coefficient[COEFF_COUNT];
+};
+
+struct oven_t
+{
+    int16_t temp;
+    uint16_t timeout;
+};
+
+union union_t
+{
+    int16_t temp;
+    uint8_t beep;
+};
+
+struct union_container_t
+{
+    union union_t union_[UNION_COUNT];
+    uint32_t check;
+};
+
+struct settings_data_t
+{
+    struct flux_capacitor_t flux_capacitor[FLUX_CAP_COUNT];
+    struct oven_t oven;
+    struct union_container_t union_container[UNION_COUNT];
+    double temp;
+};
+
+#pragma pack()
+
+typedef kowhai::path<SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), SYM_GAIN> gain_path;
+typedef kowhai::path<SYM_SETTINGS, KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_COEFFICIENT, 3)> coefficient_path;
+typedef kowhai::path<SYM_SETTINGS, SYM_OVEN, SYM_TIMEOUT> timeout_path;
+typedef kowhai::path<SYM_SETTINGS, KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 1), KOWHAI_SYMBOL(SYM_UNION, 1), SYM_BEEP> beep_path;
+typedef kowhai::path<SYM_SETTINGS, KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 1), SYM_CHECK> check_path;
+typedef kowhai::path<SYM_SETTINGS, SYM_TEMP> temp_path;
+typedef kowhai::tree_view<settings_descriptor> settings_view;
+
+// paths are resolved at compile time
+static_assert(settings_view::offset_of<gain_path>() == offsetof(struct settings_data_t, flux_capacitor[1].gain), "gain offset");
+static_assert(settings_view::offset_of<coefficient_path>() == offsetof(struct settings_data_t, flux_capacitor[1].coefficient[3]), "coefficient offset");
+static_assert(settings_view::offset_of<timeout_path>() == offsetof(struct settings_data_t, oven.timeout), "timeout offset");
+static_assert(settings_view::offset_of<beep_path>() == offsetof(struct settings_data_t, union_container[1].union_[1].beep), "beep offset");
+static_assert(settings_view::offset_of<check_path>() == offsetof(struct settings_data_t, union_container[1].check), "check offset");
+static_assert(settings_view::offset_of<temp_path>() == offsetof(struct settings_data_t, temp), "temp offset");
+
+int main()
+{
+    struct settings_data_t settings;
+    struct kowhai_tree_t tree = {(struct kowhai_node_t*)settings_descriptor, &settings, NULL, NULL};
+    settings_view view(tree);
+    union kowhai_symbol_t gain_symbols[3];
+    struct kowhai_dirty_t dirty;
+    uint8_t dirty_bits[64];
+    struct kowhai_snapshot_t snapshot;
+    int16_t page_map[64];
+    uint8_t pool[4 * 16];
+    uint16_t timeout;
+    uint32_t gain;
+    int offset, size;
+
+    printf("test kowhai.hpp...\t\t\t");
+
+    gain_symbols[0].symbol = SYM_SETTINGS;
+    gain_symbols[1].symbol = KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1);
+    gain_symbols[2].symbol = SYM_GAIN;
+    memset(&settings, 0, sizeof(settings));
+    view.set<gain_path>(0x11223344);
+    assert(settings.flux_capacitor[1].gain == 0x11223344 && settings.flux_capacitor[0].gain == 0);
+    settings.flux_capacitor[1].coefficient[3] = 1.5f;
+    assert(view.get<coefficient_path>() == 1.5f);
+    view.set<timeout_path>(600);
+    assert(settings.oven.timeout == 600);
+    view.set<beep_path>(7);
+    assert(settings.union_container[1].union_[1].beep == 7);
+    view.set<temp_path>(21.5);
+    assert(view.get<temp_path>() == 21.5 && settings.temp == 21.5);
+
+    // the view reads the same data as the C library
+    assert(kowhai_read(&tree, 3, gain_symbols, 0, &gain, sizeof(gain)) == KOW_STATUS_OK);
+    assert(gain == view.get<gain_path>());
+
+    // writes through a view of a tree are marked in its dirty bitmap
+    assert(kowhai_dirty_init(&dirty, tree.desc, 8, dirty_bits, sizeof(dirty_bits)) == KOW_STATUS_OK);
+    tree.dirty = &dirty;
+    view.set<timeout_path>(601);
+    assert(kowhai_dirty_next(&dirty, 0, &offset, &size) == KOW_STATUS_OK);
+    assert(offset == offsetof(struct settings_data_t, oven.timeout) / 8 * 8 && offset + size >= (int)(offsetof(struct settings_data_t, oven.timeout) + 2));
+    tree.dirty = NULL;
+
+    // and preserve the pages of its snapshot first
+    assert(kowhai_snapshot_create(&snapshot, &tree, 16, page_map, sizeof(page_map) / sizeof(page_map[0]), pool, sizeof(pool)) == KOW_STATUS_OK);
+    view.set<timeout_path>(602);
+    assert(snapshot.pool_used == 1);
+    assert(kowhai_snapshot_read(&snapshot, offsetof(struct settings_data_t, oven.timeout), &timeout, sizeof(timeout)) == KOW_STATUS_OK && timeout == 601);
+    assert(view.get<timeout_path>() == 602);
+    kowhai_snapshot_release(&snapshot);
+
+    printf(" passed!\n");
+    return 0;
+}